@@ -0,0 +1,154 @@
+/**
+ * Benchmark for Processed Data Compression
+ * 
+ * Reports bytes on the wire against encode and decode cost for each compiled-in
+ * codec and level, for float32 and uint8 descriptors, on SIFT-like features.
+ * 
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "message_protocol.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace imaging;
+
+namespace {
+
+// Deterministic generator so runs are comparable
+uint32_t nextRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+// Keypoints in scan order with sub-pixel coordinates, and sparse
+// integer-valued descriptors like OpenCV's SIFT output
+void makeFeatures(size_t count, std::vector<KeyPoint>& keypoints,
+                  std::vector<float>& descriptors) {
+    uint32_t state = 12345;
+    keypoints.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        keypoints[i].x = static_cast<float>(nextRandom(state) % 4000000) / 1000.0f;
+        keypoints[i].y = static_cast<float>(nextRandom(state) % 3000000) / 1000.0f;
+        keypoints[i].size = 1.6f + static_cast<float>(nextRandom(state) % 2000) / 100.0f;
+        keypoints[i].angle = static_cast<float>(nextRandom(state) % 36000) / 100.0f;
+        keypoints[i].response = static_cast<float>(nextRandom(state) % 1000) / 20000.0f;
+        keypoints[i].octave = static_cast<int>(nextRandom(state) % 4) |
+                              static_cast<int>((nextRandom(state) % 3) << 8);
+    }
+    std::sort(keypoints.begin(), keypoints.end(), [](const KeyPoint& a, const KeyPoint& b) {
+        return a.y < b.y || (a.y == b.y && a.x < b.x);
+    });
+    
+    descriptors.resize(count * 128);
+    for (float& value : descriptors) {
+        uint32_t r = nextRandom(state);
+        value = (r % 3 == 0) ? 0.0f : static_cast<float>((r >> 4) % 160);
+    }
+}
+
+template <typename Fn>
+double timeMs(int iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t num_keypoints = argc > 1 ? std::stoul(argv[1]) : 5000;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 10;
+    
+    std::vector<KeyPoint> keypoints;
+    std::vector<float> descriptors;
+    makeFeatures(num_keypoints, keypoints, descriptors);
+    
+    // The image is carried as-is, so keep it out of the ratio
+    ImageMetadata metadata;
+    metadata.filename = "bench.png";
+    std::vector<uint8_t> image_data;
+    metadata.data_size = 0;
+    
+    std::cout << "Feature compression: " << num_keypoints << " keypoints x 128, "
+              << iterations << " iterations" << std::endl;
+    std::cout << "  " << std::left << std::setw(10) << "encoding" << std::setw(12) << "codec"
+              << std::right << std::setw(12) << "bytes" << std::setw(8) << "ratio"
+              << std::setw(12) << "encode ms" << std::setw(12) << "decode ms"
+              << std::setw(12) << "enc MB/s" << std::endl;
+    
+    struct Config {
+        CompressionCodec codec;
+        int level;
+    };
+    const Config configs[] = {
+        {CompressionCodec::NONE, -1},
+        {CompressionCodec::ZLIB, 1},
+        {CompressionCodec::ZLIB, 6},
+        {CompressionCodec::LZMA, 0},
+        {CompressionCodec::LZMA, 6},
+    };
+    const DescriptorEncoding encodings[] = {DescriptorEncoding::FLOAT32,
+                                            DescriptorEncoding::UINT8};
+    
+    std::vector<uint8_t> message;
+    std::vector<uint8_t> scratch;
+    std::vector<KeyPoint> decoded_keypoints;
+    std::vector<float> decoded_descriptors;
+    bool ok = true;
+    
+    for (DescriptorEncoding encoding : encodings) {
+        ProcessedDataOptions plain;
+        plain.descriptor_encoding = encoding;
+        size_t plain_size = MessageProtocol::processedDataSize(
+            metadata, 0, keypoints.size(), descriptors.size(), plain);
+        
+        for (const Config& config : configs) {
+            if (!compressionAvailable(config.codec)) {
+                continue;
+            }
+            ProcessedDataOptions options = plain;
+            options.compression = config.codec;
+            options.compression_level = config.level;
+            
+            double encode_ms = timeMs(iterations, [&] {
+                MessageProtocol::serializeProcessedDataInto(message, metadata, nullptr, 0,
+                                                            keypoints, descriptors, options);
+            });
+            double decode_ms = timeMs(iterations, [&] {
+                ProcessedDataView view;
+                ok = MessageProtocol::parseProcessedData(message.data(), message.size(),
+                                                         view, scratch) && ok;
+                MessageProtocol::decodeKeyPoints(view, decoded_keypoints);
+                MessageProtocol::decodeDescriptors(view, decoded_descriptors);
+            });
+            
+            std::string codec_name = compressionCodecName(config.codec);
+            if (config.codec != CompressionCodec::NONE) {
+                codec_name += "-" + std::to_string(config.level);
+            }
+            std::cout << "  " << std::left << std::setw(10) << descriptorEncodingName(encoding)
+                      << std::setw(12) << codec_name
+                      << std::right << std::setw(12) << message.size()
+                      << std::setw(8) << std::fixed << std::setprecision(2)
+                      << static_cast<double>(plain_size) / message.size()
+                      << std::setw(12) << std::setprecision(3) << encode_ms
+                      << std::setw(12) << decode_ms
+                      << std::setw(12) << std::setprecision(0)
+                      << plain_size / (encode_ms * 1000.0) << std::endl;
+            
+            ok = ok && decoded_keypoints.size() == keypoints.size() &&
+                 decoded_descriptors.size() == descriptors.size();
+        }
+    }
+    
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/**
+ * Benchmark for the Concurrency Primitives
+ *
+ * Compares the lock-free queues against a mutex-protected deque under
+ * contention, per-thread counters packed together against padded ones, and
+ * pooled image copies against fresh heap copies.
+ *
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "spsc_queue.h"
+#include "mpmc_queue.h"
+#include "buffer_pool.h"
+#include "padded_counter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace imaging;
+
+namespace {
+
+// The baseline: a deque behind one lock, with the same interface
+class MutexQueue {
+public:
+    explicit MutexQueue(size_t capacity) : capacity_(capacity) {}
+    
+    bool tryPush(uint64_t& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.size() == capacity_) {
+            return false;
+        }
+        items_.push_back(item);
+        return true;
+    }
+    
+    bool tryPop(uint64_t& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty()) {
+            return false;
+        }
+        item = items_.front();
+        items_.pop_front();
+        return true;
+    }
+    
+private:
+    size_t capacity_;
+    std::mutex mutex_;
+    std::deque<uint64_t> items_;
+};
+
+// Run each function on its own thread, started together; returns wall ms
+double runThreads(const std::vector<std::function<void()>>& functions) {
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (const auto& function : functions) {
+        threads.emplace_back([&go, &function]() {
+            while (!go.load(std::memory_order_acquire)) {
+            }
+            function();
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Pass items from producers to consumers; returns wall ms, or -1 if the
+// consumers' sum does not match what was sent
+template <typename Queue>
+double transfer(Queue& queue, unsigned producers, unsigned consumers, uint64_t items) {
+    uint64_t per_producer = items / producers;
+    uint64_t total = per_producer * producers;
+    std::atomic<uint64_t> received(0);
+    std::atomic<uint64_t> sum(0);
+    
+    std::vector<std::function<void()>> functions;
+    for (unsigned p = 0; p < producers; ++p) {
+        functions.push_back([&queue, per_producer]() {
+            for (uint64_t i = 1; i <= per_producer; ++i) {
+                uint64_t item = i;
+                while (!queue.tryPush(item)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (unsigned c = 0; c < consumers; ++c) {
+        functions.push_back([&queue, &received, &sum, total]() {
+            uint64_t local_sum = 0;
+            uint64_t item = 0;
+            while (received.load(std::memory_order_relaxed) < total) {
+                if (queue.tryPop(item)) {
+                    local_sum += item;
+                    received.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            sum.fetch_add(local_sum);
+        });
+    }
+    
+    double ms = runThreads(functions);
+    return sum.load() == producers * per_producer * (per_producer + 1) / 2 ? ms : -1.0;
+}
+
+// One counter per thread, each bumped only by its owner
+template <typename Counter>
+double countPerThread(Counter* counters, unsigned threads, uint64_t increments) {
+    std::vector<std::function<void()>> functions;
+    for (unsigned t = 0; t < threads; ++t) {
+        functions.push_back([&counters, t, increments]() {
+            for (uint64_t i = 0; i < increments; ++i) {
+                counters[t].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    return runThreads(functions);
+}
+
+// PaddedCounter with the std::atomic spelling countPerThread uses
+struct PaddedAdapter {
+    PaddedCounter counter;
+    void fetch_add(uint64_t amount, std::memory_order) { counter.add(amount); }
+};
+
+// Rate column: amount per microsecond, i.e. millions per second
+void printRow(const std::string& name, double ms, uint64_t amount) {
+    std::cout << "  " << std::left << std::setw(34) << name << std::right;
+    if (ms < 0) {
+        std::cout << std::setw(12) << "WRONG SUM" << std::endl;
+        return;
+    }
+    std::cout << std::setw(12) << std::fixed << std::setprecision(1) << ms
+              << std::setw(14) << std::setprecision(1) << amount / (ms * 1000.0) << std::endl;
+}
+
+void printHeader(const std::string& title, const std::string& rate = "Mops/s") {
+    std::cout << title << std::endl;
+    std::cout << "  " << std::left << std::setw(34) << "" << std::right << std::setw(12) << "ms"
+              << std::setw(14) << rate << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned threads = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) :
+                       std::max(2u, std::thread::hardware_concurrency() / 2);
+    uint64_t items = argc > 2 ? std::stoull(argv[2]) : 2000000;
+    size_t image_mb = argc > 3 ? std::stoul(argv[3]) : 8;
+    bool ok = true;
+    
+    // The extractor's queues hold a few frames; use a similarly small bound
+    const size_t capacity = 64;
+    
+    printHeader("Queue, 1 producer -> 1 consumer, " + std::to_string(items) + " items");
+    {
+        SpscQueue<uint64_t> spsc(capacity);
+        MpmcQueue<uint64_t> mpmc(capacity);
+        MutexQueue locked(capacity);
+        double spsc_ms = transfer(spsc, 1, 1, items);
+        double mpmc_ms = transfer(mpmc, 1, 1, items);
+        double locked_ms = transfer(locked, 1, 1, items);
+        printRow("SpscQueue", spsc_ms, items);
+        printRow("MpmcQueue", mpmc_ms, items);
+        printRow("mutex + deque", locked_ms, items);
+        ok = ok && spsc_ms >= 0 && mpmc_ms >= 0 && locked_ms >= 0;
+    }
+    
+    printHeader("Queue, " + std::to_string(threads) + " producers -> " + std::to_string(threads) +
+                " consumers, " + std::to_string(items) + " items");
+    {
+        MpmcQueue<uint64_t> mpmc(capacity);
+        MutexQueue locked(capacity);
+        double mpmc_ms = transfer(mpmc, threads, threads, items);
+        double locked_ms = transfer(locked, threads, threads, items);
+        printRow("MpmcQueue", mpmc_ms, items);
+        printRow("mutex + deque", locked_ms, items);
+        ok = ok && mpmc_ms >= 0 && locked_ms >= 0;
+    }
+    
+    // Per-stage statistics are the typical case: one counter per thread,
+    // declared side by side
+    uint64_t increments = items * 5;
+    printHeader("Counters, " + std::to_string(threads * 2) + " threads x " +
+                std::to_string(increments) + " increments each");
+    {
+        std::vector<std::atomic<uint64_t>> packed(threads * 2);
+        std::vector<PaddedAdapter> padded(threads * 2);
+        printRow("adjacent std::atomic", countPerThread(packed.data(), threads * 2, increments),
+                 increments * threads * 2);
+        printRow("PaddedCounter", countPerThread(padded.data(), threads * 2, increments),
+                 increments * threads * 2);
+    }
+    
+    // What ImageReceiver::detach does for frames read from shared memory
+    size_t image_size = image_mb * 1024 * 1024;
+    int copies = 200;
+    printHeader("Image copies, " + std::to_string(image_mb) + " MB x " + std::to_string(copies),
+                "GB/s");
+    {
+        std::vector<uint8_t> image(image_size, 0x5a);
+        BufferPool pool(image_size, 4);
+        double heap_ms = runThreads({[&]() {
+            for (int i = 0; i < copies; ++i) {
+                SharedBuffer copy(std::vector<uint8_t>(image.begin(), image.end()));
+                ok = ok && copy.data()[image_size - 1] == 0x5a;
+            }
+        }});
+        double pool_ms = runThreads({[&]() {
+            for (int i = 0; i < copies; ++i) {
+                SharedBuffer copy = pool.copy(image.data(), image.size());
+                ok = ok && copy.data()[image_size - 1] == 0x5a;
+            }
+        }});
+        uint64_t kilobytes = static_cast<uint64_t>(copies) * image_size / 1000;
+        printRow("heap (new vector each time)", heap_ms, kilobytes);
+        printRow("BufferPool", pool_ms, kilobytes);
+        ok = ok && pool.allocated() == 1 && pool.misses() == 0;
+    }
+    
+    return ok ? 0 : 1;
+}
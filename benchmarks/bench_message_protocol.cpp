@@ -0,0 +1,203 @@
+/**
+ * Microbenchmark for Message Protocol Encoding
+ * 
+ * Compares the original per-field big-endian encoding of keypoints and
+ * descriptors with the bulk native-order and byte-swapped encodings, and with
+ * serialization into a reused buffer.
+ * 
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "message_protocol.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace imaging;
+
+namespace {
+
+// Per-field encoding as used before the bulk array format
+void legacyWriteUint32(std::vector<uint8_t>& buffer, uint32_t value) {
+    buffer.push_back((value >> 24) & 0xFF);
+    buffer.push_back((value >> 16) & 0xFF);
+    buffer.push_back((value >> 8) & 0xFF);
+    buffer.push_back(value & 0xFF);
+}
+
+void legacyWriteFloat(std::vector<uint8_t>& buffer, float value) {
+    uint32_t temp;
+    std::memcpy(&temp, &value, sizeof(float));
+    legacyWriteUint32(buffer, temp);
+}
+
+uint32_t legacyReadUint32(const uint8_t* data, size_t& offset) {
+    uint32_t value = (static_cast<uint32_t>(data[offset]) << 24) |
+                     (static_cast<uint32_t>(data[offset + 1]) << 16) |
+                     (static_cast<uint32_t>(data[offset + 2]) << 8) |
+                     static_cast<uint32_t>(data[offset + 3]);
+    offset += 4;
+    return value;
+}
+
+float legacyReadFloat(const uint8_t* data, size_t& offset) {
+    uint32_t temp = legacyReadUint32(data, offset);
+    float value;
+    std::memcpy(&value, &temp, sizeof(float));
+    return value;
+}
+
+std::vector<uint8_t> legacyEncode(const std::vector<KeyPoint>& keypoints,
+                                  const std::vector<float>& descriptors) {
+    std::vector<uint8_t> buffer;
+    legacyWriteUint32(buffer, static_cast<uint32_t>(keypoints.size()));
+    for (const auto& kp : keypoints) {
+        legacyWriteFloat(buffer, kp.x);
+        legacyWriteFloat(buffer, kp.y);
+        legacyWriteFloat(buffer, kp.size);
+        legacyWriteFloat(buffer, kp.angle);
+        legacyWriteFloat(buffer, kp.response);
+        legacyWriteUint32(buffer, static_cast<uint32_t>(kp.octave));
+    }
+    legacyWriteUint32(buffer, static_cast<uint32_t>(descriptors.size()));
+    for (float desc : descriptors) {
+        legacyWriteFloat(buffer, desc);
+    }
+    return buffer;
+}
+
+bool legacyDecode(const std::vector<uint8_t>& message, std::vector<KeyPoint>& keypoints,
+                  std::vector<float>& descriptors) {
+    size_t offset = 0;
+    uint32_t num_keypoints = legacyReadUint32(message.data(), offset);
+    keypoints.clear();
+    keypoints.reserve(num_keypoints);
+    for (uint32_t i = 0; i < num_keypoints; ++i) {
+        if (offset + 24 > message.size()) {
+            return false;
+        }
+        KeyPoint kp;
+        kp.x = legacyReadFloat(message.data(), offset);
+        kp.y = legacyReadFloat(message.data(), offset);
+        kp.size = legacyReadFloat(message.data(), offset);
+        kp.angle = legacyReadFloat(message.data(), offset);
+        kp.response = legacyReadFloat(message.data(), offset);
+        kp.octave = static_cast<int>(legacyReadUint32(message.data(), offset));
+        keypoints.push_back(kp);
+    }
+    uint32_t num_descriptors = legacyReadUint32(message.data(), offset);
+    descriptors.clear();
+    descriptors.reserve(num_descriptors);
+    for (uint32_t i = 0; i < num_descriptors; ++i) {
+        if (offset + 4 > message.size()) {
+            return false;
+        }
+        descriptors.push_back(legacyReadFloat(message.data(), offset));
+    }
+    return true;
+}
+
+template <typename Fn>
+double timeMs(int iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+void report(const std::string& name, double ms, double baseline_ms) {
+    std::cout << "  " << std::left << std::setw(28) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(3) << ms << " ms"
+              << std::setw(10) << std::setprecision(1) << baseline_ms / ms << "x" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t num_keypoints = argc > 1 ? std::stoul(argv[1]) : 5000;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 50;
+    
+    std::vector<KeyPoint> keypoints(num_keypoints);
+    for (size_t i = 0; i < num_keypoints; ++i) {
+        keypoints[i].x = static_cast<float>(i % 4000);
+        keypoints[i].y = static_cast<float>(i / 4000);
+        keypoints[i].size = 3.5f;
+        keypoints[i].angle = 90.0f;
+        keypoints[i].response = 0.01f;
+        keypoints[i].octave = static_cast<int>(i % 8);
+    }
+    std::vector<float> descriptors(num_keypoints * 128);
+    for (size_t i = 0; i < descriptors.size(); ++i) {
+        descriptors[i] = static_cast<float>(i % 256);
+    }
+    
+    ImageMetadata metadata;
+    metadata.filename = "bench.png";
+    std::vector<uint8_t> image_data(1024, 0);
+    metadata.data_size = image_data.size();
+    
+    ProcessedDataOptions swapped;
+    swapped.byte_order = nativeByteOrder() == ByteOrder::LITTLE_ENDIAN_ORDER ?
+                         ByteOrder::BIG_ENDIAN_ORDER : ByteOrder::LITTLE_ENDIAN_ORDER;
+    
+    std::vector<uint8_t> legacy_message = legacyEncode(keypoints, descriptors);
+    std::vector<uint8_t> native_message = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors);
+    std::vector<uint8_t> swapped_message = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors, swapped);
+    
+    std::cout << "Processed data encoding: " << num_keypoints << " keypoints x 128 floats ("
+              << native_message.size() / 1024 << " KB), " << iterations << " iterations"
+              << std::endl;
+    
+    std::cout << "Encode:" << std::endl;
+    double legacy_encode = timeMs(iterations, [&] {
+        legacy_message = legacyEncode(keypoints, descriptors);
+    });
+    double native_encode = timeMs(iterations, [&] {
+        native_message = MessageProtocol::serializeProcessedData(
+            metadata, image_data, keypoints, descriptors);
+    });
+    double swapped_encode = timeMs(iterations, [&] {
+        swapped_message = MessageProtocol::serializeProcessedData(
+            metadata, image_data, keypoints, descriptors, swapped);
+    });
+    std::vector<uint8_t> reused_buffer;
+    double reused_encode = timeMs(iterations, [&] {
+        MessageProtocol::serializeProcessedDataInto(reused_buffer, metadata, image_data.data(),
+                                                    image_data.size(), keypoints, descriptors);
+    });
+    report("per-field big-endian", legacy_encode, legacy_encode);
+    report("bulk native (memcpy)", native_encode, legacy_encode);
+    report("bulk byte-swapped (SIMD)", swapped_encode, legacy_encode);
+    report("bulk native, reused buffer", reused_encode, legacy_encode);
+    
+    std::cout << "Decode:" << std::endl;
+    std::vector<KeyPoint> decoded_keypoints;
+    std::vector<float> decoded_descriptors;
+    ImageMetadata decoded_metadata;
+    std::vector<uint8_t> decoded_image;
+    
+    double legacy_decode = timeMs(iterations, [&] {
+        legacyDecode(legacy_message, decoded_keypoints, decoded_descriptors);
+    });
+    double native_decode = timeMs(iterations, [&] {
+        MessageProtocol::deserializeProcessedData(native_message, decoded_metadata, decoded_image,
+                                                  decoded_keypoints, decoded_descriptors);
+    });
+    double swapped_decode = timeMs(iterations, [&] {
+        MessageProtocol::deserializeProcessedData(swapped_message, decoded_metadata, decoded_image,
+                                                  decoded_keypoints, decoded_descriptors);
+    });
+    report("per-field big-endian", legacy_decode, legacy_decode);
+    report("bulk native (memcpy)", native_decode, legacy_decode);
+    report("bulk byte-swapped (SIMD)", swapped_decode, legacy_decode);
+    
+    return decoded_descriptors.size() == descriptors.size() ? 0 : 1;
+}
@@ -68,10 +68,20 @@ echo "Executables are located in: build/"
 echo "  - image_generator"
 echo "  - feature_extractor"
 echo "  - data_logger"
+echo "  - pipeline_tap"
 echo ""
 echo "Test executables:"
 echo "  - test_message_protocol"
 echo "  - test_database"
+echo "  - test_image_probe"
+echo "  - test_image_index"
+echo "  - test_rate_controller"
+echo "  - test_pipeline_tap"
+echo "  - test_flow_control"
+echo "  - test_staged_pipeline"
+echo "  - test_concurrency"
+echo "  - test_sift_tiling"
+echo "  - test_synthetic_source"
 echo ""
 echo "To run the applications, see run_all.sh or run them individually."
 echo "To run tests manually: cd build && ctest --output-on-failure"
@@ -0,0 +1,91 @@
+/*
+ * Buffer Pool Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "mpmc_queue.h"
+#include "padded_counter.h"
+#include "shared_buffer.h"
+
+namespace imaging {
+
+// Up to count buffers of buffer_size bytes, allocated on first use and
+// recycled afterwards, so large per-frame copies stop going through the
+// allocator (and the kernel, for sizes malloc maps). Buffers are
+// reference-counted and return to the pool from whichever thread drops the
+// last reference; they keep the pool's storage alive, so they may outlive
+// the BufferPool object itself.
+class BufferPool {
+public:
+    BufferPool(size_t buffer_size, size_t count)
+        : state_(std::make_shared<State>(buffer_size, count)) {}
+    
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    
+    // A writable buffer of bufferSize() bytes, or null when all are in use
+    // (or being returned at that moment)
+    std::shared_ptr<uint8_t> acquire() {
+        std::unique_ptr<uint8_t[]> buffer;
+        if (!state_->free.tryPop(buffer)) {
+            if (!state_->allocated.incrementBelow(state_->count)) {
+                return nullptr;
+            }
+            buffer.reset(new uint8_t[state_->buffer_size]);
+        }
+        std::shared_ptr<State> state = state_;
+        return std::shared_ptr<uint8_t>(buffer.release(), [state](uint8_t* data) {
+            // The queue holds every buffer, so a push only fails while a
+            // consumer is still taking the previous item out of the cell
+            std::unique_ptr<uint8_t[]> returned(data);
+            while (!state->free.tryPush(returned)) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    
+    // Copy bytes into a pooled buffer, or into the heap when they do not
+    // fit or every buffer is in use
+    SharedBuffer copy(const uint8_t* data, size_t size) {
+        std::shared_ptr<uint8_t> buffer = size <= state_->buffer_size ? acquire() : nullptr;
+        if (!buffer) {
+            state_->misses.add();
+            return SharedBuffer(std::vector<uint8_t>(data, data + size));
+        }
+        std::memcpy(buffer.get(), data, size);
+        const uint8_t* bytes = buffer.get();
+        return SharedBuffer(std::move(buffer), bytes, size);
+    }
+    
+    size_t bufferSize() const { return state_->buffer_size; }
+    size_t count() const { return state_->count; }
+    
+    // Buffers allocated so far, and copies that had to use the heap
+    uint64_t allocated() const { return state_->allocated.get(); }
+    uint64_t misses() const { return state_->misses.get(); }
+    
+private:
+    struct State {
+        size_t buffer_size;
+        size_t count;
+        MpmcQueue<std::unique_ptr<uint8_t[]>> free;
+        PaddedCounter allocated;
+        PaddedCounter misses;
+        
+        State(size_t size, size_t buffers) : buffer_size(size), count(buffers), free(buffers) {}
+    };
+    
+    std::shared_ptr<State> state_;
+};
+
+} // namespace imaging
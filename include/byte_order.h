@@ -0,0 +1,30 @@
+/*
+ * Byte Order Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace imaging {
+
+enum class ByteOrder : uint8_t {
+    LITTLE_ENDIAN_ORDER = 0,
+    BIG_ENDIAN_ORDER = 1
+};
+
+// Byte order of the machine we are running on
+ByteOrder nativeByteOrder();
+
+// Reverse the bytes of each 32-bit word while copying count words from src to
+// dst (src == dst is allowed). Uses SSSE3/SSE2 or NEON where available.
+void byteSwap32(uint8_t* dst, const uint8_t* src, size_t count);
+
+// Same for 16-bit words
+void byteSwap16(uint8_t* dst, const uint8_t* src, size_t count);
+
+} // namespace imaging
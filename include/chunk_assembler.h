@@ -0,0 +1,59 @@
+/*
+ * Chunk Assembler Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "message_protocol.h"
+
+namespace imaging {
+
+// Reassembles images streamed as IMAGE_CHUNK messages. One transfer is held at
+// a time in a buffer that keeps its capacity between images, so memory is
+// bounded by the largest accepted image. Chunks must arrive in order; a gap,
+// a new transfer id or an oversized image abandons the current transfer.
+class ChunkAssembler {
+public:
+    enum class Result {
+        INCOMPLETE,  // Chunk accepted, more to come
+        COMPLETE,    // Image is ready in data()/size()
+        DROPPED      // Chunk did not fit the current transfer and was discarded
+    };
+    
+    explicit ChunkAssembler(size_t max_image_size = 1024u * 1024u * 1024u);
+    
+    // Add the next chunk. After COMPLETE the image stays valid until the next
+    // call that starts a new transfer.
+    Result addChunk(const ImageChunkHeader& header, const uint8_t* data, size_t size);
+    
+    const ImageMetadata& metadata() const { return metadata_; }
+    const uint8_t* data() const { return buffer_.data(); }
+    size_t size() const { return received_; }
+    
+    // Transfers that were started but could not be completed
+    uint64_t droppedTransfers() const { return dropped_transfers_; }
+    
+    // Abandon the current transfer, if any
+    void reset();
+
+private:
+    size_t max_image_size_;
+    std::vector<uint8_t> buffer_;
+    ImageMetadata metadata_;
+    bool active_;
+    uint32_t transfer_id_;
+    uint32_t chunk_count_;
+    uint32_t next_index_;
+    size_t received_;
+    uint64_t dropped_transfers_;
+    
+    Result abandon();
+};
+
+} // namespace imaging
@@ -0,0 +1,39 @@
+/*
+ * Command Line Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace imaging {
+
+// Minimal argument parser shared by the applications. Plain arguments are
+// positional; "--name=value" and bare "--name" are options.
+class CommandLine {
+public:
+    CommandLine(int argc, char* argv[]);
+    
+    // Positional argument at index, or fallback if not given
+    std::string positional(size_t index, const std::string& fallback) const;
+    
+    // True if "--name" or "--name=..." was given
+    bool hasOption(const std::string& name) const;
+    
+    // Option values, or fallback if the option is missing or malformed
+    std::string option(const std::string& name, const std::string& fallback) const;
+    int64_t optionInt(const std::string& name, int64_t fallback) const;
+    double optionDouble(const std::string& name, double fallback) const;
+
+private:
+    std::vector<std::string> positional_;
+    std::map<std::string, std::string> options_;
+};
+
+} // namespace imaging
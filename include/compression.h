@@ -0,0 +1,49 @@
+/*
+ * Compression Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace imaging {
+
+// General-purpose codecs for the keypoint and descriptor sections of processed
+// data messages. Which codecs exist depends on the libraries found at build time.
+enum class CompressionCodec : uint8_t {
+    NONE = 0,
+    ZLIB = 1,
+    LZMA = 2
+};
+
+// "none", "zlib" or "lzma"
+std::string compressionCodecName(CompressionCodec codec);
+bool parseCompressionCodec(const std::string& name, CompressionCodec& codec);
+
+// True if the codec was compiled in
+bool compressionAvailable(CompressionCodec codec);
+
+// Worst-case compressed size for size input bytes
+size_t compressionBound(CompressionCodec codec, size_t size);
+
+// Compress size bytes into dst (capacity from compressionBound). level < 0
+// selects the codec default. Returns the compressed size, or 0 on failure.
+size_t compressBytes(CompressionCodec codec, int level, const uint8_t* src, size_t size,
+                     uint8_t* dst, size_t capacity);
+
+// Decompress into dst, which must hold exactly raw_size bytes
+bool decompressBytes(CompressionCodec codec, const uint8_t* src, size_t size,
+                     uint8_t* dst, size_t raw_size);
+
+// Byte-plane shuffle: gathers byte k of every element_size-byte element so that
+// slowly varying high bytes of floats end up next to each other
+void shuffleBytes(const uint8_t* src, uint8_t* dst, size_t count, size_t element_size);
+void unshuffleBytes(const uint8_t* src, uint8_t* dst, size_t count, size_t element_size);
+
+} // namespace imaging
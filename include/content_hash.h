@@ -0,0 +1,19 @@
+/*
+ * Content Hash Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace imaging {
+
+// 64-bit XXH64 hash of a byte range. Fast enough (several GB/s) to fingerprint
+// every image so that messages can refer to images by content.
+uint64_t contentHash(const uint8_t* data, size_t size, uint64_t seed = 0);
+
+} // namespace imaging
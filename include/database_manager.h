@@ -27,6 +27,12 @@ public:
                            const std::vector<KeyPoint>& keypoints,
                            const std::vector<float>& descriptors);
     
+    // Store processed data referenced by a message view. The image blob (and the
+    // descriptor blob, when it is in native byte order) is bound straight from
+    // the received message without an intermediate copy. Quantized descriptors
+    // are stored in their wire encoding.
+    bool storeProcessedData(const ProcessedDataView& view);
+    
     // Get statistics
     int64_t getTotalImagesStored();
     int64_t getTotalKeypointsStored();
@@ -35,9 +41,25 @@ private:
     std::string db_path_;
     sqlite3* db_;
     
+    // Scratch space reused across frames when decoding views
+    std::vector<KeyPoint> keypoint_scratch_;
+    std::vector<uint8_t> descriptor_scratch_;
+    
     // Create database schema
     bool createTables();
     
+    // Add columns introduced after the first schema version
+    bool migrateSchema();
+    bool hasColumn(const std::string& table, const std::string& column);
+    
+    // Insert one frame inside a transaction. Descriptors are stored as an
+    // encoded native-order blob together with their encoding.
+    bool storeFrame(const ImageMetadata& metadata,
+                    const uint8_t* image_data, size_t image_size,
+                    const std::vector<KeyPoint>& keypoints,
+                    const void* descriptor_data, size_t descriptor_bytes,
+                    DescriptorEncoding descriptor_encoding);
+    
     // Helper to execute SQL
     bool executeSql(const std::string& sql);
 };
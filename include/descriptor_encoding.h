@@ -0,0 +1,45 @@
+/*
+ * Descriptor Encoding Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "byte_order.h"
+
+namespace imaging {
+
+// Element type used to carry SIFT descriptors on the wire and in the database.
+// OpenCV's SIFT values lie in 0..255, so UINT8 is lossless up to rounding and a
+// quarter of the FLOAT32 size.
+enum class DescriptorEncoding : uint8_t {
+    FLOAT32 = 0,
+    UINT8 = 1,
+    FLOAT16 = 2
+};
+
+// Bytes per descriptor element
+size_t descriptorElementSize(DescriptorEncoding encoding);
+
+// "float32", "uint8" or "float16"
+std::string descriptorEncodingName(DescriptorEncoding encoding);
+bool parseDescriptorEncoding(const std::string& name, DescriptorEncoding& encoding);
+
+// Encode count floats into dst in native byte order
+// (dst must hold count * descriptorElementSize(encoding) bytes)
+void encodeDescriptors(const float* src, size_t count, DescriptorEncoding encoding, uint8_t* dst);
+
+// Decode count elements stored in the given byte order back to floats
+void decodeDescriptors(const uint8_t* src, size_t count, DescriptorEncoding encoding,
+                       ByteOrder order, float* dst);
+
+// IEEE 754 half precision conversion (round to nearest even)
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+} // namespace imaging
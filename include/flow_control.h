@@ -0,0 +1,185 @@
+/*
+ * Flow Control Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "message_protocol.h"
+
+namespace imaging {
+
+// Credit-based flow control between pipeline stages. Each downstream stage
+// advertises how many messages it has consumed and how many more it can take
+// in heartbeats sent back over a PUSH/PULL side channel; the upstream stage
+// sends only while every live downstream stage has credit left, so messages
+// wait (or are dropped by policy) at the sender instead of being discarded by
+// ZeroMQ at the high water mark.
+
+// Which waiting message to give up when credits run out and the queue is full
+enum class DropPolicy {
+    OLDEST,     // Keep the most recent messages
+    NEWEST,     // Keep the messages already waiting
+    EVERY_NTH   // Admit one in N arriving messages, spreading the losses out
+};
+
+// "oldest", "newest" or "every-nth"
+std::string dropPolicyName(DropPolicy policy);
+bool parseDropPolicy(const std::string& name, DropPolicy& policy);
+
+// Upstream view of the credit granted by downstream stages. Stages are told
+// apart by name; one that has not been heard from for stale_after is
+// forgotten, so a stage that died does not stall the pipeline. With no live
+// stage, sending is not limited. A stage that has had no credit and made no
+// progress for stale_after while still heartbeating is assumed to have lost
+// messages in transit (a reconnect, a message it could not parse), and its
+// credit is counted again from what it reports.
+class CreditGate {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    explicit CreditGate(std::chrono::milliseconds stale_after = std::chrono::milliseconds(2000));
+    
+    // Apply a grant received from a downstream stage (window 0 is ignored)
+    void grant(const CreditGrant& grant, Clock::time_point now);
+    
+    // Messages that may be sent now: the smallest credit of any live stage
+    uint64_t available(Clock::time_point now);
+    
+    // Account for one message sent
+    void sent() { sent_++; }
+    
+    // Number of stages currently limiting the sender
+    size_t stageCount(Clock::time_point now);
+    
+private:
+    struct Stage {
+        int64_t offset;     // Messages sent before the stage started counting
+        uint64_t consumed;
+        uint64_t limit;     // Sent count this stage allows
+        Clock::time_point last_seen;
+        Clock::time_point last_progress;  // Last time it had credit or consumed more
+    };
+    
+    void expire(Clock::time_point now);
+    
+    std::chrono::milliseconds stale_after_;
+    uint64_t sent_;
+    std::map<std::string, Stage> stages_;
+};
+
+// Bounded queue of messages waiting for credit. Pushing into a full queue
+// drops one message according to the policy.
+template <typename T>
+class DropQueue {
+public:
+    DropQueue(size_t capacity, DropPolicy policy, size_t nth = 2)
+        : capacity_(capacity > 0 ? capacity : 1), policy_(policy),
+          nth_(nth > 0 ? nth : 1), overflows_(0), dropped_(0) {}
+    
+    // Returns false if a message was dropped to make room or item was refused
+    bool push(T&& item) {
+        if (items_.size() < capacity_) {
+            overflows_ = 0;
+            items_.push_back(std::move(item));
+            return true;
+        }
+        
+        dropped_++;
+        bool admit = policy_ == DropPolicy::OLDEST ||
+                     (policy_ == DropPolicy::EVERY_NTH && ++overflows_ % nth_ == 0);
+        if (admit) {
+            items_.pop_front();
+            items_.push_back(std::move(item));
+        }
+        return false;
+    }
+    
+    bool empty() const { return items_.empty(); }
+    size_t size() const { return items_.size(); }
+    T& front() { return items_.front(); }
+    void pop() { items_.pop_front(); }
+    
+    uint64_t dropped() const { return dropped_; }
+    
+private:
+    size_t capacity_;
+    DropPolicy policy_;
+    size_t nth_;
+    uint64_t overflows_;  // Arrivals into a full queue since it last had room
+    uint64_t dropped_;
+    std::deque<T> items_;
+};
+
+// Upstream end of the side channel: a PULL socket the downstream stages
+// connect to, feeding the grants it receives into a gate
+class CreditListener {
+public:
+    CreditListener();
+    ~CreditListener();
+    
+    CreditListener(const CreditListener&) = delete;
+    CreditListener& operator=(const CreditListener&) = delete;
+    
+    bool open(void* context, const std::string& endpoint);
+    void close();
+    bool isOpen() const { return socket_ != nullptr; }
+    
+    // Wait up to timeout for grants, then apply every grant already queued
+    void poll(CreditGate& gate, std::chrono::milliseconds timeout);
+    
+    // Poll until the gate has credit or timeout expires. Returns true if a
+    // message may be sent.
+    bool waitForCredit(CreditGate& gate, std::chrono::milliseconds timeout);
+    
+private:
+    void* socket_;
+};
+
+// Downstream end of the side channel. A background thread owns the PUSH
+// socket and sends a grant whenever the consumed count changes and at least
+// every heartbeat interval, so the stage stays live while it is busy.
+class CreditAdvertiser {
+public:
+    CreditAdvertiser();
+    ~CreditAdvertiser();
+    
+    CreditAdvertiser(const CreditAdvertiser&) = delete;
+    CreditAdvertiser& operator=(const CreditAdvertiser&) = delete;
+    
+    // Connect to the upstream listener and start advertising window messages
+    // of capacity. The stage name is made unique to this process.
+    bool open(void* context, const std::string& endpoint, const std::string& stage,
+              uint32_t window);
+    void close();
+    
+    // Account for messages taken off the input
+    void consumed(uint64_t count = 1);
+    
+private:
+    static constexpr std::chrono::milliseconds kHeartbeatInterval{200};
+    
+    void run();
+    
+    void* socket_;
+    CreditGrant grant_;
+    uint64_t consumed_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool stopping_;
+    std::thread thread_;
+};
+
+} // namespace imaging
@@ -0,0 +1,65 @@
+/*
+ * Image Cache Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "shared_buffer.h"
+
+namespace imaging {
+
+// Encoded image files kept in memory between passes over the dataset, keyed
+// by path. Buffers are shared, so a cached image can be handed to ZeroMQ
+// without copying and stays valid while queued even if it is evicted.
+// Least recently used images are evicted once the byte budget is exceeded;
+// for looping playback the budget should exceed the dataset size. Safe to use
+// from several threads.
+class ImageCache {
+public:
+    explicit ImageCache(size_t max_bytes = 0);
+    
+    // Change the budget, evicting images as needed; 0 disables the cache
+    void setMaxBytes(size_t max_bytes);
+    size_t maxBytes() const;
+    
+    // True if an image of this size could be cached
+    bool fits(size_t size) const;
+    
+    // Cached image for key, marked as most recently used
+    bool find(const std::string& key, SharedBuffer& image);
+    
+    // Store or replace an image; ignored if it does not fit
+    void insert(const std::string& key, const SharedBuffer& image);
+    
+    size_t imageCount() const;
+    size_t bytes() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+    
+private:
+    struct Entry {
+        SharedBuffer image;
+        std::list<std::string>::iterator position;
+    };
+    
+    void evict();
+    
+    mutable std::mutex mutex_;
+    size_t max_bytes_;
+    size_t bytes_;
+    uint64_t hits_;
+    uint64_t misses_;
+    std::unordered_map<std::string, Entry> images_;
+    std::list<std::string> order_;  // Least recently used first
+};
+
+} // namespace imaging
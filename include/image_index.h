@@ -0,0 +1,71 @@
+/*
+ * Image Index Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace imaging {
+
+struct ImageIndexEntry {
+    std::string path;       // Full path; the index file stores it relative to the directory
+    uint64_t size;
+    int64_t mtime;          // Modification time in nanoseconds since the epoch
+    uint32_t width;         // 0 if the header could not be probed
+    uint32_t height;
+    uint32_t channels;
+    uint64_t content_hash;  // contentHash() of the whole file
+    int64_t timestamp;      // Capture time from a manifest in ns, 0 if unknown (not stored)
+    
+    ImageIndexEntry()
+        : size(0), mtime(0), width(0), height(0), channels(0), content_hash(0), timestamp(0) {}
+};
+
+// Fill in entry.size and entry.mtime from the file at entry.path
+bool statImageFile(ImageIndexEntry& entry);
+
+// Image files of a dataset directory with their metadata, persisted in an
+// index file inside the directory so a restart only has to look at files that
+// were added or changed since the last run.
+class ImageIndex {
+public:
+    // With recursive, images in subdirectories are indexed too
+    explicit ImageIndex(const std::string& directory, bool recursive = false);
+    
+    // Read the index file. Returns false if it is missing or unusable, in
+    // which case the next refresh() scans every file.
+    bool load();
+    
+    // Write the index file (atomically, via rename)
+    bool save() const;
+    
+    // List the directory and probe and hash new or modified files on threads
+    // worker threads (0 = one per core). Entries are sorted by path.
+    bool refresh(unsigned threads = 0);
+    
+    const std::vector<ImageIndexEntry>& entries() const { return entries_; }
+    const std::string& indexPath() const { return index_path_; }
+    
+    // Files reused from the index and files scanned by the last refresh()
+    size_t reusedCount() const { return reused_; }
+    size_t scannedCount() const { return scanned_; }
+    
+    // Extensions the generator publishes (lower case, with the dot)
+    static bool isImageFile(const std::string& path);
+    
+private:
+    std::string directory_;
+    bool recursive_;
+    std::string index_path_;
+    std::vector<ImageIndexEntry> entries_;
+    size_t reused_;
+    size_t scanned_;
+};
+
+} // namespace imaging
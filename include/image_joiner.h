@@ -0,0 +1,46 @@
+/*
+ * Image Joiner Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include "shared_buffer.h"
+
+namespace imaging {
+
+// Keeps recently published images, keyed by content hash, so processed data
+// that refers to its image by hash can be joined with the image bytes.
+// Least recently added images are evicted once the byte budget is exceeded.
+class ImageJoiner {
+public:
+    explicit ImageJoiner(size_t max_bytes = 512 * 1024 * 1024);
+    
+    // Store an image (shared, not copied); returns its content hash
+    uint64_t addImage(SharedBuffer image_data);
+    
+    // Image with this hash, or nullptr if it has not arrived or was evicted
+    const SharedBuffer* find(uint64_t hash) const;
+    
+    size_t imageCount() const { return images_.size(); }
+    size_t bytes() const { return bytes_; }
+    
+private:
+    struct Entry {
+        SharedBuffer data;
+        std::list<uint64_t>::iterator position;
+    };
+    
+    size_t max_bytes_;
+    size_t bytes_;
+    std::unordered_map<uint64_t, Entry> images_;
+    std::list<uint64_t> order_;  // Oldest first
+};
+
+} // namespace imaging
@@ -0,0 +1,115 @@
+/*
+ * Image Prefetcher Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "image_cache.h"
+#include "image_source.h"
+#include "shared_buffer.h"
+
+namespace imaging {
+
+struct PrefetchedImage {
+    ImageIndexEntry entry;
+    size_t position;     // Position in the current pass over the source
+    SharedBuffer image;
+    bool loaded;         // False if the file could not be mapped or read
+    
+    PrefetchedImage() : position(0), loaded(false) {}
+};
+
+// Loads images in playback order (looping over the source, which is rewound
+// after each pass) up to depth images ahead of the consumer, so disk latency
+// is paid in the background instead of on the publishing thread. Uses
+// io_uring when built with liburing and the kernel allows it, otherwise a
+// small thread pool mapping files and faulting their pages in. Loaded images
+// are added to the cache, and cached images are not read again. Images a
+// source generates in memory are passed through as they are.
+class ImagePrefetcher {
+public:
+    // Images larger than max_read_size are only mapped, never read into the
+    // heap, so they can still be streamed from disk if mapping fails
+    ImagePrefetcher(ImageSource& source, ImageCache& cache, size_t depth, size_t max_read_size);
+    ~ImagePrefetcher();
+    
+    ImagePrefetcher(const ImagePrefetcher&) = delete;
+    ImagePrefetcher& operator=(const ImagePrefetcher&) = delete;
+    
+    // Start loading at the source's current position
+    void start();
+    void stop();
+    
+    // Next image in playback order. Returns false if it is not loaded within
+    // timeout, the prefetcher is stopped or the source ran out of images.
+    bool next(PrefetchedImage& image, std::chrono::milliseconds timeout);
+    
+    // True once a whole pass over the source produced no images (or it could
+    // not be rewound) and every loaded image was consumed
+    bool exhausted() const;
+    
+    // "io_uring" or "threads"
+    const char* backendName() const;
+    
+    // Map an image file, or read it into memory if it cannot be mapped
+    static bool readImageFile(const std::string& path, SharedBuffer& image);
+    
+private:
+    struct Slot {
+        PrefetchedImage image;
+        bool ready;
+        
+        Slot() : ready(false) {}
+    };
+    struct Uring;
+    
+    // Claim the next sequence number once a slot is free and take the next
+    // entry from the source for it, into a cleared image. Without wait,
+    // gives up instead of blocking. Returns false when stopped or the source
+    // is exhausted.
+    bool claim(uint64_t& sequence, PrefetchedImage& image, bool wait);
+    void complete(uint64_t sequence, PrefetchedImage&& image);
+    
+    // Synchronous load from the cache or the file, used by the thread pool
+    void load(PrefetchedImage& image);
+    
+    // Map or read a file and add it to the cache
+    bool loadFile(const ImageIndexEntry& entry, SharedBuffer& image);
+    
+    void poolWorker();
+    void uringWorker();
+    
+    ImageSource& source_;
+    ImageCache& cache_;
+    size_t depth_;
+    size_t max_read_size_;
+    
+    // Serializes claims, so sequence numbers follow the source's order
+    std::mutex claim_mutex_;
+    size_t position_;                // Guarded by claim_mutex_
+    
+    mutable std::mutex mutex_;
+    std::condition_variable space_;  // A slot was consumed
+    std::condition_variable ready_;  // A slot was filled
+    std::vector<Slot> slots_;        // Sequence s lives in slots_[s % depth_]
+    uint64_t next_claim_;
+    uint64_t next_consume_;
+    bool running_;
+    bool exhausted_;
+    
+    std::vector<std::thread> threads_;
+    std::unique_ptr<Uring> uring_;
+};
+
+} // namespace imaging
@@ -0,0 +1,34 @@
+/*
+ * Image Probe Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace imaging {
+
+// Bytes from the start of a file that are enough to probe almost any PNG,
+// JPEG or BMP, and TIFF files whose first IFD precedes the pixel data
+constexpr size_t kImageProbeBytes = 64 * 1024;
+
+struct ImageDimensions {
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;  // As cv::imread(IMREAD_UNCHANGED) would return them
+    
+    ImageDimensions() : width(0), height(0), channels(0) {}
+};
+
+// Read width, height and channel count from the header of an encoded PNG,
+// JPEG, BMP or TIFF image without decoding it. data may hold only the start
+// of the file. Returns false if the format is not recognised, the header lies
+// beyond size bytes, or the channel count depends on decoder details; callers
+// then fall back to a full decode.
+bool probeImageDimensions(const uint8_t* data, size_t size, ImageDimensions& dimensions);
+
+} // namespace imaging
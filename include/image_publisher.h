@@ -7,11 +7,18 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <memory>
 #include <zmq.h>
 #include "message_protocol.h"
+#include "shm_transport.h"
+#include "image_cache.h"
+#include "image_source.h"
+#include "synthetic_source.h"
+#include "rate_controller.h"
+#include "flow_control.h"
 
 namespace imaging {
 
@@ -23,28 +30,124 @@ public:
     // Initialize the publisher
     bool initialize();
     
-    // Load images from a directory
+    // Load images from a directory, using and updating its image index
     bool loadImagesFromDirectory(const std::string& directory);
     
+    // Publish the images listed in a manifest file (see ManifestImageSource)
+    bool loadImagesFromManifest(const std::string& manifest_path);
+    
+    // Publish images while the directory is still being listed, without an
+    // index, for datasets too large to enumerate up front
+    bool streamImagesFromDirectory(const std::string& directory);
+    
+    // Publish files as they are written to the directory (inotify), with
+    // the image cache disabled since each file is sent once
+    bool watchDirectory(const std::string& directory);
+    
+    // Publish procedurally generated images instead of files; the source
+    // keeps encoded frames within the cache size set beforehand
+    void useSyntheticImages(const SyntheticImageOptions& options);
+    
+    // Include subdirectories when loading, streaming or watching a directory
+    void setRecursive(bool recursive);
+    
     // Publish images continuously
     void publishImages();
     
-    // Stop publishing
+    // Stop publishing (async-signal-safe)
     void stop();
     
+    // Send header and image bytes as separate frames (default) instead of
+    // one contiguous message
+    void setMultipartFraming(bool enabled);
+    
+    // Stream images larger than chunk_size bytes from disk as IMAGE_CHUNK
+    // messages of at most that size. 0 sends every image whole.
+    void setChunkSize(size_t chunk_size);
+    
+    // Ring size used when the endpoint is shm://NAME
+    void setShmCapacity(size_t capacity);
+    
+    // Memory budget for keeping image files between passes over the dataset
+    // (0 reads every image from disk on every pass)
+    void setCacheSize(size_t bytes);
+    
+    // Number of images loaded ahead of the one being sent (at least 1)
+    void setPrefetchDepth(size_t depth);
+    
+    // Pace publishing to a frame rate or a byte rate (default 10 frames per
+    // second), or send as fast as subscribers accept. Unthrottled sends
+    // block at the high water mark instead of dropping frames; call before
+    // initialize().
+    void setFrameRate(double frames_per_second);
+    void setByteRate(double bytes_per_second);
+    void setUnthrottled();
+    
+    // Send only as far as downstream stages grant credit on this endpoint
+    // (bound as the PULL end of the side channel); call before initialize().
+    // Frames waiting for credit are queued up to queue_depth, then dropped by
+    // policy. Unthrottled publishing waits for credit instead of dropping.
+    void setCreditEndpoint(const std::string& endpoint);
+    void setDropPolicy(DropPolicy policy, size_t queue_depth, size_t nth);
+    
 private:
+    // A frame ready to go out, held while there is no credit
+    struct PendingFrame {
+        std::string path;
+        ImageMetadata metadata;
+        SharedBuffer image;
+    };
+    
     std::string endpoint_;
     void* context_;
     void* publisher_;
-    std::vector<std::string> image_paths_;
-    bool running_;
-    size_t current_index_;
+    std::unique_ptr<ImageSource> source_;
+    bool recursive_;
+    std::atomic<bool> running_;
+    bool multipart_;
+    std::vector<uint8_t> message_buffer_;  // Reused for single-frame messages
+    size_t chunk_size_;
+    uint32_t next_transfer_id_;
+    bool shm_;                      // Endpoint is shm://, images go through the ring
+    size_t shm_capacity_;
+    ShmPublisher shm_publisher_;
+    ImageCache cache_;
+    size_t prefetch_depth_;
+    RateController rate_;
+    int send_flags_;                // ZMQ_DONTWAIT unless unthrottled
+    uint64_t frame_count_;
+    std::string credit_endpoint_;
+    CreditListener credit_listener_;
+    CreditGate credit_gate_;
+    DropPolicy drop_policy_;
+    size_t credit_queue_depth_;
+    size_t drop_nth_;
+    
+    // Send one frame in its framing, logging failures; true if it was sent
+    bool sendFrame(const PendingFrame& frame);
+    
+    // Queue a frame behind those waiting for credit and send what credit allows
+    void sendWithCredit(PendingFrame&& frame, DropQueue<PendingFrame>& waiting);
+    
+    // Send waiting frames while downstream has credit
+    void drainWaiting(DropQueue<PendingFrame>& waiting);
+    
+    // Until the next frame is due, send waiting frames as credit arrives
+    void drainUntilDue(DropQueue<PendingFrame>& waiting);
+    
+    // Send one frame using the configured framing; returns zmq_send semantics
+    int sendImage(const ImageMetadata& metadata, const SharedBuffer& image);
     
-    // Read image file into buffer
-    bool readImageFile(const std::string& path, std::vector<uint8_t>& buffer);
+    // Send an image as IMAGE_CHUNK messages, as slices of image when it is
+    // mapped or in memory, otherwise read from disk one chunk at a time so only one chunk
+    // per queued frame is ever held in memory; returns zmq_send semantics
+    int sendImageChunks(const std::string& path, const ImageMetadata& metadata,
+                        const SharedBuffer& image);
     
-    // Get image dimensions from OpenCV
-    bool getImageInfo(const std::string& path, uint32_t& width, uint32_t& height, uint32_t& channels);
+    // Get image dimensions from the file header in data, or from the start of
+    // the file when data is null; decodes only as a fallback
+    bool getImageInfo(const std::string& path, const uint8_t* data, size_t size,
+                      ImageMetadata& metadata);
 };
 
 } // namespace imaging
@@ -0,0 +1,56 @@
+/*
+ * Image Receiver Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "buffer_pool.h"
+#include "message_protocol.h"
+#include "zmq_helpers.h"
+#include "chunk_assembler.h"
+#include "shm_transport.h"
+
+namespace imaging {
+
+// Receives images from a subscriber socket in every framing the image
+// generator produces: single frame, header + payload frames, IMAGE_CHUNK
+// streams and shm:// descriptors
+class ImageReceiver {
+public:
+    explicit ImageReceiver(const std::string& endpoint);
+    
+    // Receive one message. Returns 1 when image holds a complete image, 0 if
+    // the message was consumed without completing one (a chunk, or a bad
+    // message that was logged), and -1 with errno set on socket errors. The
+    // image stays valid until the next call. Frames are received into
+    // ZeroMQ's own messages, so there is no size limit and no copy.
+    int receive(void* socket, int flags, ImageDataView& image);
+    
+    // For shm:// endpoints the image is read in place; false once the
+    // producer has overwritten it. Check after using the image.
+    bool intact() const;
+    
+    // Take ownership of the image from the last successful receive, so it
+    // outlives the next call. Frames received from the socket are handed
+    // over without copying; chunked images and images read from shared
+    // memory are copied, into a pooled buffer if a pool is set.
+    SharedBuffer detach(const ImageDataView& image);
+    
+    // Pool for the copies detach() makes (not owned; nullptr for the heap)
+    void setBufferPool(BufferPool* pool) { pool_ = pool; }
+    
+private:
+    bool shm_;
+    BufferPool* pool_;
+    ZmqMessage frame_;    // First frame: header, single-frame message or shm descriptor
+    ZmqMessage payload_;  // Image payload or chunk following a header frame
+    ChunkAssembler assembler_;
+    ShmSubscriber shm_subscriber_;
+};
+
+} // namespace imaging
@@ -0,0 +1,184 @@
+/*
+ * Image Source Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "image_index.h"
+#include "shared_buffer.h"
+
+namespace imaging {
+
+// Supplies the image files to publish, one pass at a time. Entries need only
+// a path; a zero size or width is filled in when the file is loaded. Only
+// one thread calls a source at a time.
+class ImageSource {
+public:
+    enum class Result {
+        IMAGE,        // entry holds the next image
+        PENDING,      // Nothing available within the timeout; try again
+        END_OF_PASS   // Every image of this pass was returned
+    };
+    
+    virtual ~ImageSource() = default;
+    
+    virtual Result next(ImageIndexEntry& entry, std::chrono::milliseconds timeout) = 0;
+    
+    // Start the next pass from the first image. Returns false if the source
+    // cannot be read again.
+    virtual bool rewind() = 0;
+    
+    // Human-readable description for the log
+    virtual std::string describe() const = 0;
+    
+    // Bytes of the image last returned by next(), for sources that produce
+    // images in memory. File-based sources return false and the file at
+    // entry.path is loaded instead.
+    virtual bool takeImage(SharedBuffer& image) {
+        (void)image;
+        return false;
+    }
+};
+
+// A fixed list of images, e.g. the entries of an ImageIndex
+class ImageListSource : public ImageSource {
+public:
+    explicit ImageListSource(std::vector<ImageIndexEntry> images);
+    
+    Result next(ImageIndexEntry& entry, std::chrono::milliseconds timeout) override;
+    bool rewind() override;
+    std::string describe() const override;
+    
+    const std::vector<ImageIndexEntry>& images() const { return images_; }
+    
+private:
+    std::vector<ImageIndexEntry> images_;
+    size_t position_;
+};
+
+// Image files listed in a manifest, one per line, read as they are needed so
+// memory does not grow with the manifest. A line holds a path (relative to
+// the manifest's directory unless absolute), optionally followed by
+// whitespace and the frame's capture time in nanoseconds since the epoch,
+// which is then published as its timestamp. Blank lines and lines starting
+// with '#' are skipped.
+class ManifestImageSource : public ImageSource {
+public:
+    explicit ManifestImageSource(const std::string& manifest_path);
+    
+    // Check that the manifest can be read
+    bool open();
+    
+    Result next(ImageIndexEntry& entry, std::chrono::milliseconds timeout) override;
+    bool rewind() override;
+    std::string describe() const override;
+    
+    // Split a manifest line into path and timestamp (0 if there is none).
+    // Returns false for blank and comment lines.
+    static bool parseLine(const std::string& line, std::string& path, int64_t& timestamp);
+    
+private:
+    std::string manifest_path_;
+    std::string base_directory_;
+    std::ifstream file_;
+};
+
+// Image files of a directory (and optionally its subdirectories), listed on a
+// background thread while earlier ones are already being published. At most
+// queue_capacity listed files wait in memory, so neither startup time nor
+// memory grows with the size of the dataset. Files come in directory order;
+// every pass lists the directory again and picks up new files.
+class DirectoryStreamSource : public ImageSource {
+public:
+    DirectoryStreamSource(const std::string& directory, bool recursive,
+                          size_t queue_capacity = 1024);
+    ~DirectoryStreamSource();
+    
+    DirectoryStreamSource(const DirectoryStreamSource&) = delete;
+    DirectoryStreamSource& operator=(const DirectoryStreamSource&) = delete;
+    
+    Result next(ImageIndexEntry& entry, std::chrono::milliseconds timeout) override;
+    bool rewind() override;
+    std::string describe() const override;
+    
+    // Files listed so far in the current pass
+    size_t listedCount() const;
+    
+private:
+    void startListing();
+    void stopListing();
+    void listDirectory();
+    
+    // Queue a listed file, waiting for room. Returns false when stopping.
+    bool push(ImageIndexEntry&& entry);
+    
+    std::string directory_;
+    bool recursive_;
+    size_t queue_capacity_;
+    
+    mutable std::mutex mutex_;
+    std::condition_variable space_;   // An entry was taken from the queue
+    std::condition_variable filled_;  // An entry was queued or listing ended
+    std::deque<ImageIndexEntry> queue_;
+    size_t listed_;
+    bool listing_done_;
+    bool stopping_;
+    std::thread lister_;
+};
+
+// Live ingest: image files that finish being written to a directory (closed
+// after writing, or renamed into it) are returned as soon as inotify reports
+// them, without rescanning. Files present before open() are not published.
+// Notifications are drained into a queue of at most queue_capacity files;
+// during a burst beyond that the oldest are dropped so playback stays close
+// to live. The source never ends a pass.
+class WatchDirectorySource : public ImageSource {
+public:
+    WatchDirectorySource(const std::string& directory, bool recursive,
+                         size_t queue_capacity = 1024);
+    ~WatchDirectorySource();
+    
+    WatchDirectorySource(const WatchDirectorySource&) = delete;
+    WatchDirectorySource& operator=(const WatchDirectorySource&) = delete;
+    
+    // Start watching (and watch existing subdirectories when recursive)
+    bool open();
+    
+    Result next(ImageIndexEntry& entry, std::chrono::milliseconds timeout) override;
+    bool rewind() override;
+    std::string describe() const override;
+    
+    // Files dropped because the queue was full
+    uint64_t droppedCount() const { return dropped_; }
+    
+private:
+    bool addWatch(const std::string& directory);
+    
+    // Read pending notifications into the queue, waiting up to timeout for
+    // the first. Returns false on error.
+    bool readEvents(std::chrono::milliseconds timeout);
+    
+    std::string directory_;
+    bool recursive_;
+    size_t queue_capacity_;
+    int fd_;
+    std::unordered_map<int, std::string> watches_;  // Watch descriptor to directory
+    std::deque<std::string> queue_;
+    std::vector<char> event_buffer_;
+    uint64_t dropped_;
+};
+
+} // namespace imaging
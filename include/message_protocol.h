@@ -11,6 +11,9 @@
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include "byte_order.h"
+#include "descriptor_encoding.h"
+#include "compression.h"
 
 namespace imaging {
 
@@ -19,9 +22,23 @@ enum class MessageType : uint8_t {
     IMAGE_DATA = 1,
     PROCESSED_DATA = 2,
     HEARTBEAT = 3,
-    SHUTDOWN = 4
+    SHUTDOWN = 4,
+    IMAGE_CHUNK = 5,
+    SHM_DESCRIPTOR = 6
 };
 
+// Wire format version carried by processed data messages
+constexpr uint8_t kProtocolVersion = 3;
+
+// Processed data header flags
+constexpr uint8_t kFlagLittleEndianArrays = 0x01;  // Keypoint/descriptor arrays are little-endian
+constexpr uint8_t kFlagCompressedFeatures = 0x02;  // Keypoint/descriptor section is compressed
+constexpr uint8_t kFlagImageByReference = 0x04;    // Image replaced by its content hash
+
+// Largest compressed feature section a receiver will inflate, since its raw
+// size comes off the wire (about 500,000 float32 SIFT keypoints)
+constexpr size_t kMaxFeatureSectionSize = 256 * 1024 * 1024;
+
 // Image metadata structure
 struct ImageMetadata {
     uint64_t timestamp;
@@ -35,6 +52,41 @@ struct ImageMetadata {
         : timestamp(0), width(0), height(0), channels(0), data_size(0) {}
 };
 
+// Header of one chunk of an image streamed in pieces. Every chunk repeats the
+// whole-image metadata; the chunk bytes follow in a second frame.
+struct ImageChunkHeader {
+    ImageMetadata metadata;
+    uint32_t transfer_id;   // Distinguishes consecutive streamed images
+    uint32_t chunk_index;
+    uint32_t chunk_count;
+    uint32_t chunk_offset;  // Position of this chunk within the image
+    
+    ImageChunkHeader()
+        : transfer_id(0), chunk_index(0), chunk_count(0), chunk_offset(0) {}
+};
+
+// Control message of the shared-memory transport: locates one message that
+// was written into the producer's ring segment
+struct ShmDescriptor {
+    uint64_t generation;  // Identifies the segment instance the record lives in
+    uint64_t sequence;    // Per-producer counter, gaps mean dropped descriptors
+    uint64_t offset;      // Logical ring position of the record
+    uint32_t length;
+    
+    ShmDescriptor() : generation(0), sequence(0), offset(0), length(0) {}
+};
+
+// Flow control state a downstream stage advertises in its heartbeats. Counts
+// are cumulative, so a lost heartbeat is made up for by the next one.
+struct CreditGrant {
+    std::string stage;    // Identifies one running instance of a stage
+    uint64_t timestamp;
+    uint64_t consumed;    // Messages taken off the input since the stage started
+    uint32_t window;      // Messages the stage can accept beyond those; 0 = no credit
+    
+    CreditGrant() : timestamp(0), consumed(0), window(0) {}
+};
+
 // Keypoint structure for SIFT features
 struct KeyPoint {
     float x;
@@ -48,6 +100,66 @@ struct KeyPoint {
         : x(0), y(0), size(0), angle(0), response(0), octave(0) {}
 };
 
+// Encoding choices for processed data messages
+struct ProcessedDataOptions {
+    // Byte order of the keypoint and descriptor arrays. Native order lets both
+    // ends copy the arrays with a single memcpy.
+    ByteOrder byte_order;
+    
+    // Element type of the descriptor array
+    DescriptorEncoding descriptor_encoding;
+    
+    // Codec for the keypoint and descriptor section (the image is never
+    // recompressed). Keypoint coordinates are delta-coded and the arrays
+    // byte-shuffled before compression. A negative level picks the default.
+    CompressionCodec compression;
+    int compression_level;
+    
+    // Send only the image's content hash instead of its bytes, for receivers
+    // that get the image from the generator themselves
+    bool image_by_reference;
+    
+    ProcessedDataOptions()
+        : byte_order(nativeByteOrder()), descriptor_encoding(DescriptorEncoding::FLOAT32),
+          compression(CompressionCodec::NONE), compression_level(-1),
+          image_by_reference(false) {}
+};
+
+// Non-owning view of an image data message. Pointers refer into the received
+// message buffer and are only valid while that buffer is alive.
+struct ImageDataView {
+    ImageMetadata metadata;
+    const uint8_t* image_data;
+    size_t image_size;
+    
+    ImageDataView() : image_data(nullptr), image_size(0) {}
+};
+
+// Non-owning view of a processed data message. Keypoints and descriptors are
+// left in their encoded form (possibly unaligned); use
+// MessageProtocol::decodeKeyPoints and decodeDescriptors to materialize them.
+struct ProcessedDataView {
+    ImageMetadata metadata;
+    const uint8_t* image_data;
+    size_t image_size;
+    uint32_t num_keypoints;
+    const uint8_t* keypoint_data;
+    uint32_t num_descriptors;
+    DescriptorEncoding descriptor_encoding;
+    const uint8_t* descriptor_data;
+    size_t descriptor_size;          // Encoded bytes
+    ByteOrder byte_order;            // Byte order of the keypoint and descriptor arrays
+    CompressionCodec compression;    // Codec the feature section arrived with
+    bool image_by_reference;         // Image bytes omitted; image_data is null
+    uint64_t image_hash;             // contentHash() of the image, if by reference
+    
+    ProcessedDataView()
+        : image_data(nullptr), image_size(0), num_keypoints(0), keypoint_data(nullptr),
+          num_descriptors(0), descriptor_encoding(DescriptorEncoding::FLOAT32),
+          descriptor_data(nullptr), descriptor_size(0), byte_order(nativeByteOrder()),
+          compression(CompressionCodec::NONE), image_by_reference(false), image_hash(0) {}
+};
+
 // Message protocol class for serialization/deserialization
 class MessageProtocol {
 public:
@@ -57,6 +169,29 @@ public:
         const std::vector<uint8_t>& image_data
     );
     
+    // Exact encoded size of an image data message
+    static size_t imageDataSize(const ImageMetadata& metadata, size_t image_size);
+    
+    // Serialize image data into a caller-owned buffer resized to the exact
+    // message size. Reusing the buffer avoids reallocation once it has grown to
+    // the largest frame. Returns the message size.
+    static size_t serializeImageDataInto(
+        std::vector<uint8_t>& buffer,
+        const ImageMetadata& metadata,
+        const uint8_t* image_data,
+        size_t image_size
+    );
+    
+    // Serialize image data into raw memory of at least imageDataSize() bytes.
+    // Returns the message size, or 0 if capacity is too small.
+    static size_t serializeImageDataInto(
+        uint8_t* data,
+        size_t capacity,
+        const ImageMetadata& metadata,
+        const uint8_t* image_data,
+        size_t image_size
+    );
+    
     // Deserialize image data message
     static bool deserializeImageData(
         const std::vector<uint8_t>& message,
@@ -64,12 +199,84 @@ public:
         std::vector<uint8_t>& image_data
     );
     
+    // Serialize the header frame of a multipart image data message. The image
+    // bytes are sent as a second frame so they never have to be copied.
+    static std::vector<uint8_t> serializeImageHeader(const ImageMetadata& metadata);
+    
+    // Deserialize a multipart image header frame
+    static bool deserializeImageHeader(
+        const uint8_t* data,
+        size_t size,
+        ImageMetadata& metadata
+    );
+    
+    // Serialize / deserialize the header frame of an image chunk message
+    static std::vector<uint8_t> serializeImageChunkHeader(const ImageChunkHeader& header);
+    static bool deserializeImageChunkHeader(
+        const uint8_t* data,
+        size_t size,
+        ImageChunkHeader& header
+    );
+    
+    // Serialize / deserialize a shared-memory descriptor (fixed 29 bytes)
+    static std::vector<uint8_t> serializeShmDescriptor(const ShmDescriptor& descriptor);
+    static bool deserializeShmDescriptor(
+        const uint8_t* data,
+        size_t size,
+        ShmDescriptor& descriptor
+    );
+    
     // Serialize processed data message (image + keypoints)
     static std::vector<uint8_t> serializeProcessedData(
         const ImageMetadata& metadata,
         const std::vector<uint8_t>& image_data,
         const std::vector<KeyPoint>& keypoints,
-        const std::vector<float>& descriptors
+        const std::vector<float>& descriptors,
+        const ProcessedDataOptions& options = ProcessedDataOptions()
+    );
+    
+    static std::vector<uint8_t> serializeProcessedData(
+        const ImageMetadata& metadata,
+        const uint8_t* image_data,
+        size_t image_size,
+        const std::vector<KeyPoint>& keypoints,
+        const std::vector<float>& descriptors,
+        const ProcessedDataOptions& options = ProcessedDataOptions()
+    );
+    
+    // Exact encoded size of a processed data message (an upper bound when
+    // compression is enabled)
+    static size_t processedDataSize(
+        const ImageMetadata& metadata,
+        size_t image_size,
+        size_t num_keypoints,
+        size_t num_descriptors,
+        const ProcessedDataOptions& options = ProcessedDataOptions()
+    );
+    
+    // Serialize processed data into a reusable caller-owned buffer, resized to
+    // the message size. Returns the message size, or 0 if compression failed.
+    static size_t serializeProcessedDataInto(
+        std::vector<uint8_t>& buffer,
+        const ImageMetadata& metadata,
+        const uint8_t* image_data,
+        size_t image_size,
+        const std::vector<KeyPoint>& keypoints,
+        const std::vector<float>& descriptors,
+        const ProcessedDataOptions& options = ProcessedDataOptions()
+    );
+    
+    // Serialize processed data into raw memory such as a zmq_msg_t sized with
+    // processedDataSize. Returns the message size, or 0 if capacity is too small.
+    static size_t serializeProcessedDataInto(
+        uint8_t* data,
+        size_t capacity,
+        const ImageMetadata& metadata,
+        const uint8_t* image_data,
+        size_t image_size,
+        const std::vector<KeyPoint>& keypoints,
+        const std::vector<float>& descriptors,
+        const ProcessedDataOptions& options = ProcessedDataOptions()
     );
     
     // Deserialize processed data message
@@ -81,24 +288,78 @@ public:
         std::vector<float>& descriptors
     );
     
+    // Parse messages in place without copying image bytes or features.
+    // This overload rejects messages with a compressed feature section.
+    static bool parseImageData(const uint8_t* data, size_t size, ImageDataView& view);
+    static bool parseProcessedData(const uint8_t* data, size_t size, ProcessedDataView& view);
+    
+    // Same, but inflates a compressed feature section into scratch, which must
+    // outlive the view. The image bytes are still referenced in place.
+    static bool parseProcessedData(const uint8_t* data, size_t size, ProcessedDataView& view,
+                                   std::vector<uint8_t>& scratch);
+    
+    // Materialize the encoded features referenced by a view (descriptors are
+    // dequantized to float regardless of their wire encoding)
+    static void decodeKeyPoints(const ProcessedDataView& view, std::vector<KeyPoint>& keypoints);
+    static void decodeDescriptors(const ProcessedDataView& view, std::vector<float>& descriptors);
+    
     // Serialize heartbeat message
     static std::vector<uint8_t> serializeHeartbeat(const std::string& app_name);
     
+    // Serialize a heartbeat carrying a credit grant, and parse either kind of
+    // heartbeat (a plain one yields a grant with window 0)
+    static std::vector<uint8_t> serializeHeartbeat(const CreditGrant& grant);
+    static bool deserializeHeartbeat(const uint8_t* data, size_t size, CreditGrant& grant);
+    
     // Get message type from serialized message
     static MessageType getMessageType(const std::vector<uint8_t>& message);
+    static MessageType getMessageType(const uint8_t* data, size_t size);
 
 private:
-    // Helper functions for serialization
-    static void writeUint32(std::vector<uint8_t>& buffer, uint32_t value);
-    static void writeUint64(std::vector<uint8_t>& buffer, uint64_t value);
-    static void writeFloat(std::vector<uint8_t>& buffer, float value);
-    static void writeString(std::vector<uint8_t>& buffer, const std::string& str);
+    // Helper functions for serialization (buffers are presized by the caller)
+    static void writeUint32(uint8_t* data, size_t& offset, uint32_t value);
+    static void writeUint64(uint8_t* data, size_t& offset, uint64_t value);
+    static void writeFloat(uint8_t* data, size_t& offset, float value);
+    static void writeString(uint8_t* data, size_t& offset, const std::string& str);
+    static void writeBytes(uint8_t* data, size_t& offset, const void* bytes, size_t size);
+    static void writeArray(uint8_t* data, size_t& offset, const void* array, size_t bytes,
+                           ByteOrder order);
+    static void writeDescriptors(uint8_t* data, size_t& offset,
+                                 const std::vector<float>& descriptors,
+                                 const ProcessedDataOptions& options);
     
     // Helper functions for deserialization
     static uint32_t readUint32(const uint8_t* data, size_t& offset);
     static uint64_t readUint64(const uint8_t* data, size_t& offset);
     static float readFloat(const uint8_t* data, size_t& offset);
     static std::string readString(const uint8_t* data, size_t& offset, size_t max_length);
+    static void readArray(void* dst, const uint8_t* src, size_t bytes, ByteOrder order);
+    
+    // Keypoint and descriptor section of processed data messages
+    static size_t featureSectionSize(size_t num_keypoints, size_t num_descriptors,
+                                     const ProcessedDataOptions& options);
+    static void writeFeatureSection(uint8_t* data, size_t& offset,
+                                    const std::vector<KeyPoint>& keypoints,
+                                    const std::vector<float>& descriptors,
+                                    const ProcessedDataOptions& options);
+    static bool parseFeatureSection(const uint8_t* data, size_t size, ProcessedDataView& view);
+    static bool parseProcessedData(const uint8_t* data, size_t size, ProcessedDataView& view,
+                                   std::vector<uint8_t>* scratch);
+    
+    // Reversible pre-compression filter for a feature section
+    static bool locateFeatureArrays(const uint8_t* section, size_t size,
+                                    size_t& num_keypoints, size_t& num_descriptors,
+                                    size_t& element_size);
+    static void packFeatureSection(uint8_t* section, size_t size, ByteOrder order,
+                                   uint8_t* packed);
+    static bool unpackFeatureSection(const uint8_t* packed, size_t size, ByteOrder order,
+                                     uint8_t* section);
+    
+    // Shared metadata block used by image and processed data messages
+    static size_t metadataSize(const ImageMetadata& metadata);
+    static void writeMetadata(uint8_t* data, size_t& offset, const ImageMetadata& metadata);
+    static bool readMetadata(const uint8_t* data, size_t size, size_t& offset,
+                             ImageMetadata& metadata);
 };
 
 } // namespace imaging
@@ -0,0 +1,116 @@
+/*
+ * MPMC Queue Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "padded_counter.h"
+
+namespace imaging {
+
+// Bounded lock-free queue for any number of producer and consumer threads
+// (Vyukov's ring: each cell carries a sequence number telling producers and
+// consumers whose turn it is). Like SpscQueue, items are exchanged by
+// swapping, so move-only types work and buffers can circulate.
+template <typename T>
+class MpmcQueue {
+public:
+    // Capacity is rounded up to a power of two, at least 2
+    explicit MpmcQueue(size_t capacity)
+        : cells_(roundUp(capacity)), mask_(cells_.size() - 1), enqueue_(0), dequeue_(0) {
+        for (size_t i = 0; i < cells_.size(); ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+    
+    // Swaps item into the queue; false if full, leaving item untouched
+    bool tryPush(T& item) {
+        size_t position = enqueue_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[position & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (lag == 0) {
+                // The cell is free for this position; claim it
+                if (enqueue_.compare_exchange_weak(position, position + 1,
+                                                   std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                return false;  // Still holds the item from one lap ago
+            } else {
+                position = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+        std::swap(cell->item, item);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Swaps the oldest item out; false if empty
+    bool tryPop(T& item) {
+        size_t position = dequeue_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[position & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (lag == 0) {
+                if (dequeue_.compare_exchange_weak(position, position + 1,
+                                                   std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                return false;  // Not written yet
+            } else {
+                position = dequeue_.load(std::memory_order_relaxed);
+            }
+        }
+        std::swap(item, cell->item);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+    
+    size_t capacity() const { return cells_.size(); }
+    
+    // A snapshot; may be stale by the time the caller looks at it
+    size_t size() const {
+        size_t dequeue = dequeue_.load(std::memory_order_acquire);
+        size_t enqueue = enqueue_.load(std::memory_order_acquire);
+        return enqueue > dequeue ? enqueue - dequeue : 0;
+    }
+    
+private:
+    // Cells on separate lines, so neighbouring pushes and pops do not collide
+    struct alignas(kCacheLineSize) Cell {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+    
+    static size_t roundUp(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+    
+    std::vector<Cell> cells_;
+    size_t mask_;
+    alignas(kCacheLineSize) std::atomic<size_t> enqueue_;
+    alignas(kCacheLineSize) std::atomic<size_t> dequeue_;
+};
+
+} // namespace imaging
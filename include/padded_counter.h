@@ -0,0 +1,55 @@
+/*
+ * Padded Counter Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace imaging {
+
+// Line size of x86-64 and most ARM cores; data written by different threads
+// is kept this far apart to avoid false sharing
+constexpr size_t kCacheLineSize = 64;
+
+// Atomic counter on a cache line of its own, so counters bumped by
+// different threads (per-stage statistics, allocation counts) do not keep
+// stealing each other's line. Updates are relaxed: use for counting, not
+// for publishing other data.
+class alignas(kCacheLineSize) PaddedCounter {
+public:
+    explicit PaddedCounter(uint64_t initial = 0) : value_(initial) {}
+    
+    PaddedCounter(const PaddedCounter&) = delete;
+    PaddedCounter& operator=(const PaddedCounter&) = delete;
+    
+    // Returns the value before adding
+    uint64_t add(uint64_t amount = 1) { return value_.fetch_add(amount, std::memory_order_relaxed); }
+    uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+    
+    // Read and restart, e.g. for per-interval statistics
+    uint64_t exchange(uint64_t value) { return value_.exchange(value, std::memory_order_relaxed); }
+    
+    // Add one while below limit; false once the count has reached it
+    bool incrementBelow(uint64_t limit) {
+        uint64_t value = value_.load(std::memory_order_relaxed);
+        while (value < limit) {
+            if (value_.compare_exchange_weak(value, value + 1, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+private:
+    std::atomic<uint64_t> value_;
+};
+
+static_assert(sizeof(PaddedCounter) == kCacheLineSize, "PaddedCounter should fill one cache line");
+
+} // namespace imaging
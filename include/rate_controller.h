@@ -0,0 +1,76 @@
+/*
+ * Rate Controller Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace imaging {
+
+// Paces a stream of frames to a target frame rate or byte rate. Send times
+// follow an absolute schedule on the monotonic clock, so oversleeping one
+// frame shortens the wait for the next instead of accumulating drift.
+class RateController {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    enum class Mode {
+        UNTHROTTLED,        // No waiting; the sender is limited by downstream
+        FRAMES_PER_SECOND,
+        BYTES_PER_SECOND
+    };
+    
+    // Achieved rate and pacing error since the last resetStats()
+    struct Stats {
+        uint64_t frames;
+        uint64_t bytes;
+        double elapsed_seconds;
+        double frames_per_second;
+        double bytes_per_second;
+        double mean_lateness_us;  // How late frames started relative to schedule
+        double max_lateness_us;
+        uint64_t resyncs;         // Times the schedule was abandoned after falling behind
+    };
+    
+    RateController();
+    
+    void setUnthrottled();
+    void setFrameRate(double frames_per_second);
+    void setByteRate(double bytes_per_second);
+    
+    Mode mode() const { return mode_; }
+    
+    // Block until a frame of the given size is due, then account for it
+    void pace(size_t bytes);
+    
+    // When the next frame is due; now if unthrottled or nothing was paced yet
+    Clock::time_point due() const;
+    
+    Stats stats() const;
+    void resetStats();
+    
+private:
+    // How far the sender may fall behind before the schedule restarts from
+    // now, so a stall is not followed by a burst of catch-up frames
+    static constexpr double kMaxBacklogSeconds = 1.0;
+    
+    Mode mode_;
+    double rate_;
+    bool started_;
+    Clock::time_point deadline_;
+    
+    Clock::time_point stats_start_;
+    uint64_t frames_;
+    uint64_t bytes_;
+    double total_lateness_us_;
+    double max_lateness_us_;
+    uint64_t resyncs_;
+};
+
+} // namespace imaging
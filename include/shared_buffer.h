@@ -0,0 +1,58 @@
+/*
+ * Shared Buffer Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace imaging {
+
+// Immutable, reference-counted view over a block of bytes. The owner keeps the
+// underlying storage alive, so the buffer can be handed to ZeroMQ (or another
+// thread) without copying.
+class SharedBuffer {
+public:
+    SharedBuffer();
+    
+    // Take ownership of a vector's storage
+    explicit SharedBuffer(std::vector<uint8_t>&& bytes);
+    
+    // Wrap storage owned by an arbitrary object
+    SharedBuffer(std::shared_ptr<const void> owner, const uint8_t* data, size_t size);
+    
+    // A moved-from buffer is empty rather than pointing at bytes it no
+    // longer keeps alive
+    SharedBuffer(const SharedBuffer&) = default;
+    SharedBuffer(SharedBuffer&& other) noexcept;
+    SharedBuffer& operator=(const SharedBuffer&) = default;
+    SharedBuffer& operator=(SharedBuffer&& other) noexcept;
+    
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const std::shared_ptr<const void>& owner() const { return owner_; }
+    
+    // Sub-range sharing the same owner
+    SharedBuffer slice(size_t offset, size_t length) const;
+    
+private:
+    std::shared_ptr<const void> owner_;
+    const uint8_t* data_;
+    size_t size_;
+};
+
+// Map a file read-only into a buffer that unmaps it when the last reference
+// (e.g. a ZeroMQ frame still being sent) is released. The kernel is told to
+// read the file ahead sequentially. Returns false for empty or unmappable
+// files. The file must not be truncated while mapped.
+bool mapFile(const std::string& path, SharedBuffer& buffer);
+
+} // namespace imaging
@@ -0,0 +1,144 @@
+/*
+ * Shared-Memory Transport Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "message_protocol.h"
+
+namespace imaging {
+
+// Endpoints of the form shm://NAME select the shared-memory transport. The
+// ring lives in the POSIX segment /imaging-NAME and descriptors travel over
+// the usual PUB/SUB sockets on ipc:///tmp/imaging-NAME.ctl.
+bool isShmEndpoint(const std::string& endpoint);
+std::string shmSegmentName(const std::string& endpoint);
+std::string shmControlEndpoint(const std::string& endpoint);
+
+// Endpoint to bind/connect a ZeroMQ socket to: the control endpoint for
+// shm:// endpoints, otherwise the endpoint itself
+std::string transportEndpoint(const std::string& endpoint);
+
+// Single-producer / multi-consumer byte ring in a shared-memory segment.
+// The producer never waits for consumers: like a PUB socket it overwrites the
+// oldest records, and consumers detect that with intact() after reading.
+class ShmRing {
+public:
+    ShmRing();
+    ~ShmRing();
+    
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+    
+    // Producer: create (replacing any stale segment) a ring of capacity bytes
+    bool create(const std::string& name, size_t capacity);
+    
+    // Consumer: map an existing segment read-only
+    bool open(const std::string& name);
+    
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+    
+    // Producer: contiguous space for length bytes at logical position offset,
+    // or nullptr if length exceeds maxRecordSize()
+    uint8_t* reserve(size_t length, uint64_t& offset);
+    
+    // Producer: mark the record at offset as complete
+    void commit(uint64_t offset, size_t length);
+    
+    // Producer: give up the reserved record without committing it, so the
+    // records it would have overwritten read as intact again
+    void abort();
+    
+    // Consumer: pointer to a committed record, or nullptr if it is out of
+    // range or has already been overwritten
+    const uint8_t* record(uint64_t offset, size_t length) const;
+    
+    // Consumer: true if the record at offset has not been overwritten. Call
+    // after reading a record in place to validate what was read.
+    bool intact(uint64_t offset) const;
+    
+    uint64_t generation() const;
+    size_t capacity() const;
+    
+    // Records are limited to a quarter of the ring so several stay readable
+    size_t maxRecordSize() const { return capacity() / 4; }
+    
+private:
+    struct Header;
+    
+    std::string name_;
+    bool owner_;
+    int fd_;
+    void* mapping_;
+    size_t mapping_size_;
+    Header* header_;
+    uint8_t* data_;
+};
+
+// Producer side: writes messages into a ring; descriptors are sent on the
+// caller's socket
+class ShmPublisher {
+public:
+    ShmPublisher();
+    
+    // Create the segment for an shm:// endpoint
+    bool open(const std::string& endpoint, size_t capacity);
+    void close();
+    bool isOpen() const { return ring_.isOpen(); }
+    
+    // Space for the next message, serialized in place by the caller. Returns
+    // nullptr (errno EMSGSIZE) if the message cannot fit.
+    uint8_t* reserve(size_t length);
+    
+    // Commit the reserved message, trimmed to length, and send its descriptor.
+    // Returns length or -1 (errno set) like zmq_send.
+    int publish(void* socket, size_t length, int flags);
+    
+    // Drop the reserved message instead of publishing it (e.g. serializing
+    // into it failed)
+    void abort();
+    
+    size_t maxMessageSize() const { return ring_.maxRecordSize(); }
+    
+private:
+    ShmRing ring_;
+    uint64_t sequence_;
+    uint64_t reserved_offset_;
+};
+
+// Consumer side: resolves received descriptors to records in the ring
+class ShmSubscriber {
+public:
+    ShmSubscriber();
+    
+    // Remember the segment of an shm:// endpoint. It is mapped when the first
+    // descriptor arrives, so the producer may start later.
+    void open(const std::string& endpoint);
+    void close();
+    
+    // Point data at the record a descriptor message refers to. Returns false
+    // if the message is not a descriptor, the segment is unavailable, or the
+    // producer already overwrote the record. Check intact() once done with data.
+    bool resolve(const uint8_t* message, size_t message_size,
+                 const uint8_t*& data, size_t& size);
+    bool intact() const;
+    
+    // Descriptors lost between the producer and this subscriber
+    uint64_t missedMessages() const { return missed_; }
+    
+private:
+    std::string segment_name_;
+    ShmRing ring_;
+    ShmDescriptor last_;
+    bool have_last_;
+    uint64_t missed_;
+};
+
+} // namespace imaging
@@ -11,12 +11,26 @@
 #include <opencv2/features2d.hpp>
 #include <vector>
 #include "message_protocol.h"
+#include "shared_buffer.h"
 
 namespace imaging {
 
+// Splitting of large images into overlapping tiles processed in parallel.
+// A keypoint is kept only by the tile whose core contains it, so overlap
+// just gives detection near the seams the context a whole image would.
+// Multiples of 128 keep each tile's pyramid on the whole image's grid.
+struct SiftTiling {
+    uint64_t min_pixels;  // Tile images with at least this many pixels (0 = never)
+    int tile_size;        // Core width and height of a tile
+    int overlap;          // Context added around each core
+    unsigned threads;     // Threads per image (0 = one per core)
+    
+    SiftTiling() : min_pixels(0), tile_size(2048), overlap(128), threads(0) {}
+};
+
 class SIFTProcessor {
 public:
-    SIFTProcessor();
+    explicit SIFTProcessor(const SiftTiling& tiling = SiftTiling());
     ~SIFTProcessor() = default;
     
     // Process image and extract SIFT features
@@ -24,6 +38,20 @@ public:
                      std::vector<KeyPoint>& keypoints,
                      std::vector<float>& descriptors);
     
+    // Process an encoded image referenced in place (e.g. inside a received message)
+    bool processImage(const uint8_t* image_data, size_t image_size,
+                     std::vector<KeyPoint>& keypoints,
+                     std::vector<float>& descriptors);
+    
+    // Decode an encoded image to grayscale
+    static bool decodeImage(const uint8_t* image_data, size_t image_size, cv::Mat& gray);
+    
+    // Extract features from a decoded grayscale image, tiled when it is
+    // at least tiling.min_pixels large
+    bool extractFeatures(const cv::Mat& image,
+                         std::vector<KeyPoint>& keypoints,
+                         std::vector<float>& descriptors);
+    
     // Convert OpenCV keypoints to our format
     static void convertKeyPoints(const std::vector<cv::KeyPoint>& cv_keypoints,
                                  std::vector<KeyPoint>& keypoints);
@@ -33,7 +61,28 @@ public:
                                    std::vector<float>& descriptors);
 
 private:
+    // Detect on each tile in parallel, then merge in global coordinates
+    bool extractTiled(const cv::Mat& image,
+                      std::vector<cv::KeyPoint>& cv_keypoints,
+                      cv::Mat& cv_descriptors);
+    
     cv::Ptr<cv::SIFT> sift_;
+    SiftTiling tiling_;
+};
+
+// A frame on its way through the feature extractor's stages
+struct SiftFrame {
+    ImageMetadata metadata;
+    SharedBuffer image;               // Encoded image, also sent on in the output
+    cv::Mat gray;                     // Decoded image, released after detection
+    std::vector<KeyPoint> keypoints;
+    std::vector<float> descriptors;
+    std::vector<uint8_t> message;     // Serialized processed data
+    bool ok;                          // False once a stage has failed
+    double decode_ms;
+    double detect_ms;
+    
+    SiftFrame() : ok(false), decode_ms(0.0), detect_ms(0.0) {}
 };
 
 } // namespace imaging
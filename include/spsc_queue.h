@@ -0,0 +1,90 @@
+/*
+ * SPSC Queue Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "padded_counter.h"
+
+namespace imaging {
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread. Items are exchanged by swapping: whatever the consumer
+// hands in when popping goes back to the producer on a later push, so
+// buffers inside items circulate instead of being reallocated.
+template <typename T>
+class SpscQueue {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : slots_(roundUp(capacity)), mask_(slots_.size() - 1),
+          head_(0), cached_tail_(0), tail_(0), cached_head_(0) {}
+    
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    
+    // Producer only. Swaps item into the queue; false if full, leaving
+    // item untouched
+    bool tryPush(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size()) {
+                return false;
+            }
+        }
+        std::swap(slots_[tail & mask_], item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer only. Swaps the oldest item out; false if empty
+    bool tryPop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        std::swap(item, slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    size_t capacity() const { return slots_.size(); }
+    
+    // A snapshot; may be stale by the time the caller looks at it
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+    
+private:
+    static size_t roundUp(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+    
+    std::vector<T> slots_;
+    size_t mask_;
+    
+    // Each side's index and its cached copy of the other side's index
+    // share a cache line, apart from the other side's
+    alignas(kCacheLineSize) std::atomic<size_t> head_;  // Next slot to pop
+    size_t cached_tail_;                                // Consumer's last view of tail_
+    alignas(kCacheLineSize) std::atomic<size_t> tail_;  // Next slot to push
+    size_t cached_head_;                                // Producer's last view of head_
+};
+
+} // namespace imaging
@@ -0,0 +1,255 @@
+/*
+ * Staged Pipeline Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "logger.h"
+#include "mpmc_queue.h"
+#include "padded_counter.h"
+#include "spsc_queue.h"
+
+namespace imaging {
+
+// Waiting on a lock-free queue: yield for a while, then sleep for
+// growing intervals up to a millisecond so an idle stage costs nothing
+class Backoff {
+public:
+    Backoff() : spins_(0), sleep_(50) {}
+    
+    void pause() {
+        if (spins_ < 64) {
+            spins_++;
+            std::this_thread::yield();
+            return;
+        }
+        std::this_thread::sleep_for(sleep_);
+        sleep_ = std::min(sleep_ * 2, std::chrono::microseconds(1000));
+    }
+    
+private:
+    int spins_;
+    std::chrono::microseconds sleep_;
+};
+
+// Frames pass through a fixed sequence of stages, each on its own threads,
+// so different frames are in different stages at the same time. Ordered,
+// every pair of threads in neighbouring stages is connected by a bounded
+// SPSC queue and frame N goes to thread N % threads of every stage, so each
+// thread knows which queue its next frame comes from and frames stay in
+// order without locks. Unordered, neighbouring stages share one MPMC queue:
+// any free thread takes the next frame, so fast frames overtake a slow one.
+// The first stage is fed by submit() and the last drains to next(), each of
+// which must be called from a single thread.
+template <typename Frame>
+class StagedPipeline {
+public:
+    using Step = std::function<void(Frame&)>;
+    using StepFactory = std::function<Step()>;
+    
+    struct Stage {
+        std::string name;
+        unsigned threads;
+        StepFactory factory;  // Called once per thread, so each can own its state
+    };
+    
+    // depth is the number of frames each SPSC queue holds; a shared queue
+    // holds as many as the SPSC queues it replaces. Unordered, next()
+    // returns frames as they finish.
+    StagedPipeline(const std::vector<Stage>& stages, size_t depth, bool ordered)
+        : ordered_(ordered), processed_(stages.size()), stopping_(false),
+          submitted_(0), delivered_(0) {
+        std::vector<unsigned> counts;
+        for (const auto& stage : stages) {
+            counts.push_back(std::max(stage.threads, 1u));
+        }
+        
+        // links_[i] feeds stage i; the last one feeds next()
+        links_.reserve(counts.size() + 1);
+        unsigned producers = 1;
+        for (unsigned consumers : counts) {
+            links_.emplace_back(producers, consumers, depth, ordered);
+            producers = consumers;
+        }
+        links_.emplace_back(producers, 1, depth, ordered);
+        
+        // Steps are created before any thread starts, so a failure leaves
+        // no half-running pipeline
+        std::vector<std::vector<Step>> steps(stages.size());
+        for (size_t i = 0; i < stages.size(); ++i) {
+            for (unsigned t = 0; t < counts[i]; ++t) {
+                Step step = stages[i].factory();
+                if (!step) {
+                    Logger::error("Failed to create pipeline stage: " + stages[i].name);
+                    return;
+                }
+                steps[i].push_back(std::move(step));
+            }
+        }
+        for (size_t i = 0; i < stages.size(); ++i) {
+            for (unsigned t = 0; t < counts[i]; ++t) {
+                threads_.emplace_back(&StagedPipeline::worker, this, i, t, std::move(steps[i][t]));
+            }
+        }
+    }
+    
+    ~StagedPipeline() {
+        stop();
+    }
+    
+    StagedPipeline(const StagedPipeline&) = delete;
+    StagedPipeline& operator=(const StagedPipeline&) = delete;
+    
+    // Queue a frame, waiting up to timeout for room. On success frame is
+    // swapped with a recycled one whose buffers may be reused; on failure
+    // (timeout, stopped, or stages that failed to start) it is left as it was.
+    bool submit(Frame& frame, std::chrono::milliseconds timeout) {
+        if (stopping_ || (threads_.empty() && links_.size() > 1)) {
+            return false;
+        }
+        Link& link = links_.front();
+        bool queued = waitUntil([&] {
+            if (ordered_) {
+                return link.at(0, static_cast<unsigned>(submitted_ % link.consumers)).tryPush(frame);
+            }
+            return link.shared->tryPush(frame);
+        }, timeout);
+        if (!queued) {
+            return false;
+        }
+        submitted_++;
+        return true;
+    }
+    
+    // Next frame out of the last stage, waiting up to timeout. The previous
+    // contents of frame are recycled.
+    bool next(Frame& frame, std::chrono::milliseconds timeout) {
+        Link& link = links_.back();
+        bool found = waitUntil([&] {
+            if (ordered_) {
+                return link.at(static_cast<unsigned>(delivered_ % link.producers), 0).tryPop(frame);
+            }
+            return link.shared->tryPop(frame);
+        }, timeout);
+        if (found) {
+            delivered_++;
+        }
+        return found;
+    }
+    
+    // Stop every stage; frames still in the pipeline are discarded
+    void stop() {
+        stopping_ = true;
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+    
+    size_t threadCount() const { return threads_.size(); }
+    
+    // Frames a stage has finished with so far, including failed ones
+    uint64_t processed(size_t stage) const { return processed_[stage].get(); }
+    
+private:
+    using Queue = SpscQueue<Frame>;
+    using SharedQueue = MpmcQueue<Frame>;
+    
+    // Ordered: queues from every producer thread to every consumer thread
+    // of one link. Unordered: one queue for all of them.
+    struct Link {
+        unsigned producers;
+        unsigned consumers;
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::unique_ptr<SharedQueue> shared;
+        
+        Link(unsigned producer_count, unsigned consumer_count, size_t depth, bool ordered)
+            : producers(producer_count), consumers(consumer_count) {
+            depth = std::max<size_t>(depth, 1);
+            if (!ordered) {
+                shared.reset(new SharedQueue(depth * producers * consumers));
+                return;
+            }
+            for (unsigned i = 0; i < producers * consumers; ++i) {
+                queues.emplace_back(new Queue(depth));
+            }
+        }
+        
+        Queue& at(unsigned producer, unsigned consumer) {
+            return *queues[producer * consumers + consumer];
+        }
+    };
+    
+    // Retries attempt until it succeeds, the timeout passes or we stop
+    template <typename Attempt>
+    bool waitUntil(Attempt attempt, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        Backoff backoff;
+        while (!attempt()) {
+            if (stopping_ || std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            backoff.pause();
+        }
+        return true;
+    }
+    
+    void worker(size_t stage, unsigned index, Step step) {
+        Link& input = links_[stage];
+        Link& output = links_[stage + 1];
+        Frame frame;
+        
+        // Ordered, this thread sees frames index, index + threads,
+        // index + 2 * threads...; unordered, whatever arrives first
+        for (uint64_t sequence = index; !stopping_; sequence += input.consumers) {
+            Backoff wait_input;
+            while (!(ordered_ ?
+                     input.at(static_cast<unsigned>(sequence % input.producers), index).tryPop(frame) :
+                     input.shared->tryPop(frame))) {
+                if (stopping_) {
+                    return;
+                }
+                wait_input.pause();
+            }
+            
+            step(frame);
+            processed_[stage].add();
+            
+            Backoff wait_output;
+            while (!(ordered_ ?
+                     output.at(index, static_cast<unsigned>(sequence % output.consumers)).tryPush(frame) :
+                     output.shared->tryPush(frame))) {
+                if (stopping_) {
+                    return;
+                }
+                wait_output.pause();
+            }
+        }
+    }
+    
+    bool ordered_;
+    std::vector<Link> links_;
+    std::vector<PaddedCounter> processed_;  // Per stage, bumped by all its threads
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stopping_;
+    
+    // Used only by the thread calling submit() / next() respectively
+    uint64_t submitted_;
+    uint64_t delivered_;
+};
+
+} // namespace imaging
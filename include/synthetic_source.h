@@ -0,0 +1,97 @@
+/*
+ * Synthetic Image Source Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image_cache.h"
+#include "image_source.h"
+
+namespace imaging {
+
+enum class SyntheticEncoding {
+    RAW,   // Uncompressed BMP: pixels as they are, no encode or decode cost
+    PNG,
+    JPEG
+};
+
+// "raw", "png" or "jpeg"
+std::string syntheticEncodingName(SyntheticEncoding encoding);
+bool parseSyntheticEncoding(const std::string& name, SyntheticEncoding& encoding);
+
+struct SyntheticImageOptions {
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;         // 1 or 3
+    double texture_density;    // Shapes per 100x100 pixels; drives the keypoint count
+    SyntheticEncoding encoding;
+    int jpeg_quality;
+    size_t frame_count;        // Distinct frames per pass
+    unsigned threads;          // Generator threads (0 = one per core)
+    size_t queue_depth;        // Frames generated and encoded ahead
+    uint64_t seed;
+    size_t cache_bytes;        // Encoded frames kept for later passes (0 renders every pass)
+    
+    SyntheticImageOptions()
+        : width(1920), height(1080), channels(3), texture_density(2.0),
+          encoding(SyntheticEncoding::PNG), jpeg_quality(90), frame_count(100),
+          threads(0), queue_depth(16), seed(1), cache_bytes(0) {}
+};
+
+// Procedurally generated images for load testing, produced and encoded on
+// worker threads ahead of the publisher. Frame n of every pass is the same for
+// a given seed, so runs are reproducible, and frames that fit the cache budget
+// are rendered once and sent again on later passes.
+class SyntheticImageSource : public ImageSource {
+public:
+    explicit SyntheticImageSource(const SyntheticImageOptions& options);
+    ~SyntheticImageSource();
+    
+    SyntheticImageSource(const SyntheticImageSource&) = delete;
+    SyntheticImageSource& operator=(const SyntheticImageSource&) = delete;
+    
+    Result next(ImageIndexEntry& entry, std::chrono::milliseconds timeout) override;
+    bool rewind() override;
+    std::string describe() const override;
+    bool takeImage(SharedBuffer& image) override;
+    
+    // Generate and encode frame number index of a pass
+    static bool renderFrame(const SyntheticImageOptions& options, size_t index,
+                            std::vector<uint8_t>& encoded);
+                            
+private:
+    struct Slot {
+        SharedBuffer image;
+        bool ready;
+        
+        Slot() : ready(false) {}
+    };
+    
+    void worker();
+    
+    SyntheticImageOptions options_;
+    ImageCache rendered_;            // Keyed by frame number in the pass
+    
+    std::mutex mutex_;
+    std::condition_variable space_;  // A slot was consumed
+    std::condition_variable ready_;  // A slot was filled
+    std::vector<Slot> slots_;        // Frame sequence s lives in slots_[s % queue_depth]
+    uint64_t next_render_;
+    uint64_t next_consume_;
+    bool stopping_;
+    std::vector<std::thread> threads_;
+    
+    size_t returned_in_pass_;
+    SharedBuffer taken_;
+};
+
+} // namespace imaging
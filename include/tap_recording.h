@@ -0,0 +1,84 @@
+/*
+ * Tap Recording Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "shared_buffer.h"
+
+namespace imaging {
+
+// One frame of a recorded message, referencing the caller's memory
+struct TapFrame {
+    const uint8_t* data;
+    size_t size;
+};
+
+// One recorded ZeroMQ message. Frames are slices of the mapped recording.
+struct TapRecord {
+    uint64_t timestamp;  // Receive time in nanoseconds since the epoch
+    std::vector<SharedBuffer> frames;
+    
+    TapRecord() : timestamp(0) {}
+};
+
+// Appends messages to a recording file. Each record is the receive time and
+// the message's frames, each frame padded to 8 bytes so replayed frames stay
+// aligned in the mapping. Records are written with a single writev() straight
+// from the received frames. Opening an existing recording appends to it.
+class TapWriter {
+public:
+    TapWriter();
+    ~TapWriter();
+    
+    TapWriter(const TapWriter&) = delete;
+    TapWriter& operator=(const TapWriter&) = delete;
+    
+    bool open(const std::string& path);
+    void close();
+    
+    bool append(uint64_t timestamp, const TapFrame* frames, size_t count);
+    
+    uint64_t recordCount() const { return records_; }
+    uint64_t bytesWritten() const { return bytes_; }
+    
+private:
+    int fd_;
+    uint64_t records_;
+    uint64_t bytes_;
+};
+
+// Reads a recording through a memory mapping, so replayed frames are handed
+// to ZeroMQ without copying. A record cut short by a crash ends the recording.
+class TapReader {
+public:
+    TapReader();
+    
+    bool open(const std::string& path);
+    
+    // Next record, or false at the end of the recording
+    bool next(TapRecord& record);
+    
+    // Start again from the first record
+    void rewind();
+    
+    // True if reading stopped at an incomplete record
+    bool truncated() const { return truncated_; }
+    
+    // Bytes of the recording read so far
+    size_t offset() const { return offset_; }
+    
+private:
+    SharedBuffer mapping_;
+    size_t offset_;
+    bool truncated_;
+};
+
+} // namespace imaging
@@ -0,0 +1,50 @@
+/*
+ * ZeroMQ Helpers Header
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#pragma once
+
+#include <zmq.h>
+#include "shared_buffer.h"
+
+namespace imaging {
+
+// Owns a zmq_msg_t for the duration of a scope
+class ZmqMessage {
+public:
+    ZmqMessage() { zmq_msg_init(&msg_); }
+    ~ZmqMessage() { zmq_msg_close(&msg_); }
+    
+    ZmqMessage(const ZmqMessage&) = delete;
+    ZmqMessage& operator=(const ZmqMessage&) = delete;
+    
+    // Receive the next frame from a socket, replacing the current contents
+    int receive(void* socket, int flags) { return zmq_msg_recv(&msg_, socket, flags); }
+    
+    const uint8_t* data() { return static_cast<const uint8_t*>(zmq_msg_data(&msg_)); }
+    size_t size() const { return zmq_msg_size(&msg_); }
+    zmq_msg_t* get() { return &msg_; }
+    
+private:
+    zmq_msg_t msg_;
+};
+
+// Take over a received frame's bytes without copying them; message is left
+// empty and the frame is freed when the last reference is released
+SharedBuffer takeMessage(ZmqMessage& message);
+
+// Send a buffer as a single frame without copying it. ZeroMQ holds a reference
+// to the buffer's owner until the frame has left the socket. Returns the number
+// of bytes sent or -1 (errno set) like zmq_msg_send.
+int sendSharedBuffer(void* socket, const SharedBuffer& buffer, int flags);
+
+// True if the last received frame has more frames following it
+bool hasMoreFrames(void* socket);
+
+// Receive and discard any remaining frames of the current message
+void discardRemainingFrames(void* socket);
+
+} // namespace imaging
@@ -0,0 +1,75 @@
+/*
+ * Chunk Assembler Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "chunk_assembler.h"
+#include <cstring>
+
+namespace imaging {
+
+ChunkAssembler::ChunkAssembler(size_t max_image_size)
+    : max_image_size_(max_image_size), active_(false), transfer_id_(0), chunk_count_(0),
+      next_index_(0), received_(0), dropped_transfers_(0) {
+}
+
+ChunkAssembler::Result ChunkAssembler::addChunk(const ImageChunkHeader& header,
+                                                const uint8_t* data, size_t size) {
+    if (!active_ || header.transfer_id != transfer_id_) {
+        if (active_) {
+            abandon();
+        }
+        
+        // Only the first chunk can start a transfer (late joiners wait for the next image)
+        if (header.chunk_index != 0 || header.metadata.data_size > max_image_size_) {
+            return Result::DROPPED;
+        }
+        
+        buffer_.resize(header.metadata.data_size);
+        metadata_ = header.metadata;
+        transfer_id_ = header.transfer_id;
+        chunk_count_ = header.chunk_count;
+        next_index_ = 0;
+        received_ = 0;
+        active_ = true;
+    }
+    
+    if (header.chunk_index != next_index_ || header.chunk_count != chunk_count_ ||
+        header.chunk_offset != received_ || size > buffer_.size() - received_) {
+        return abandon();
+    }
+    
+    if (size > 0) {
+        std::memcpy(buffer_.data() + received_, data, size);
+    }
+    received_ += size;
+    next_index_++;
+    
+    if (next_index_ < chunk_count_) {
+        return Result::INCOMPLETE;
+    }
+    
+    active_ = false;
+    if (received_ != buffer_.size()) {
+        dropped_transfers_++;
+        return Result::DROPPED;
+    }
+    return Result::COMPLETE;
+}
+
+void ChunkAssembler::reset() {
+    if (active_) {
+        abandon();
+    }
+}
+
+ChunkAssembler::Result ChunkAssembler::abandon() {
+    active_ = false;
+    received_ = 0;
+    dropped_transfers_++;
+    return Result::DROPPED;
+}
+
+} // namespace imaging
@@ -0,0 +1,69 @@
+/*
+ * Command Line Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "command_line.h"
+#include <stdexcept>
+
+namespace imaging {
+
+CommandLine::CommandLine(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos) {
+                options_[arg.substr(2)] = "";
+            } else {
+                options_[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+            }
+        } else {
+            positional_.push_back(arg);
+        }
+    }
+}
+
+std::string CommandLine::positional(size_t index, const std::string& fallback) const {
+    return index < positional_.size() ? positional_[index] : fallback;
+}
+
+bool CommandLine::hasOption(const std::string& name) const {
+    return options_.count(name) != 0;
+}
+
+std::string CommandLine::option(const std::string& name, const std::string& fallback) const {
+    auto it = options_.find(name);
+    if (it == options_.end() || it->second.empty()) {
+        return fallback;
+    }
+    return it->second;
+}
+
+int64_t CommandLine::optionInt(const std::string& name, int64_t fallback) const {
+    auto it = options_.find(name);
+    if (it == options_.end()) {
+        return fallback;
+    }
+    try {
+        return std::stoll(it->second);
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+double CommandLine::optionDouble(const std::string& name, double fallback) const {
+    auto it = options_.find(name);
+    if (it == options_.end()) {
+        return fallback;
+    }
+    try {
+        return std::stod(it->second);
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+} // namespace imaging
@@ -0,0 +1,161 @@
+/*
+ * Compression Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "compression.h"
+#include <cstring>
+
+#ifdef IMAGING_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef IMAGING_HAVE_LZMA
+#include <lzma.h>
+#endif
+
+namespace imaging {
+
+std::string compressionCodecName(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::NONE: return "none";
+        case CompressionCodec::ZLIB: return "zlib";
+        case CompressionCodec::LZMA: return "lzma";
+        default:                     return "unknown";
+    }
+}
+
+bool parseCompressionCodec(const std::string& name, CompressionCodec& codec) {
+    if (name == "none") {
+        codec = CompressionCodec::NONE;
+    } else if (name == "zlib") {
+        codec = CompressionCodec::ZLIB;
+    } else if (name == "lzma") {
+        codec = CompressionCodec::LZMA;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool compressionAvailable(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::NONE:
+            return true;
+#ifdef IMAGING_HAVE_ZLIB
+        case CompressionCodec::ZLIB:
+            return true;
+#endif
+#ifdef IMAGING_HAVE_LZMA
+        case CompressionCodec::LZMA:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+size_t compressionBound(CompressionCodec codec, size_t size) {
+    switch (codec) {
+#ifdef IMAGING_HAVE_ZLIB
+        case CompressionCodec::ZLIB:
+            return compressBound(static_cast<uLong>(size));
+#endif
+#ifdef IMAGING_HAVE_LZMA
+        case CompressionCodec::LZMA:
+            return lzma_stream_buffer_bound(size);
+#endif
+        default:
+            return size;
+    }
+}
+
+size_t compressBytes(CompressionCodec codec, int level, const uint8_t* src, size_t size,
+                     uint8_t* dst, size_t capacity) {
+    switch (codec) {
+        case CompressionCodec::NONE:
+            if (capacity < size) {
+                return 0;
+            }
+            std::memcpy(dst, src, size);
+            return size;
+            
+#ifdef IMAGING_HAVE_ZLIB
+        case CompressionCodec::ZLIB: {
+            uLongf out_size = static_cast<uLongf>(capacity);
+            int rc = compress2(dst, &out_size, src, static_cast<uLong>(size),
+                               level < 0 ? Z_DEFAULT_COMPRESSION : level);
+            return rc == Z_OK ? static_cast<size_t>(out_size) : 0;
+        }
+#endif
+
+#ifdef IMAGING_HAVE_LZMA
+        case CompressionCodec::LZMA: {
+            size_t out_pos = 0;
+            uint32_t preset = level < 0 ? LZMA_PRESET_DEFAULT : static_cast<uint32_t>(level);
+            lzma_ret rc = lzma_easy_buffer_encode(preset, LZMA_CHECK_NONE, nullptr,
+                                                  src, size, dst, &out_pos, capacity);
+            return rc == LZMA_OK ? out_pos : 0;
+        }
+#endif
+
+        default:
+            return 0;
+    }
+}
+
+bool decompressBytes(CompressionCodec codec, const uint8_t* src, size_t size,
+                     uint8_t* dst, size_t raw_size) {
+    switch (codec) {
+        case CompressionCodec::NONE:
+            if (size != raw_size) {
+                return false;
+            }
+            std::memcpy(dst, src, size);
+            return true;
+            
+#ifdef IMAGING_HAVE_ZLIB
+        case CompressionCodec::ZLIB: {
+            uLongf out_size = static_cast<uLongf>(raw_size);
+            int rc = uncompress(dst, &out_size, src, static_cast<uLong>(size));
+            return rc == Z_OK && out_size == raw_size;
+        }
+#endif
+
+#ifdef IMAGING_HAVE_LZMA
+        case CompressionCodec::LZMA: {
+            uint64_t memlimit = UINT64_MAX;
+            size_t in_pos = 0;
+            size_t out_pos = 0;
+            lzma_ret rc = lzma_stream_buffer_decode(&memlimit, 0, nullptr, src, &in_pos, size,
+                                                    dst, &out_pos, raw_size);
+            return rc == LZMA_OK && out_pos == raw_size;
+        }
+#endif
+
+        default:
+            return false;
+    }
+}
+
+void shuffleBytes(const uint8_t* src, uint8_t* dst, size_t count, size_t element_size) {
+    for (size_t byte = 0; byte < element_size; ++byte) {
+        uint8_t* plane = dst + byte * count;
+        for (size_t i = 0; i < count; ++i) {
+            plane[i] = src[i * element_size + byte];
+        }
+    }
+}
+
+void unshuffleBytes(const uint8_t* src, uint8_t* dst, size_t count, size_t element_size) {
+    for (size_t byte = 0; byte < element_size; ++byte) {
+        const uint8_t* plane = src + byte * count;
+        for (size_t i = 0; i < count; ++i) {
+            dst[i * element_size + byte] = plane[i];
+        }
+    }
+}
+
+} // namespace imaging
@@ -0,0 +1,115 @@
+/*
+ * Content Hash Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "content_hash.h"
+#include <cstring>
+
+namespace imaging {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+inline uint64_t rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// XXH64 is defined over little-endian words
+inline uint64_t readLE64(const uint8_t* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+inline uint32_t readLE32(const uint8_t* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= round(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+uint64_t contentHash(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint8_t* end = data + size;
+    uint64_t hash;
+    
+    if (size >= 32) {
+        // Four independent lanes over 32-byte stripes
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round(v1, readLE64(data));
+            v2 = round(v2, readLE64(data + 8));
+            v3 = round(v3, readLE64(data + 16));
+            v4 = round(v4, readLE64(data + 24));
+            data += 32;
+        } while (data <= limit);
+        
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + kPrime5;
+    }
+    
+    hash += static_cast<uint64_t>(size);
+    
+    // Tail
+    while (data + 8 <= end) {
+        hash ^= round(0, readLE64(data));
+        hash = rotl(hash, 27) * kPrime1 + kPrime4;
+        data += 8;
+    }
+    if (data + 4 <= end) {
+        hash ^= static_cast<uint64_t>(readLE32(data)) * kPrime1;
+        hash = rotl(hash, 23) * kPrime2 + kPrime3;
+        data += 4;
+    }
+    while (data < end) {
+        hash ^= static_cast<uint64_t>(*data) * kPrime5;
+        hash = rotl(hash, 11) * kPrime1;
+        data++;
+    }
+    
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    
+    return hash;
+}
+
+} // namespace imaging
@@ -0,0 +1,198 @@
+/*
+ * Descriptor Encoding Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "descriptor_encoding.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace imaging {
+
+size_t descriptorElementSize(DescriptorEncoding encoding) {
+    switch (encoding) {
+        case DescriptorEncoding::UINT8:   return 1;
+        case DescriptorEncoding::FLOAT16: return 2;
+        case DescriptorEncoding::FLOAT32:
+        default:                          return 4;
+    }
+}
+
+std::string descriptorEncodingName(DescriptorEncoding encoding) {
+    switch (encoding) {
+        case DescriptorEncoding::FLOAT32: return "float32";
+        case DescriptorEncoding::UINT8:   return "uint8";
+        case DescriptorEncoding::FLOAT16: return "float16";
+        default:                          return "unknown";
+    }
+}
+
+bool parseDescriptorEncoding(const std::string& name, DescriptorEncoding& encoding) {
+    if (name == "float32") {
+        encoding = DescriptorEncoding::FLOAT32;
+    } else if (name == "uint8") {
+        encoding = DescriptorEncoding::UINT8;
+    } else if (name == "float16") {
+        encoding = DescriptorEncoding::FLOAT16;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF);
+    
+    // Infinity and NaN
+    if (exponent == 0xFF) {
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+    
+    exponent = exponent - 127 + 15;
+    if (exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+    
+    // Subnormal half (or underflow to zero)
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    
+    // Normal half; a rounding carry correctly bumps the exponent
+    uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        ++half;
+    }
+    return static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits;
+    
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Normalize the subnormal
+            int shift = 0;
+            while (!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                ++shift;
+            }
+            bits = sign | (static_cast<uint32_t>(113 - shift) << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else if (exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void encodeDescriptors(const float* src, size_t count, DescriptorEncoding encoding, uint8_t* dst) {
+    switch (encoding) {
+        case DescriptorEncoding::UINT8:
+            for (size_t i = 0; i < count; ++i) {
+                float clamped = std::min(std::max(src[i], 0.0f), 255.0f);
+                dst[i] = static_cast<uint8_t>(std::lrint(clamped));
+            }
+            break;
+            
+        case DescriptorEncoding::FLOAT16: {
+            size_t i = 0;
+#if defined(__F16C__)
+            for (; i + 8 <= count; i += 8) {
+                __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), half);
+            }
+#endif
+            for (; i < count; ++i) {
+                uint16_t half = floatToHalf(src[i]);
+                std::memcpy(dst + i * 2, &half, sizeof(half));
+            }
+            break;
+        }
+        
+        case DescriptorEncoding::FLOAT32:
+        default:
+            std::memcpy(dst, src, count * sizeof(float));
+            break;
+    }
+}
+
+void decodeDescriptors(const uint8_t* src, size_t count, DescriptorEncoding encoding,
+                       ByteOrder order, float* dst) {
+    bool native = order == nativeByteOrder();
+    
+    switch (encoding) {
+        case DescriptorEncoding::UINT8:
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = static_cast<float>(src[i]);
+            }
+            break;
+            
+        case DescriptorEncoding::FLOAT16: {
+            std::vector<uint8_t> swapped;
+            if (!native) {
+                swapped.resize(count * 2);
+                byteSwap16(swapped.data(), src, count);
+                src = swapped.data();
+            }
+            size_t i = 0;
+#if defined(__F16C__)
+            for (; i + 8 <= count; i += 8) {
+                __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+                _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half));
+            }
+#endif
+            for (; i < count; ++i) {
+                uint16_t half;
+                std::memcpy(&half, src + i * 2, sizeof(half));
+                dst[i] = halfToFloat(half);
+            }
+            break;
+        }
+        
+        case DescriptorEncoding::FLOAT32:
+        default:
+            if (native) {
+                std::memcpy(dst, src, count * sizeof(float));
+            } else {
+                byteSwap32(reinterpret_cast<uint8_t*>(dst), src, count);
+            }
+            break;
+    }
+}
+
+} // namespace imaging
@@ -0,0 +1,257 @@
+/*
+ * Flow Control Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "flow_control.h"
+#include "logger.h"
+#include <zmq.h>
+#include <algorithm>
+#include <unistd.h>
+#include <vector>
+
+namespace imaging {
+
+std::string dropPolicyName(DropPolicy policy) {
+    switch (policy) {
+        case DropPolicy::OLDEST: return "oldest";
+        case DropPolicy::NEWEST: return "newest";
+        case DropPolicy::EVERY_NTH: return "every-nth";
+    }
+    return "unknown";
+}
+
+bool parseDropPolicy(const std::string& name, DropPolicy& policy) {
+    if (name == "oldest") {
+        policy = DropPolicy::OLDEST;
+    } else if (name == "newest") {
+        policy = DropPolicy::NEWEST;
+    } else if (name == "every-nth") {
+        policy = DropPolicy::EVERY_NTH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+CreditGate::CreditGate(std::chrono::milliseconds stale_after)
+    : stale_after_(stale_after), sent_(0) {
+}
+
+void CreditGate::grant(const CreditGrant& grant, Clock::time_point now) {
+    if (grant.window == 0) {
+        return;
+    }
+    
+    // A new stage, or one that restarted its count, is assumed to have
+    // nothing in flight: everything sent so far happened before it counted
+    auto it = stages_.find(grant.stage);
+    if (it == stages_.end() || grant.consumed < it->second.consumed) {
+        Stage stage;
+        stage.offset = static_cast<int64_t>(sent_) - static_cast<int64_t>(grant.consumed);
+        stage.consumed = grant.consumed;
+        stage.limit = 0;
+        stage.last_progress = now;
+        it = stages_.insert_or_assign(grant.stage, stage).first;
+        Logger::info("Downstream stage " + grant.stage + " granted " +
+                     std::to_string(grant.window) + " credits");
+    }
+    
+    Stage& stage = it->second;
+    if (stage.limit > sent_ || grant.consumed > stage.consumed) {
+        stage.last_progress = now;
+    } else if (now - stage.last_progress > stale_after_) {
+        Logger::warning("Downstream stage " + grant.stage + " is waiting for messages "
+                        "that were lost, resetting its credit");
+        stage.offset = static_cast<int64_t>(sent_) - static_cast<int64_t>(grant.consumed);
+        stage.last_progress = now;
+    }
+    
+    stage.consumed = grant.consumed;
+    int64_t limit = static_cast<int64_t>(grant.consumed) + stage.offset + grant.window;
+    stage.limit = limit > 0 ? static_cast<uint64_t>(limit) : 0;
+    stage.last_seen = now;
+}
+
+uint64_t CreditGate::available(Clock::time_point now) {
+    expire(now);
+    if (stages_.empty()) {
+        return UINT64_MAX;
+    }
+    
+    uint64_t credit = UINT64_MAX;
+    for (const auto& entry : stages_) {
+        uint64_t limit = entry.second.limit;
+        credit = std::min(credit, limit > sent_ ? limit - sent_ : 0);
+    }
+    return credit;
+}
+
+size_t CreditGate::stageCount(Clock::time_point now) {
+    expire(now);
+    return stages_.size();
+}
+
+void CreditGate::expire(Clock::time_point now) {
+    for (auto it = stages_.begin(); it != stages_.end();) {
+        if (now - it->second.last_seen > stale_after_) {
+            Logger::warning("Downstream stage " + it->first + " went silent, no longer waiting for it");
+            it = stages_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+CreditListener::CreditListener() : socket_(nullptr) {
+}
+
+CreditListener::~CreditListener() {
+    close();
+}
+
+bool CreditListener::open(void* context, const std::string& endpoint) {
+    socket_ = zmq_socket(context, ZMQ_PULL);
+    if (!socket_) {
+        return false;
+    }
+    int linger = 0;
+    zmq_setsockopt(socket_, ZMQ_LINGER, &linger, sizeof(linger));
+    if (zmq_bind(socket_, endpoint.c_str()) != 0) {
+        Logger::error("Failed to bind credit endpoint: " + endpoint);
+        zmq_close(socket_);
+        socket_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void CreditListener::close() {
+    if (socket_) {
+        zmq_close(socket_);
+        socket_ = nullptr;
+    }
+}
+
+void CreditListener::poll(CreditGate& gate, std::chrono::milliseconds timeout) {
+    if (!socket_) {
+        return;
+    }
+    
+    zmq_pollitem_t item = {socket_, 0, ZMQ_POLLIN, 0};
+    if (zmq_poll(&item, 1, static_cast<long>(timeout.count())) <= 0) {
+        return;
+    }
+    
+    // Grants are small fixed-layout heartbeats; anything longer is not one
+    uint8_t buffer[512];
+    int received;
+    while ((received = zmq_recv(socket_, buffer, sizeof(buffer), ZMQ_DONTWAIT)) != -1) {
+        CreditGrant grant;
+        if (static_cast<size_t>(received) <= sizeof(buffer) &&
+            MessageProtocol::deserializeHeartbeat(buffer, static_cast<size_t>(received), grant)) {
+            gate.grant(grant, CreditGate::Clock::now());
+        }
+    }
+}
+
+bool CreditListener::waitForCredit(CreditGate& gate, std::chrono::milliseconds timeout) {
+    auto deadline = CreditGate::Clock::now() + timeout;
+    while (gate.available(CreditGate::Clock::now()) == 0) {
+        auto now = CreditGate::Clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+        poll(gate, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now) +
+                   std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+constexpr std::chrono::milliseconds CreditAdvertiser::kHeartbeatInterval;
+
+CreditAdvertiser::CreditAdvertiser() : socket_(nullptr), consumed_(0), stopping_(false) {
+}
+
+CreditAdvertiser::~CreditAdvertiser() {
+    close();
+}
+
+bool CreditAdvertiser::open(void* context, const std::string& endpoint, const std::string& stage,
+                            uint32_t window) {
+    close();
+    socket_ = zmq_socket(context, ZMQ_PUSH);
+    if (!socket_) {
+        return false;
+    }
+    
+    // Only the latest grant matters, so never queue up old ones
+    int hwm = 1;
+    int linger = 0;
+    zmq_setsockopt(socket_, ZMQ_SNDHWM, &hwm, sizeof(hwm));
+    zmq_setsockopt(socket_, ZMQ_LINGER, &linger, sizeof(linger));
+    if (zmq_connect(socket_, endpoint.c_str()) != 0) {
+        Logger::error("Failed to connect credit endpoint: " + endpoint);
+        zmq_close(socket_);
+        socket_ = nullptr;
+        return false;
+    }
+    
+    grant_ = CreditGrant();
+    grant_.stage = stage + ":" + std::to_string(getpid());
+    grant_.window = window;
+    consumed_ = 0;
+    stopping_ = false;
+    thread_ = std::thread(&CreditAdvertiser::run, this);
+    return true;
+}
+
+void CreditAdvertiser::close() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_one();
+        thread_.join();
+    }
+    if (socket_) {
+        zmq_close(socket_);
+        socket_ = nullptr;
+    }
+}
+
+void CreditAdvertiser::consumed(uint64_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        consumed_ += count;
+    }
+    changed_.notify_one();
+}
+
+void CreditAdvertiser::run() {
+    uint64_t advertised = UINT64_MAX;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        changed_.wait_for(lock, kHeartbeatInterval, [&] {
+            return stopping_ || consumed_ != advertised;
+        });
+        if (stopping_) {
+            break;
+        }
+        
+        // Sent on every change and as a heartbeat when idle; a grant that
+        // cannot be sent right now is superseded by the next one
+        advertised = consumed_;
+        grant_.consumed = advertised;
+        grant_.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+        std::vector<uint8_t> message = MessageProtocol::serializeHeartbeat(grant_);
+        lock.unlock();
+        zmq_send(socket_, message.data(), message.size(), ZMQ_DONTWAIT);
+        lock.lock();
+    }
+}
+
+} // namespace imaging
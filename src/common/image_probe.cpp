@@ -0,0 +1,284 @@
+/*
+ * Image Probe Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_probe.h"
+#include <cstring>
+
+namespace imaging {
+
+namespace {
+
+uint16_t readU16(const uint8_t* p, bool big_endian) {
+    return big_endian ? static_cast<uint16_t>((p[0] << 8) | p[1]) :
+                        static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readU32(const uint8_t* p, bool big_endian) {
+    return big_endian ?
+        (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+        (static_cast<uint32_t>(p[2]) << 8) | p[3] :
+        p[0] | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool probePng(const uint8_t* data, size_t size, ImageDimensions& dimensions) {
+    // Signature, then IHDR must be the first chunk
+    if (size < 33 || std::memcmp(data + 12, "IHDR", 4) != 0) {
+        return false;
+    }
+    
+    uint32_t width = readU32(data + 16, true);
+    uint32_t height = readU32(data + 20, true);
+    uint8_t color_type = data[25];
+    
+    bool transparency = false;
+    if (color_type == 2 || color_type == 3) {
+        // RGB and palette images gain an alpha channel from a tRNS chunk,
+        // which has to come before the first IDAT
+        size_t offset = 33;
+        while (true) {
+            if (offset + 8 > size) {
+                return false;
+            }
+            uint32_t length = readU32(data + offset, true);
+            const uint8_t* type = data + offset + 4;
+            if (std::memcmp(type, "IDAT", 4) == 0 || std::memcmp(type, "IEND", 4) == 0) {
+                break;
+            }
+            if (std::memcmp(type, "tRNS", 4) == 0) {
+                transparency = length > 0;
+                break;
+            }
+            offset += 12 + static_cast<size_t>(length);
+        }
+    }
+    
+    switch (color_type) {
+        case 0: dimensions.channels = 1; break;                   // Grey
+        case 2:                                                   // RGB
+        case 3: dimensions.channels = transparency ? 4 : 3; break; // Palette
+        case 4:                                                   // Grey + alpha
+        case 6: dimensions.channels = 4; break;                   // RGBA
+        default: return false;
+    }
+    
+    dimensions.width = width;
+    dimensions.height = height;
+    return width > 0 && height > 0;
+}
+
+bool probeJpeg(const uint8_t* data, size_t size, ImageDimensions& dimensions) {
+    // Walk the marker segments up to the start-of-frame
+    size_t offset = 2;
+    while (offset + 4 <= size) {
+        if (data[offset] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = data[offset + 1];
+        if (marker == 0xFF) {
+            offset++;  // Fill byte
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            offset += 2;  // Standalone markers have no length
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            return false;  // No frame header before the scan
+        }
+        
+        uint16_t length = readU16(data + offset + 2, true);
+        if (length < 2) {
+            return false;
+        }
+        
+        // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF &&
+            marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (length < 8 || offset + 10 > size) {
+                return false;
+            }
+            dimensions.height = readU16(data + offset + 5, true);
+            dimensions.width = readU16(data + offset + 7, true);
+            // OpenCV converts YCbCr and CMYK to BGR
+            dimensions.channels = data[offset + 9] == 1 ? 1 : 3;
+            // A zero height is only given later in a DNL segment
+            return dimensions.width > 0 && dimensions.height > 0;
+        }
+        
+        offset += 2 + static_cast<size_t>(length);
+    }
+    return false;
+}
+
+bool probeBmp(const uint8_t* data, size_t size, ImageDimensions& dimensions) {
+    if (size < 18) {
+        return false;
+    }
+    
+    uint32_t header_size = readU32(data + 14, false);
+    int64_t width;
+    int64_t height;
+    uint16_t bits_per_pixel;
+    uint32_t compression = 0;
+    uint32_t colors_used = 0;
+    size_t palette_entry_size = 4;
+    
+    if (header_size == 12) {
+        // OS/2 BITMAPCOREHEADER
+        if (size < 26) {
+            return false;
+        }
+        width = readU16(data + 18, false);
+        height = readU16(data + 20, false);
+        bits_per_pixel = readU16(data + 24, false);
+        palette_entry_size = 3;
+    } else if (header_size == 40 || header_size == 52 || header_size == 56 ||
+               header_size == 108 || header_size == 124) {
+        // BITMAPINFOHEADER and its V2..V5 extensions
+        if (size < 50) {
+            return false;
+        }
+        width = static_cast<int32_t>(readU32(data + 18, false));
+        height = static_cast<int32_t>(readU32(data + 22, false));
+        bits_per_pixel = readU16(data + 28, false);
+        compression = readU32(data + 30, false);
+        colors_used = readU32(data + 46, false);
+    } else {
+        return false;
+    }
+    
+    // Negative heights mark top-down bitmaps
+    if (height < 0) {
+        height = -height;
+    }
+    if (width <= 0 || height == 0 || width > UINT32_MAX || height > UINT32_MAX) {
+        return false;
+    }
+    
+    if (bits_per_pixel <= 8) {
+        // Palette images load as grey when every palette entry is grey
+        if (bits_per_pixel != 1 && bits_per_pixel != 4 && bits_per_pixel != 8) {
+            return false;
+        }
+        uint32_t max_colors = 1u << bits_per_pixel;
+        uint32_t colors = (colors_used == 0 || colors_used > max_colors) ? max_colors : colors_used;
+        size_t palette = 14 + static_cast<size_t>(header_size);
+        if (palette + colors * palette_entry_size > size) {
+            return false;
+        }
+        dimensions.channels = 1;
+        for (uint32_t i = 0; i < colors; ++i) {
+            const uint8_t* entry = data + palette + i * palette_entry_size;
+            if (entry[0] != entry[1] || entry[0] != entry[2]) {
+                dimensions.channels = 3;
+                break;
+            }
+        }
+    } else if (bits_per_pixel == 16 || bits_per_pixel == 24) {
+        dimensions.channels = 3;
+    } else if (bits_per_pixel == 32) {
+        // Only bit-field encoded 32-bit images keep their alpha channel
+        dimensions.channels = compression == 0 ? 3 : 4;
+    } else {
+        return false;
+    }
+    
+    dimensions.width = static_cast<uint32_t>(width);
+    dimensions.height = static_cast<uint32_t>(height);
+    return true;
+}
+
+bool probeTiff(const uint8_t* data, size_t size, ImageDimensions& dimensions) {
+    bool big_endian = data[0] == 'M';
+    uint32_t ifd = readU32(data + 4, big_endian);
+    if (static_cast<size_t>(ifd) + 2 > size) {
+        return false;
+    }
+    
+    uint16_t entries = readU16(data + ifd, big_endian);
+    if (static_cast<size_t>(ifd) + 2 + entries * 12u > size) {
+        return false;
+    }
+    
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t samples_per_pixel = 1;
+    uint32_t photometric = UINT32_MAX;
+    
+    for (uint16_t i = 0; i < entries; ++i) {
+        const uint8_t* entry = data + ifd + 2 + i * 12u;
+        uint16_t tag = readU16(entry, big_endian);
+        uint16_t type = readU16(entry + 2, big_endian);
+        uint32_t count = readU32(entry + 4, big_endian);
+        
+        // Only single SHORT or LONG values, which are stored inline
+        uint32_t value;
+        if (count == 1 && type == 3) {
+            value = readU16(entry + 8, big_endian);
+        } else if (count == 1 && type == 4) {
+            value = readU32(entry + 8, big_endian);
+        } else {
+            continue;
+        }
+        
+        switch (tag) {
+            case 256: width = value; break;              // ImageWidth
+            case 257: height = value; break;             // ImageLength
+            case 262: photometric = value; break;        // PhotometricInterpretation
+            case 277: samples_per_pixel = value; break;  // SamplesPerPixel
+            default: break;
+        }
+    }
+    
+    if (photometric == 0 || photometric == 1) {
+        // Grey with extra samples is left to the decoder
+        if (samples_per_pixel != 1) {
+            return false;
+        }
+        dimensions.channels = 1;
+    } else if (photometric == 2 && (samples_per_pixel == 3 || samples_per_pixel == 4)) {
+        dimensions.channels = samples_per_pixel;
+    } else if (photometric == 3) {
+        dimensions.channels = 3;  // Palette expands to BGR
+    } else {
+        return false;  // CMYK, YCbCr, CIELab, ... are decoder dependent
+    }
+    
+    dimensions.width = width;
+    dimensions.height = height;
+    return width > 0 && height > 0;
+}
+
+} // namespace
+
+bool probeImageDimensions(const uint8_t* data, size_t size, ImageDimensions& dimensions) {
+    static const uint8_t kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    
+    if (!data || size < 8) {
+        return false;
+    }
+    
+    ImageDimensions probed;
+    bool ok = false;
+    if (std::memcmp(data, kPngSignature, sizeof(kPngSignature)) == 0) {
+        ok = probePng(data, size, probed);
+    } else if (data[0] == 0xFF && data[1] == 0xD8) {
+        ok = probeJpeg(data, size, probed);
+    } else if (data[0] == 'B' && data[1] == 'M') {
+        ok = probeBmp(data, size, probed);
+    } else if ((std::memcmp(data, "II*\0", 4) == 0) || (std::memcmp(data, "MM\0*", 4) == 0)) {
+        ok = probeTiff(data, size, probed);
+    }
+    
+    if (ok) {
+        dimensions = probed;
+    }
+    return ok;
+}
+
+} // namespace imaging
@@ -0,0 +1,110 @@
+/*
+ * Image Receiver Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_receiver.h"
+#include "logger.h"
+
+namespace imaging {
+
+ImageReceiver::ImageReceiver(const std::string& endpoint)
+    : shm_(isShmEndpoint(endpoint)), pool_(nullptr) {
+    if (shm_) {
+        shm_subscriber_.open(endpoint);
+    }
+}
+
+int ImageReceiver::receive(void* socket, int flags, ImageDataView& image) {
+    if (frame_.receive(socket, flags) == -1) {
+        return -1;
+    }
+    
+    if (frame_.size() == 0) {
+        discardRemainingFrames(socket);
+        return 0;
+    }
+    
+    // With shared memory the frame is only a descriptor of the message in the ring
+    const uint8_t* frame_data = frame_.data();
+    size_t frame_size = frame_.size();
+    if (shm_ && !shm_subscriber_.resolve(frame_.data(), frame_.size(), frame_data, frame_size)) {
+        Logger::warning("Shared memory frame unavailable or already overwritten");
+        return 0;
+    }
+    
+    if (MessageProtocol::getMessageType(frame_data, frame_size) == MessageType::IMAGE_CHUNK) {
+        // Streamed image: append this chunk and wait until the last one arrives
+        ImageChunkHeader chunk;
+        bool ok = hasMoreFrames(socket) &&
+                  payload_.receive(socket, 0) != -1 &&
+                  MessageProtocol::deserializeImageChunkHeader(frame_data, frame_size, chunk);
+        discardRemainingFrames(socket);
+        
+        if (!ok) {
+            Logger::error("Failed to deserialize image chunk");
+            return 0;
+        }
+        
+        ChunkAssembler::Result result = assembler_.addChunk(chunk, payload_.data(), payload_.size());
+        if (result == ChunkAssembler::Result::DROPPED) {
+            Logger::warning("Dropped chunk " + std::to_string(chunk.chunk_index) +
+                            " of " + chunk.metadata.filename);
+        }
+        if (result != ChunkAssembler::Result::COMPLETE) {
+            return 0;
+        }
+        image.metadata = assembler_.metadata();
+        image.image_data = assembler_.data();
+        image.image_size = assembler_.size();
+        return 1;
+    }
+    
+    if (hasMoreFrames(socket)) {
+        // Multipart: header frame followed by the image payload frame
+        bool ok = payload_.receive(socket, 0) != -1 &&
+                  MessageProtocol::deserializeImageHeader(frame_data, frame_size, image.metadata) &&
+                  payload_.size() == image.metadata.data_size;
+        discardRemainingFrames(socket);
+        
+        if (!ok) {
+            Logger::error("Failed to deserialize image data");
+            return 0;
+        }
+        image.image_data = payload_.data();
+        image.image_size = payload_.size();
+        return 1;
+    }
+    
+    if (!MessageProtocol::parseImageData(frame_data, frame_size, image)) {
+        Logger::error("Failed to deserialize image data");
+        return 0;
+    }
+    return 1;
+}
+
+bool ImageReceiver::intact() const {
+    return !shm_ || shm_subscriber_.intact();
+}
+
+SharedBuffer ImageReceiver::detach(const ImageDataView& image) {
+    if (image.image_size > 0 && image.image_data == payload_.data()) {
+        return takeMessage(payload_);
+    }
+    
+    // Single-frame message: keep the whole frame alive for the image inside it
+    const uint8_t* frame_data = frame_.data();
+    if (!shm_ && image.image_size > 0 && image.image_data >= frame_data &&
+        image.image_data + image.image_size <= frame_data + frame_.size()) {
+        size_t offset = static_cast<size_t>(image.image_data - frame_data);
+        return takeMessage(frame_).slice(offset, image.image_size);
+    }
+    if (pool_) {
+        return pool_->copy(image.image_data, image.image_size);
+    }
+    return SharedBuffer(std::vector<uint8_t>(image.image_data, image.image_data + image.image_size));
+}
+
+} // namespace imaging
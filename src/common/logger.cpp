@@ -6,9 +6,18 @@
  */
 
 #include "logger.h"
+#include <ctime>
+#include <mutex>
 
 namespace imaging {
 
+namespace {
+
+// Lines from different threads must not interleave
+std::mutex g_output_mutex;
+
+} // namespace
+
 LogLevel Logger::current_level_ = LogLevel::INFO;
 
 void Logger::setLevel(LogLevel level) {
@@ -20,9 +29,9 @@ void Logger::log(LogLevel level, const std::string& message) {
         return;
     }
     
-    std::cout << "[" << getCurrentTimestamp() << "] "
-              << "[" << levelToString(level) << "] "
-              << message << std::endl;
+    std::string line = "[" + getCurrentTimestamp() + "] [" + levelToString(level) + "] " + message;
+    std::lock_guard<std::mutex> lock(g_output_mutex);
+    std::cout << line << std::endl;
 }
 
 void Logger::debug(const std::string& message) {
@@ -57,8 +66,11 @@ std::string Logger::getCurrentTimestamp() {
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         now.time_since_epoch()) % 1000;
     
+    std::tm local;
+    localtime_r(&time, &local);
+    
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
+    ss << std::put_time(&local, "%Y-%m-%d %H:%M:%S");
     ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
     return ss.str();
 }
@@ -6,34 +6,80 @@
  */
 
 #include "message_protocol.h"
+#include "compression.h"
+#include "content_hash.h"
 #include <cstring>
 #include <chrono>
+#include <type_traits>
 
 namespace imaging {
 
+// Keypoint arrays are copied as raw 32-bit words
+static_assert(sizeof(int) == 4, "KeyPoint::octave must be 32 bits");
+static_assert(sizeof(KeyPoint) == 24 && std::is_standard_layout<KeyPoint>::value,
+              "KeyPoint must be six packed 32-bit fields");
+
 // Helper function implementations
-void MessageProtocol::writeUint32(std::vector<uint8_t>& buffer, uint32_t value) {
-    buffer.push_back((value >> 24) & 0xFF);
-    buffer.push_back((value >> 16) & 0xFF);
-    buffer.push_back((value >> 8) & 0xFF);
-    buffer.push_back(value & 0xFF);
+void MessageProtocol::writeUint32(uint8_t* data, size_t& offset, uint32_t value) {
+    data[offset] = (value >> 24) & 0xFF;
+    data[offset + 1] = (value >> 16) & 0xFF;
+    data[offset + 2] = (value >> 8) & 0xFF;
+    data[offset + 3] = value & 0xFF;
+    offset += 4;
 }
 
-void MessageProtocol::writeUint64(std::vector<uint8_t>& buffer, uint64_t value) {
-    for (int i = 7; i >= 0; --i) {
-        buffer.push_back((value >> (i * 8)) & 0xFF);
+void MessageProtocol::writeUint64(uint8_t* data, size_t& offset, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        data[offset + i] = (value >> ((7 - i) * 8)) & 0xFF;
     }
+    offset += 8;
 }
 
-void MessageProtocol::writeFloat(std::vector<uint8_t>& buffer, float value) {
+void MessageProtocol::writeFloat(uint8_t* data, size_t& offset, float value) {
     uint32_t temp;
     std::memcpy(&temp, &value, sizeof(float));
-    writeUint32(buffer, temp);
+    writeUint32(data, offset, temp);
+}
+
+void MessageProtocol::writeString(uint8_t* data, size_t& offset, const std::string& str) {
+    writeUint32(data, offset, static_cast<uint32_t>(str.size()));
+    writeBytes(data, offset, str.data(), str.size());
+}
+
+void MessageProtocol::writeBytes(uint8_t* data, size_t& offset, const void* bytes, size_t size) {
+    if (size > 0) {
+        std::memcpy(data + offset, bytes, size);
+    }
+    offset += size;
+}
+
+void MessageProtocol::writeArray(uint8_t* data, size_t& offset, const void* array, size_t bytes,
+                                 ByteOrder order) {
+    if (order == nativeByteOrder()) {
+        writeBytes(data, offset, array, bytes);
+        return;
+    }
+    byteSwap32(data + offset, static_cast<const uint8_t*>(array), bytes / 4);
+    offset += bytes;
 }
 
-void MessageProtocol::writeString(std::vector<uint8_t>& buffer, const std::string& str) {
-    writeUint32(buffer, static_cast<uint32_t>(str.size()));
-    buffer.insert(buffer.end(), str.begin(), str.end());
+void MessageProtocol::writeDescriptors(uint8_t* data, size_t& offset,
+                                       const std::vector<float>& descriptors,
+                                       const ProcessedDataOptions& options) {
+    if (options.descriptor_encoding == DescriptorEncoding::FLOAT32) {
+        writeArray(data, offset, descriptors.data(), descriptors.size() * sizeof(float),
+                   options.byte_order);
+        return;
+    }
+    
+    // Quantize straight into the output buffer
+    uint8_t* dst = data + offset;
+    encodeDescriptors(descriptors.data(), descriptors.size(), options.descriptor_encoding, dst);
+    if (options.descriptor_encoding == DescriptorEncoding::FLOAT16 &&
+        options.byte_order != nativeByteOrder()) {
+        byteSwap16(dst, dst, descriptors.size());
+    }
+    offset += descriptors.size() * descriptorElementSize(options.descriptor_encoding);
 }
 
 uint32_t MessageProtocol::readUint32(const uint8_t* data, size_t& offset) {
@@ -61,6 +107,18 @@ float MessageProtocol::readFloat(const uint8_t* data, size_t& offset) {
     return value;
 }
 
+void MessageProtocol::readArray(void* dst, const uint8_t* src, size_t bytes, ByteOrder order) {
+    if (bytes == 0) {
+        return;
+    }
+    
+    if (order == nativeByteOrder()) {
+        std::memcpy(dst, src, bytes);
+    } else {
+        byteSwap32(static_cast<uint8_t*>(dst), src, bytes / 4);
+    }
+}
+
 std::string MessageProtocol::readString(const uint8_t* data, size_t& offset, size_t max_length) {
     uint32_t length = readUint32(data, offset);
     if (length > max_length) {
@@ -71,28 +129,88 @@ std::string MessageProtocol::readString(const uint8_t* data, size_t& offset, siz
     return str;
 }
 
+size_t MessageProtocol::metadataSize(const ImageMetadata& metadata) {
+    return 28 + metadata.filename.size();
+}
+
+void MessageProtocol::writeMetadata(uint8_t* data, size_t& offset, const ImageMetadata& metadata) {
+    writeUint64(data, offset, metadata.timestamp);
+    writeUint32(data, offset, metadata.width);
+    writeUint32(data, offset, metadata.height);
+    writeUint32(data, offset, metadata.channels);
+    writeUint32(data, offset, metadata.data_size);
+    writeString(data, offset, metadata.filename);
+}
+
+bool MessageProtocol::readMetadata(const uint8_t* data, size_t size, size_t& offset,
+                                   ImageMetadata& metadata) {
+    // Fixed fields plus the filename length prefix
+    if (offset + 28 > size) {
+        return false;
+    }
+    metadata.timestamp = readUint64(data, offset);
+    metadata.width = readUint32(data, offset);
+    metadata.height = readUint32(data, offset);
+    metadata.channels = readUint32(data, offset);
+    metadata.data_size = readUint32(data, offset);
+    
+    size_t length_offset = offset;
+    uint32_t filename_length = readUint32(data, length_offset);
+    if (filename_length > 256 || length_offset + filename_length > size) {
+        return false;
+    }
+    metadata.filename = readString(data, offset, 256);
+    return true;
+}
+
 // Serialize image data message
 std::vector<uint8_t> MessageProtocol::serializeImageData(
     const ImageMetadata& metadata,
     const std::vector<uint8_t>& image_data) {
     
     std::vector<uint8_t> buffer;
+    serializeImageDataInto(buffer, metadata, image_data.data(), image_data.size());
+    return buffer;
+}
+
+size_t MessageProtocol::imageDataSize(const ImageMetadata& metadata, size_t image_size) {
+    return 1 + metadataSize(metadata) + image_size;
+}
+
+size_t MessageProtocol::serializeImageDataInto(
+    std::vector<uint8_t>& buffer,
+    const ImageMetadata& metadata,
+    const uint8_t* image_data,
+    size_t image_size) {
+    
+    // Exact size up front: no reallocation once the buffer has grown to fit
+    buffer.resize(imageDataSize(metadata, image_size));
+    return serializeImageDataInto(buffer.data(), buffer.size(), metadata, image_data, image_size);
+}
+
+size_t MessageProtocol::serializeImageDataInto(
+    uint8_t* data,
+    size_t capacity,
+    const ImageMetadata& metadata,
+    const uint8_t* image_data,
+    size_t image_size) {
+    
+    if (capacity < imageDataSize(metadata, image_size)) {
+        return 0;
+    }
+    
+    size_t offset = 0;
     
     // Message type
-    buffer.push_back(static_cast<uint8_t>(MessageType::IMAGE_DATA));
+    data[offset++] = static_cast<uint8_t>(MessageType::IMAGE_DATA);
     
     // Metadata
-    writeUint64(buffer, metadata.timestamp);
-    writeUint32(buffer, metadata.width);
-    writeUint32(buffer, metadata.height);
-    writeUint32(buffer, metadata.channels);
-    writeUint32(buffer, metadata.data_size);
-    writeString(buffer, metadata.filename);
+    writeMetadata(data, offset, metadata);
     
     // Image data
-    buffer.insert(buffer.end(), image_data.begin(), image_data.end());
+    writeBytes(data, offset, image_data, image_size);
     
-    return buffer;
+    return offset;
 }
 
 // Deserialize image data message
@@ -101,32 +219,150 @@ bool MessageProtocol::deserializeImageData(
     ImageMetadata& metadata,
     std::vector<uint8_t>& image_data) {
     
-    if (message.size() < 30) {  // Minimum size check
+    ImageDataView view;
+    if (!parseImageData(message.data(), message.size(), view)) {
+        return false;
+    }
+    
+    metadata = view.metadata;
+    image_data.assign(view.image_data, view.image_data + view.image_size);
+    
+    return true;
+}
+
+// Parse image data message in place
+bool MessageProtocol::parseImageData(const uint8_t* data, size_t size, ImageDataView& view) {
+    if (size < 30) {  // Minimum size check
         return false;
     }
     
     size_t offset = 0;
     
     // Check message type
-    MessageType type = static_cast<MessageType>(message[offset++]);
+    MessageType type = static_cast<MessageType>(data[offset++]);
     if (type != MessageType::IMAGE_DATA) {
         return false;
     }
     
     // Deserialize metadata
-    metadata.timestamp = readUint64(message.data(), offset);
-    metadata.width = readUint32(message.data(), offset);
-    metadata.height = readUint32(message.data(), offset);
-    metadata.channels = readUint32(message.data(), offset);
-    metadata.data_size = readUint32(message.data(), offset);
-    metadata.filename = readString(message.data(), offset, 256);
+    if (!readMetadata(data, size, offset, view.metadata)) {
+        return false;
+    }
+    
+    // Reference image data
+    if (offset + view.metadata.data_size > size) {
+        return false;
+    }
+    view.image_data = data + offset;
+    view.image_size = view.metadata.data_size;
+    
+    return true;
+}
+
+// Serialize multipart image header frame
+std::vector<uint8_t> MessageProtocol::serializeImageHeader(const ImageMetadata& metadata) {
+    std::vector<uint8_t> buffer(1 + metadataSize(metadata));
+    size_t offset = 0;
+    
+    buffer[offset++] = static_cast<uint8_t>(MessageType::IMAGE_DATA);
+    writeMetadata(buffer.data(), offset, metadata);
+    
+    return buffer;
+}
+
+// Deserialize multipart image header frame
+bool MessageProtocol::deserializeImageHeader(
+    const uint8_t* data,
+    size_t size,
+    ImageMetadata& metadata) {
+    
+    if (size < 29) {
+        return false;
+    }
+    
+    size_t offset = 0;
+    
+    MessageType type = static_cast<MessageType>(data[offset++]);
+    if (type != MessageType::IMAGE_DATA) {
+        return false;
+    }
+    
+    return readMetadata(data, size, offset, metadata);
+}
+
+// Serialize image chunk header frame
+std::vector<uint8_t> MessageProtocol::serializeImageChunkHeader(const ImageChunkHeader& header) {
+    std::vector<uint8_t> buffer(17 + metadataSize(header.metadata));
+    size_t offset = 0;
+    
+    buffer[offset++] = static_cast<uint8_t>(MessageType::IMAGE_CHUNK);
+    writeUint32(buffer.data(), offset, header.transfer_id);
+    writeUint32(buffer.data(), offset, header.chunk_index);
+    writeUint32(buffer.data(), offset, header.chunk_count);
+    writeUint32(buffer.data(), offset, header.chunk_offset);
+    writeMetadata(buffer.data(), offset, header.metadata);
+    
+    return buffer;
+}
+
+// Deserialize image chunk header frame
+bool MessageProtocol::deserializeImageChunkHeader(
+    const uint8_t* data,
+    size_t size,
+    ImageChunkHeader& header) {
     
-    // Deserialize image data
-    if (offset + metadata.data_size > message.size()) {
+    if (size < 45) {
         return false;
     }
     
-    image_data.assign(message.begin() + offset, message.begin() + offset + metadata.data_size);
+    size_t offset = 0;
+    
+    MessageType type = static_cast<MessageType>(data[offset++]);
+    if (type != MessageType::IMAGE_CHUNK) {
+        return false;
+    }
+    
+    header.transfer_id = readUint32(data, offset);
+    header.chunk_index = readUint32(data, offset);
+    header.chunk_count = readUint32(data, offset);
+    header.chunk_offset = readUint32(data, offset);
+    if (!readMetadata(data, size, offset, header.metadata)) {
+        return false;
+    }
+    
+    return header.chunk_index < header.chunk_count &&
+           header.chunk_offset <= header.metadata.data_size;
+}
+
+// Serialize shared-memory descriptor
+std::vector<uint8_t> MessageProtocol::serializeShmDescriptor(const ShmDescriptor& descriptor) {
+    std::vector<uint8_t> buffer(29);
+    size_t offset = 0;
+    
+    buffer[offset++] = static_cast<uint8_t>(MessageType::SHM_DESCRIPTOR);
+    writeUint64(buffer.data(), offset, descriptor.generation);
+    writeUint64(buffer.data(), offset, descriptor.sequence);
+    writeUint64(buffer.data(), offset, descriptor.offset);
+    writeUint32(buffer.data(), offset, descriptor.length);
+    
+    return buffer;
+}
+
+// Deserialize shared-memory descriptor
+bool MessageProtocol::deserializeShmDescriptor(
+    const uint8_t* data,
+    size_t size,
+    ShmDescriptor& descriptor) {
+    
+    if (size != 29 || static_cast<MessageType>(data[0]) != MessageType::SHM_DESCRIPTOR) {
+        return false;
+    }
+    
+    size_t offset = 1;
+    descriptor.generation = readUint64(data, offset);
+    descriptor.sequence = readUint64(data, offset);
+    descriptor.offset = readUint64(data, offset);
+    descriptor.length = readUint32(data, offset);
     
     return true;
 }
@@ -136,42 +372,261 @@ std::vector<uint8_t> MessageProtocol::serializeProcessedData(
     const ImageMetadata& metadata,
     const std::vector<uint8_t>& image_data,
     const std::vector<KeyPoint>& keypoints,
-    const std::vector<float>& descriptors) {
+    const std::vector<float>& descriptors,
+    const ProcessedDataOptions& options) {
+    
+    return serializeProcessedData(metadata, image_data.data(), image_data.size(),
+                                  keypoints, descriptors, options);
+}
+
+std::vector<uint8_t> MessageProtocol::serializeProcessedData(
+    const ImageMetadata& metadata,
+    const uint8_t* image_data,
+    size_t image_size,
+    const std::vector<KeyPoint>& keypoints,
+    const std::vector<float>& descriptors,
+    const ProcessedDataOptions& options) {
     
     std::vector<uint8_t> buffer;
+    serializeProcessedDataInto(buffer, metadata, image_data, image_size,
+                               keypoints, descriptors, options);
+    return buffer;
+}
+
+size_t MessageProtocol::processedDataSize(
+    const ImageMetadata& metadata,
+    size_t image_size,
+    size_t num_keypoints,
+    size_t num_descriptors,
+    const ProcessedDataOptions& options) {
     
-    // Message type
-    buffer.push_back(static_cast<uint8_t>(MessageType::PROCESSED_DATA));
+    size_t section_size = featureSectionSize(num_keypoints, num_descriptors, options);
+    if (options.compression != CompressionCodec::NONE) {
+        // Codec, raw size and compressed size, then the worst-case payload
+        section_size = 9 + compressionBound(options.compression, section_size);
+    }
+    size_t image_section = options.image_by_reference ? 8 : image_size;
+    return 3 + metadataSize(metadata) + image_section + section_size;
+}
+
+size_t MessageProtocol::featureSectionSize(size_t num_keypoints, size_t num_descriptors,
+                                           const ProcessedDataOptions& options) {
+    return 4 + num_keypoints * sizeof(KeyPoint) +
+           5 + num_descriptors * descriptorElementSize(options.descriptor_encoding);
+}
+
+size_t MessageProtocol::serializeProcessedDataInto(
+    std::vector<uint8_t>& buffer,
+    const ImageMetadata& metadata,
+    const uint8_t* image_data,
+    size_t image_size,
+    const std::vector<KeyPoint>& keypoints,
+    const std::vector<float>& descriptors,
+    const ProcessedDataOptions& options) {
+    
+    buffer.resize(processedDataSize(metadata, image_size, keypoints.size(),
+                                    descriptors.size(), options));
+    size_t written = serializeProcessedDataInto(buffer.data(), buffer.size(), metadata, image_data,
+                                                image_size, keypoints, descriptors, options);
+    
+    // Compressed messages come in under the bound; shrinking keeps the capacity
+    buffer.resize(written);
+    return written;
+}
+
+size_t MessageProtocol::serializeProcessedDataInto(
+    uint8_t* data,
+    size_t capacity,
+    const ImageMetadata& metadata,
+    const uint8_t* image_data,
+    size_t image_size,
+    const std::vector<KeyPoint>& keypoints,
+    const std::vector<float>& descriptors,
+    const ProcessedDataOptions& options) {
+    
+    size_t required = processedDataSize(metadata, image_size, keypoints.size(),
+                                        descriptors.size(), options);
+    if (capacity < required) {
+        return 0;
+    }
+    
+    size_t offset = 0;
+    
+    bool compressed = options.compression != CompressionCodec::NONE;
+    
+    // Message type, version and flags
+    uint8_t flags = options.byte_order == ByteOrder::LITTLE_ENDIAN_ORDER ?
+                    kFlagLittleEndianArrays : 0;
+    if (compressed) {
+        flags |= kFlagCompressedFeatures;
+    }
+    if (options.image_by_reference) {
+        flags |= kFlagImageByReference;
+    }
+    data[offset++] = static_cast<uint8_t>(MessageType::PROCESSED_DATA);
+    data[offset++] = kProtocolVersion;
+    data[offset++] = flags;
     
     // Metadata
-    writeUint64(buffer, metadata.timestamp);
-    writeUint32(buffer, metadata.width);
-    writeUint32(buffer, metadata.height);
-    writeUint32(buffer, metadata.channels);
-    writeUint32(buffer, metadata.data_size);
-    writeString(buffer, metadata.filename);
+    writeMetadata(data, offset, metadata);
     
-    // Image data
-    buffer.insert(buffer.end(), image_data.begin(), image_data.end());
+    // Image data (already compressed by its file format, so never recompressed),
+    // or just its hash; metadata.data_size still gives the image size
+    if (options.image_by_reference) {
+        writeUint64(data, offset, contentHash(image_data, image_size));
+    } else {
+        writeBytes(data, offset, image_data, image_size);
+    }
+    
+    if (!compressed) {
+        writeFeatureSection(data, offset, keypoints, descriptors, options);
+        return offset;
+    }
+    
+    // Build the feature section in scratch space, filter it and compress it
+    // straight into the output. Scratch is per thread and keeps its capacity.
+    thread_local std::vector<uint8_t> section;
+    thread_local std::vector<uint8_t> packed;
+    size_t raw_size = featureSectionSize(keypoints.size(), descriptors.size(), options);
+    section.resize(raw_size);
+    packed.resize(raw_size);
+    
+    size_t section_offset = 0;
+    writeFeatureSection(section.data(), section_offset, keypoints, descriptors, options);
+    packFeatureSection(section.data(), raw_size, options.byte_order, packed.data());
+    
+    data[offset++] = static_cast<uint8_t>(options.compression);
+    writeUint32(data, offset, static_cast<uint32_t>(raw_size));
+    size_t size_offset = offset;
+    offset += 4;
     
-    // Keypoints
-    writeUint32(buffer, static_cast<uint32_t>(keypoints.size()));
-    for (const auto& kp : keypoints) {
-        writeFloat(buffer, kp.x);
-        writeFloat(buffer, kp.y);
-        writeFloat(buffer, kp.size);
-        writeFloat(buffer, kp.angle);
-        writeFloat(buffer, kp.response);
-        writeUint32(buffer, static_cast<uint32_t>(kp.octave));
+    size_t compressed_size = compressBytes(options.compression, options.compression_level,
+                                           packed.data(), raw_size,
+                                           data + offset, capacity - offset);
+    if (compressed_size == 0) {
+        return 0;
     }
+    writeUint32(data, size_offset, static_cast<uint32_t>(compressed_size));
+    
+    return offset + compressed_size;
+}
+
+void MessageProtocol::writeFeatureSection(uint8_t* data, size_t& offset,
+                                          const std::vector<KeyPoint>& keypoints,
+                                          const std::vector<float>& descriptors,
+                                          const ProcessedDataOptions& options) {
+    // Keypoints (bulk copy, swapped only if a foreign byte order was requested)
+    writeUint32(data, offset, static_cast<uint32_t>(keypoints.size()));
+    writeArray(data, offset, keypoints.data(), keypoints.size() * sizeof(KeyPoint),
+               options.byte_order);
     
     // Descriptors
-    writeUint32(buffer, static_cast<uint32_t>(descriptors.size()));
-    for (float desc : descriptors) {
-        writeFloat(buffer, desc);
+    writeUint32(data, offset, static_cast<uint32_t>(descriptors.size()));
+    data[offset++] = static_cast<uint8_t>(options.descriptor_encoding);
+    writeDescriptors(data, offset, descriptors, options);
+}
+
+namespace {
+
+uint32_t loadWord(const uint8_t* data, ByteOrder order) {
+    uint32_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return order == nativeByteOrder() ? word : __builtin_bswap32(word);
+}
+
+void storeWord(uint8_t* data, uint32_t word, ByteOrder order) {
+    if (order != nativeByteOrder()) {
+        word = __builtin_bswap32(word);
     }
+    std::memcpy(data, &word, sizeof(word));
+}
+
+// Keypoint x and y are the first two words of each 24-byte record
+void deltaEncodeCoordinates(uint8_t* keypoints, size_t count, ByteOrder order) {
+    for (size_t i = count; i-- > 1;) {
+        for (size_t field = 0; field < 2; ++field) {
+            uint8_t* current = keypoints + i * 24 + field * 4;
+            uint32_t previous = loadWord(current - 24, order);
+            storeWord(current, loadWord(current, order) - previous, order);
+        }
+    }
+}
+
+void deltaDecodeCoordinates(uint8_t* keypoints, size_t count, ByteOrder order) {
+    for (size_t i = 1; i < count; ++i) {
+        for (size_t field = 0; field < 2; ++field) {
+            uint8_t* current = keypoints + i * 24 + field * 4;
+            uint32_t previous = loadWord(current - 24, order);
+            storeWord(current, loadWord(current, order) + previous, order);
+        }
+    }
+}
+
+} // namespace
+
+bool MessageProtocol::locateFeatureArrays(const uint8_t* section, size_t size,
+                                          size_t& num_keypoints, size_t& num_descriptors,
+                                          size_t& element_size) {
+    size_t offset = 0;
+    if (size < 9) {
+        return false;
+    }
+    num_keypoints = readUint32(section, offset);
+    if (num_keypoints > (size - 9) / sizeof(KeyPoint)) {
+        return false;
+    }
+    offset += num_keypoints * sizeof(KeyPoint);
+    num_descriptors = readUint32(section, offset);
+    uint8_t encoding = section[offset++];
+    if (encoding > static_cast<uint8_t>(DescriptorEncoding::FLOAT16)) {
+        return false;
+    }
+    element_size = descriptorElementSize(static_cast<DescriptorEncoding>(encoding));
+    return num_descriptors * element_size == size - offset;
+}
+
+void MessageProtocol::packFeatureSection(uint8_t* section, size_t size, ByteOrder order,
+                                         uint8_t* packed) {
+    size_t num_keypoints = 0;
+    size_t num_descriptors = 0;
+    size_t element_size = 0;
+    locateFeatureArrays(section, size, num_keypoints, num_descriptors, element_size);
     
-    return buffer;
+    // Counts and encoding stay in place; arrays are delta-coded and byte-shuffled
+    size_t keypoint_offset = 4;
+    size_t descriptor_offset = keypoint_offset + num_keypoints * sizeof(KeyPoint) + 5;
+    std::memcpy(packed, section, size);
+    
+    deltaEncodeCoordinates(section + keypoint_offset, num_keypoints, order);
+    shuffleBytes(section + keypoint_offset, packed + keypoint_offset,
+                 num_keypoints, sizeof(KeyPoint));
+    if (element_size > 1) {
+        shuffleBytes(section + descriptor_offset, packed + descriptor_offset,
+                     num_descriptors, element_size);
+    }
+}
+
+bool MessageProtocol::unpackFeatureSection(const uint8_t* packed, size_t size, ByteOrder order,
+                                           uint8_t* section) {
+    size_t num_keypoints = 0;
+    size_t num_descriptors = 0;
+    size_t element_size = 0;
+    if (!locateFeatureArrays(packed, size, num_keypoints, num_descriptors, element_size)) {
+        return false;
+    }
+    
+    size_t keypoint_offset = 4;
+    size_t descriptor_offset = keypoint_offset + num_keypoints * sizeof(KeyPoint) + 5;
+    std::memcpy(section, packed, size);
+    
+    unshuffleBytes(packed + keypoint_offset, section + keypoint_offset,
+                   num_keypoints, sizeof(KeyPoint));
+    deltaDecodeCoordinates(section + keypoint_offset, num_keypoints, order);
+    if (element_size > 1) {
+        unshuffleBytes(packed + descriptor_offset, section + descriptor_offset,
+                       num_descriptors, element_size);
+    }
+    return true;
 }
 
 // Deserialize processed data message
@@ -182,88 +637,221 @@ bool MessageProtocol::deserializeProcessedData(
     std::vector<KeyPoint>& keypoints,
     std::vector<float>& descriptors) {
     
-    if (message.size() < 30) {
+    ProcessedDataView view;
+    std::vector<uint8_t> scratch;
+    if (!parseProcessedData(message.data(), message.size(), view, scratch)) {
+        return false;
+    }
+    
+    metadata = view.metadata;
+    image_data.assign(view.image_data, view.image_data + view.image_size);
+    decodeKeyPoints(view, keypoints);
+    decodeDescriptors(view, descriptors);
+    
+    return true;
+}
+
+// Parse processed data message in place
+bool MessageProtocol::parseProcessedData(const uint8_t* data, size_t size,
+                                         ProcessedDataView& view) {
+    return parseProcessedData(data, size, view, nullptr);
+}
+
+bool MessageProtocol::parseProcessedData(const uint8_t* data, size_t size,
+                                         ProcessedDataView& view,
+                                         std::vector<uint8_t>& scratch) {
+    return parseProcessedData(data, size, view, &scratch);
+}
+
+bool MessageProtocol::parseProcessedData(const uint8_t* data, size_t size,
+                                         ProcessedDataView& view,
+                                         std::vector<uint8_t>* scratch) {
+    if (size < 30) {
         return false;
     }
     
     size_t offset = 0;
     
-    // Check message type
-    MessageType type = static_cast<MessageType>(message[offset++]);
+    // Check message type, version and flags
+    MessageType type = static_cast<MessageType>(data[offset++]);
     if (type != MessageType::PROCESSED_DATA) {
         return false;
     }
     
-    // Deserialize metadata
-    metadata.timestamp = readUint64(message.data(), offset);
-    metadata.width = readUint32(message.data(), offset);
-    metadata.height = readUint32(message.data(), offset);
-    metadata.channels = readUint32(message.data(), offset);
-    metadata.data_size = readUint32(message.data(), offset);
-    metadata.filename = readString(message.data(), offset, 256);
-    
-    // Deserialize image data
-    if (offset + metadata.data_size > message.size()) {
+    uint8_t version = data[offset++];
+    uint8_t flags = data[offset++];
+    const uint8_t known_flags = kFlagLittleEndianArrays | kFlagCompressedFeatures |
+                                kFlagImageByReference;
+    if (version != kProtocolVersion || (flags & ~known_flags) != 0) {
         return false;
     }
-    image_data.assign(message.begin() + offset, message.begin() + offset + metadata.data_size);
-    offset += metadata.data_size;
+    view.byte_order = (flags & kFlagLittleEndianArrays) ? ByteOrder::LITTLE_ENDIAN_ORDER :
+                                                          ByteOrder::BIG_ENDIAN_ORDER;
     
-    // Deserialize keypoints
-    if (offset + 4 > message.size()) {
+    // Deserialize metadata
+    if (!readMetadata(data, size, offset, view.metadata)) {
         return false;
     }
-    uint32_t num_keypoints = readUint32(message.data(), offset);
-    keypoints.clear();
-    keypoints.reserve(num_keypoints);
     
-    for (uint32_t i = 0; i < num_keypoints; ++i) {
-        if (offset + 24 > message.size()) {
+    // Reference image data, or record the hash the receiver has to resolve
+    view.image_by_reference = (flags & kFlagImageByReference) != 0;
+    if (view.image_by_reference) {
+        if (offset + 8 > size) {
             return false;
         }
-        KeyPoint kp;
-        kp.x = readFloat(message.data(), offset);
-        kp.y = readFloat(message.data(), offset);
-        kp.size = readFloat(message.data(), offset);
-        kp.angle = readFloat(message.data(), offset);
-        kp.response = readFloat(message.data(), offset);
-        kp.octave = static_cast<int>(readUint32(message.data(), offset));
-        keypoints.push_back(kp);
+        view.image_hash = readUint64(data, offset);
+        view.image_data = nullptr;
+        view.image_size = 0;
+    } else {
+        if (offset + view.metadata.data_size > size) {
+            return false;
+        }
+        view.image_hash = 0;
+        view.image_data = data + offset;
+        view.image_size = view.metadata.data_size;
+        offset += view.metadata.data_size;
+    }
+    
+    view.compression = CompressionCodec::NONE;
+    if (!(flags & kFlagCompressedFeatures)) {
+        return parseFeatureSection(data + offset, size - offset, view);
     }
     
-    // Deserialize descriptors
-    if (offset + 4 > message.size()) {
+    // Compressed features are inflated into the caller's scratch buffer
+    if (!scratch || offset + 9 > size) {
+        return false;
+    }
+    CompressionCodec codec = static_cast<CompressionCodec>(data[offset++]);
+    uint32_t raw_size = readUint32(data, offset);
+    uint32_t compressed_size = readUint32(data, offset);
+    if (!compressionAvailable(codec) || compressed_size > size - offset ||
+        raw_size < featureSectionSize(0, 0, ProcessedDataOptions()) ||
+        raw_size > kMaxFeatureSectionSize) {
         return false;
     }
-    uint32_t num_descriptors = readUint32(message.data(), offset);
-    descriptors.clear();
-    descriptors.reserve(num_descriptors);
     
-    for (uint32_t i = 0; i < num_descriptors; ++i) {
-        if (offset + 4 > message.size()) {
-            return false;
-        }
-        descriptors.push_back(readFloat(message.data(), offset));
+    // First half holds the packed section, second half the unpacked one
+    scratch->resize(static_cast<size_t>(raw_size) * 2);
+    uint8_t* packed = scratch->data();
+    uint8_t* section = scratch->data() + raw_size;
+    if (!decompressBytes(codec, data + offset, compressed_size, packed, raw_size) ||
+        !unpackFeatureSection(packed, raw_size, view.byte_order, section)) {
+        return false;
+    }
+    
+    view.compression = codec;
+    return parseFeatureSection(section, raw_size, view);
+}
+
+bool MessageProtocol::parseFeatureSection(const uint8_t* data, size_t size,
+                                          ProcessedDataView& view) {
+    size_t offset = 0;
+    
+    // Reference keypoints (24 bytes each)
+    if (offset + 4 > size) {
+        return false;
+    }
+    view.num_keypoints = readUint32(data, offset);
+    if (view.num_keypoints > (size - offset) / 24) {
+        return false;
+    }
+    view.keypoint_data = data + offset;
+    offset += static_cast<size_t>(view.num_keypoints) * 24;
+    
+    // Reference descriptors
+    if (offset + 5 > size) {
+        return false;
+    }
+    view.num_descriptors = readUint32(data, offset);
+    uint8_t encoding = data[offset++];
+    if (encoding > static_cast<uint8_t>(DescriptorEncoding::FLOAT16)) {
+        return false;
     }
+    view.descriptor_encoding = static_cast<DescriptorEncoding>(encoding);
+    
+    size_t element_size = descriptorElementSize(view.descriptor_encoding);
+    if (view.num_descriptors > (size - offset) / element_size) {
+        return false;
+    }
+    view.descriptor_data = data + offset;
+    view.descriptor_size = view.num_descriptors * element_size;
     
     return true;
 }
 
+void MessageProtocol::decodeKeyPoints(const ProcessedDataView& view,
+                                      std::vector<KeyPoint>& keypoints) {
+    keypoints.resize(view.num_keypoints);
+    readArray(keypoints.data(), view.keypoint_data,
+              keypoints.size() * sizeof(KeyPoint), view.byte_order);
+}
+
+void MessageProtocol::decodeDescriptors(const ProcessedDataView& view,
+                                        std::vector<float>& descriptors) {
+    descriptors.resize(view.num_descriptors);
+    imaging::decodeDescriptors(view.descriptor_data, descriptors.size(),
+                               view.descriptor_encoding, view.byte_order, descriptors.data());
+}
+
 // Serialize heartbeat message
 std::vector<uint8_t> MessageProtocol::serializeHeartbeat(const std::string& app_name) {
-    std::vector<uint8_t> buffer;
-    buffer.push_back(static_cast<uint8_t>(MessageType::HEARTBEAT));
-    writeString(buffer, app_name);
-    writeUint64(buffer, std::chrono::system_clock::now().time_since_epoch().count());
+    std::vector<uint8_t> buffer(1 + 4 + app_name.size() + 8);
+    size_t offset = 0;
+    
+    buffer[offset++] = static_cast<uint8_t>(MessageType::HEARTBEAT);
+    writeString(buffer.data(), offset, app_name);
+    writeUint64(buffer.data(), offset, std::chrono::system_clock::now().time_since_epoch().count());
     return buffer;
 }
 
+// Serialize heartbeat message with a credit grant appended
+std::vector<uint8_t> MessageProtocol::serializeHeartbeat(const CreditGrant& grant) {
+    std::vector<uint8_t> buffer(1 + 4 + grant.stage.size() + 8 + 8 + 4);
+    size_t offset = 0;
+    
+    buffer[offset++] = static_cast<uint8_t>(MessageType::HEARTBEAT);
+    writeString(buffer.data(), offset, grant.stage);
+    writeUint64(buffer.data(), offset, grant.timestamp);
+    writeUint64(buffer.data(), offset, grant.consumed);
+    writeUint32(buffer.data(), offset, grant.window);
+    return buffer;
+}
+
+// Deserialize heartbeat message
+bool MessageProtocol::deserializeHeartbeat(const uint8_t* data, size_t size, CreditGrant& grant) {
+    if (size < 1 + 4 || static_cast<MessageType>(data[0]) != MessageType::HEARTBEAT) {
+        return false;
+    }
+    
+    size_t offset = 1;
+    size_t length = readUint32(data, offset);
+    if (length > size - offset || size - offset - length < 8) {
+        return false;
+    }
+    offset = 1;
+    grant.stage = readString(data, offset, length);
+    grant.timestamp = readUint64(data, offset);
+    
+    // Heartbeats without credit information end here
+    grant.consumed = 0;
+    grant.window = 0;
+    if (size - offset >= 12) {
+        grant.consumed = readUint64(data, offset);
+        grant.window = readUint32(data, offset);
+    }
+    return true;
+}
+
 // Get message type
 MessageType MessageProtocol::getMessageType(const std::vector<uint8_t>& message) {
-    if (message.empty()) {
+    return getMessageType(message.data(), message.size());
+}
+
+MessageType MessageProtocol::getMessageType(const uint8_t* data, size_t size) {
+    if (size == 0) {
         return MessageType::SHUTDOWN;
     }
-    return static_cast<MessageType>(message[0]);
+    return static_cast<MessageType>(data[0]);
 }
 
 } // namespace imaging
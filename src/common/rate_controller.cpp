@@ -0,0 +1,100 @@
+/*
+ * Rate Controller Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "rate_controller.h"
+#include <algorithm>
+#include <thread>
+
+namespace imaging {
+
+RateController::RateController()
+    : mode_(Mode::UNTHROTTLED), rate_(0.0), started_(false) {
+    resetStats();
+}
+
+void RateController::setUnthrottled() {
+    mode_ = Mode::UNTHROTTLED;
+    started_ = false;
+}
+
+void RateController::setFrameRate(double frames_per_second) {
+    mode_ = frames_per_second > 0.0 ? Mode::FRAMES_PER_SECOND : Mode::UNTHROTTLED;
+    rate_ = frames_per_second;
+    started_ = false;
+}
+
+void RateController::setByteRate(double bytes_per_second) {
+    mode_ = bytes_per_second > 0.0 ? Mode::BYTES_PER_SECOND : Mode::UNTHROTTLED;
+    rate_ = bytes_per_second;
+    started_ = false;
+}
+
+void RateController::pace(size_t bytes) {
+    Clock::time_point now = Clock::now();
+    
+    if (mode_ != Mode::UNTHROTTLED) {
+        if (!started_) {
+            deadline_ = now;
+            started_ = true;
+        }
+        
+        if (now < deadline_) {
+            std::this_thread::sleep_until(deadline_);
+            now = Clock::now();
+        }
+        
+        double lateness_us = std::chrono::duration<double, std::micro>(now - deadline_).count();
+        total_lateness_us_ += lateness_us;
+        max_lateness_us_ = std::max(max_lateness_us_, lateness_us);
+        
+        if (lateness_us > kMaxBacklogSeconds * 1e6) {
+            deadline_ = now;
+            resyncs_++;
+        }
+        
+        // This frame's share of the schedule
+        double seconds = mode_ == Mode::FRAMES_PER_SECOND ? 1.0 / rate_ :
+                                                            static_cast<double>(bytes) / rate_;
+        deadline_ += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds));
+    }
+    
+    frames_++;
+    bytes_ += bytes;
+}
+
+RateController::Clock::time_point RateController::due() const {
+    if (mode_ == Mode::UNTHROTTLED || !started_) {
+        return Clock::now();
+    }
+    return deadline_;
+}
+
+RateController::Stats RateController::stats() const {
+    Stats stats;
+    stats.frames = frames_;
+    stats.bytes = bytes_;
+    stats.elapsed_seconds = std::chrono::duration<double>(Clock::now() - stats_start_).count();
+    stats.frames_per_second = stats.elapsed_seconds > 0.0 ? frames_ / stats.elapsed_seconds : 0.0;
+    stats.bytes_per_second = stats.elapsed_seconds > 0.0 ? bytes_ / stats.elapsed_seconds : 0.0;
+    stats.mean_lateness_us = frames_ > 0 && mode_ != Mode::UNTHROTTLED ?
+                             total_lateness_us_ / frames_ : 0.0;
+    stats.max_lateness_us = max_lateness_us_;
+    stats.resyncs = resyncs_;
+    return stats;
+}
+
+void RateController::resetStats() {
+    stats_start_ = Clock::now();
+    frames_ = 0;
+    bytes_ = 0;
+    total_lateness_us_ = 0.0;
+    max_lateness_us_ = 0.0;
+    resyncs_ = 0;
+}
+
+} // namespace imaging
@@ -0,0 +1,106 @@
+/*
+ * Shared Buffer Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "shared_buffer.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace imaging {
+
+namespace {
+
+// Owner of a read-only file mapping
+class MappedFile {
+public:
+    MappedFile(void* address, size_t size) : address_(address), size_(size) {}
+    ~MappedFile() { munmap(address_, size_); }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const uint8_t* data() const { return static_cast<const uint8_t*>(address_); }
+    
+private:
+    void* address_;
+    size_t size_;
+};
+
+} // namespace
+
+SharedBuffer::SharedBuffer()
+    : data_(nullptr), size_(0) {
+}
+
+SharedBuffer::SharedBuffer(std::vector<uint8_t>&& bytes)
+    : data_(nullptr), size_(0) {
+    auto storage = std::make_shared<std::vector<uint8_t>>(std::move(bytes));
+    data_ = storage->data();
+    size_ = storage->size();
+    owner_ = std::move(storage);
+}
+
+SharedBuffer::SharedBuffer(std::shared_ptr<const void> owner, const uint8_t* data, size_t size)
+    : owner_(std::move(owner)), data_(data), size_(size) {
+}
+
+SharedBuffer::SharedBuffer(SharedBuffer&& other) noexcept
+    : owner_(std::move(other.owner_)), data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+SharedBuffer& SharedBuffer::operator=(SharedBuffer&& other) noexcept {
+    if (this != &other) {
+        owner_ = std::move(other.owner_);
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+SharedBuffer SharedBuffer::slice(size_t offset, size_t length) const {
+    offset = std::min(offset, size_);
+    length = std::min(length, size_ - offset);
+    return SharedBuffer(owner_, data_ + offset, length);
+}
+
+bool mapFile(const std::string& path, SharedBuffer& buffer) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    
+    // The mapping stays valid after the descriptor is closed
+    size_t size = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    
+    // Start reading the whole file in now; pages already in the page cache
+    // are shared instead of copied
+    madvise(address, size, MADV_SEQUENTIAL);
+    madvise(address, size, MADV_WILLNEED);
+    
+    auto mapping = std::make_shared<MappedFile>(address, size);
+    buffer = SharedBuffer(mapping, mapping->data(), size);
+    return true;
+}
+
+} // namespace imaging
@@ -0,0 +1,335 @@
+/*
+ * Shared-Memory Transport Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "shm_transport.h"
+#include "logger.h"
+#include <zmq.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace imaging {
+
+namespace {
+
+const char kShmScheme[] = "shm://";
+constexpr uint64_t kRingMagic = 0x31474e4952474d49ULL;  // "IMGRING1"
+constexpr uint64_t kRecordAlignment = 64;
+
+std::string shmName(const std::string& endpoint) {
+    return endpoint.substr(sizeof(kShmScheme) - 1);
+}
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+bool isShmEndpoint(const std::string& endpoint) {
+    return endpoint.compare(0, sizeof(kShmScheme) - 1, kShmScheme) == 0;
+}
+
+std::string shmSegmentName(const std::string& endpoint) {
+    return "/imaging-" + shmName(endpoint);
+}
+
+std::string shmControlEndpoint(const std::string& endpoint) {
+    return "ipc:///tmp/imaging-" + shmName(endpoint) + ".ctl";
+}
+
+std::string transportEndpoint(const std::string& endpoint) {
+    return isShmEndpoint(endpoint) ? shmControlEndpoint(endpoint) : endpoint;
+}
+
+// Lives at the start of the segment. Positions are logical byte counts that
+// only grow; position p is stored at p % capacity.
+struct ShmRing::Header {
+    std::atomic<uint64_t> magic;
+    uint64_t generation;
+    uint64_t capacity;
+    std::atomic<uint64_t> reserved;   // End of the record being written
+    std::atomic<uint64_t> committed;  // End of the last complete record
+    uint8_t padding[24];
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) &&
+              std::atomic<uint64_t>::is_always_lock_free,
+              "Ring positions must be address-free atomics to be shared between processes");
+
+ShmRing::ShmRing()
+    : owner_(false), fd_(-1), mapping_(nullptr), mapping_size_(0),
+      header_(nullptr), data_(nullptr) {
+    static_assert(sizeof(Header) == 64, "Ring data must start cache-line aligned");
+}
+
+ShmRing::~ShmRing() {
+    close();
+}
+
+bool ShmRing::create(const std::string& name, size_t capacity) {
+    close();
+    
+    capacity = alignUp(capacity, kRecordAlignment);
+    if (capacity == 0) {
+        return false;
+    }
+    
+    // A segment left behind by a crashed producer is replaced
+    shm_unlink(name.c_str());
+    fd_ = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd_ == -1) {
+        Logger::error("Failed to create shared memory segment " + name + ": " + std::strerror(errno));
+        return false;
+    }
+    
+    mapping_size_ = sizeof(Header) + capacity;
+    if (ftruncate(fd_, static_cast<off_t>(mapping_size_)) != 0) {
+        Logger::error("Failed to size shared memory segment " + name + ": " + std::strerror(errno));
+        ::close(fd_);
+        fd_ = -1;
+        shm_unlink(name.c_str());
+        return false;
+    }
+    
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping_ == MAP_FAILED) {
+        Logger::error("Failed to map shared memory segment " + name + ": " + std::strerror(errno));
+        mapping_ = nullptr;
+        ::close(fd_);
+        fd_ = -1;
+        shm_unlink(name.c_str());
+        return false;
+    }
+    
+    name_ = name;
+    owner_ = true;
+    header_ = new (mapping_) Header();
+    data_ = static_cast<uint8_t*>(mapping_) + sizeof(Header);
+    
+    // Consumers re-map when the generation changes, e.g. after a restart
+    header_->generation = (static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count()) ^
+        (static_cast<uint64_t>(getpid()) << 32)) | 1;
+    header_->capacity = capacity;
+    header_->reserved.store(0, std::memory_order_relaxed);
+    header_->committed.store(0, std::memory_order_relaxed);
+    header_->magic.store(kRingMagic, std::memory_order_release);
+    
+    return true;
+}
+
+bool ShmRing::open(const std::string& name) {
+    close();
+    
+    fd_ = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd_ == -1) {
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd_, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        close();
+        return false;
+    }
+    
+    mapping_size_ = static_cast<size_t>(info.st_size);
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        close();
+        return false;
+    }
+    
+    header_ = static_cast<Header*>(mapping_);
+    if (header_->magic.load(std::memory_order_acquire) != kRingMagic ||
+        sizeof(Header) + header_->capacity > mapping_size_) {
+        close();
+        return false;
+    }
+    
+    name_ = name;
+    data_ = static_cast<uint8_t*>(mapping_) + sizeof(Header);
+    return true;
+}
+
+void ShmRing::close() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+    
+    name_.clear();
+    owner_ = false;
+    fd_ = -1;
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    header_ = nullptr;
+    data_ = nullptr;
+}
+
+uint8_t* ShmRing::reserve(size_t length, uint64_t& offset) {
+    if (!owner_ || length > maxRecordSize()) {
+        return nullptr;
+    }
+    
+    // Records never wrap, so they can be parsed in place
+    uint64_t capacity = header_->capacity;
+    uint64_t start = alignUp(header_->committed.load(std::memory_order_relaxed), kRecordAlignment);
+    uint64_t position = start % capacity;
+    if (position + length > capacity) {
+        start += capacity - position;
+    }
+    
+    // Announce the overwrite before touching the bytes (seqlock-style writer)
+    header_->reserved.store(start + length, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    offset = start;
+    return data_ + start % capacity;
+}
+
+void ShmRing::commit(uint64_t offset, size_t length) {
+    header_->reserved.store(offset + length, std::memory_order_relaxed);
+    header_->committed.store(offset + length, std::memory_order_release);
+}
+
+void ShmRing::abort() {
+    header_->reserved.store(header_->committed.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+}
+
+const uint8_t* ShmRing::record(uint64_t offset, size_t length) const {
+    if (!header_) {
+        return nullptr;
+    }
+    uint64_t capacity = header_->capacity;
+    if (offset + length > header_->committed.load(std::memory_order_acquire) ||
+        offset % capacity + length > capacity || !intact(offset)) {
+        return nullptr;
+    }
+    return data_ + offset % capacity;
+}
+
+bool ShmRing::intact(uint64_t offset) const {
+    // Reads of the record must complete before the position is sampled
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header_ &&
+           header_->reserved.load(std::memory_order_relaxed) <= offset + header_->capacity;
+}
+
+uint64_t ShmRing::generation() const {
+    return header_ ? header_->generation : 0;
+}
+
+size_t ShmRing::capacity() const {
+    return header_ ? header_->capacity : 0;
+}
+
+ShmPublisher::ShmPublisher()
+    : sequence_(0), reserved_offset_(0) {
+}
+
+bool ShmPublisher::open(const std::string& endpoint, size_t capacity) {
+    if (!ring_.create(shmSegmentName(endpoint), capacity)) {
+        return false;
+    }
+    
+    Logger::info("Shared memory ring " + shmSegmentName(endpoint) + ": " +
+                 std::to_string(ring_.capacity() / (1024 * 1024)) + " MB");
+    return true;
+}
+
+void ShmPublisher::close() {
+    ring_.close();
+}
+
+uint8_t* ShmPublisher::reserve(size_t length) {
+    uint8_t* data = ring_.reserve(length, reserved_offset_);
+    if (!data) {
+        errno = EMSGSIZE;
+    }
+    return data;
+}
+
+int ShmPublisher::publish(void* socket, size_t length, int flags) {
+    ring_.commit(reserved_offset_, length);
+    
+    ShmDescriptor descriptor;
+    descriptor.generation = ring_.generation();
+    descriptor.sequence = sequence_++;
+    descriptor.offset = reserved_offset_;
+    descriptor.length = static_cast<uint32_t>(length);
+    
+    std::vector<uint8_t> message = MessageProtocol::serializeShmDescriptor(descriptor);
+    if (zmq_send(socket, message.data(), message.size(), flags) == -1) {
+        return -1;
+    }
+    return static_cast<int>(length);
+}
+
+void ShmPublisher::abort() {
+    ring_.abort();
+}
+
+ShmSubscriber::ShmSubscriber()
+    : have_last_(false), missed_(0) {
+}
+
+void ShmSubscriber::open(const std::string& endpoint) {
+    close();
+    segment_name_ = shmSegmentName(endpoint);
+}
+
+void ShmSubscriber::close() {
+    ring_.close();
+    have_last_ = false;
+}
+
+bool ShmSubscriber::resolve(const uint8_t* message, size_t message_size,
+                            const uint8_t*& data, size_t& size) {
+    ShmDescriptor descriptor;
+    if (!MessageProtocol::deserializeShmDescriptor(message, message_size, descriptor)) {
+        return false;
+    }
+    
+    // (Re)map the segment on first use or after the producer restarted
+    if (ring_.generation() != descriptor.generation) {
+        have_last_ = false;
+        if (!ring_.open(segment_name_) || ring_.generation() != descriptor.generation) {
+            ring_.close();
+            return false;
+        }
+    }
+    
+    if (have_last_ && descriptor.sequence > last_.sequence + 1) {
+        missed_ += descriptor.sequence - last_.sequence - 1;
+    }
+    last_ = descriptor;
+    have_last_ = true;
+    
+    data = ring_.record(descriptor.offset, descriptor.length);
+    size = descriptor.length;
+    return data != nullptr;
+}
+
+bool ShmSubscriber::intact() const {
+    return have_last_ && ring_.intact(last_.offset);
+}
+
+} // namespace imaging
@@ -0,0 +1,74 @@
+/*
+ * ZeroMQ Helpers Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "zmq_helpers.h"
+#include <cerrno>
+
+namespace imaging {
+
+namespace {
+
+// Called by ZeroMQ once it no longer needs the frame data
+void releaseSharedBuffer(void* /*data*/, void* hint) {
+    delete static_cast<std::shared_ptr<const void>*>(hint);
+}
+
+} // namespace
+
+int sendSharedBuffer(void* socket, const SharedBuffer& buffer, int flags) {
+    // zmq_msg_init_data ignores the free callback for empty frames
+    if (buffer.empty()) {
+        return zmq_send(socket, nullptr, 0, flags);
+    }
+    
+    auto* owner = new std::shared_ptr<const void>(buffer.owner());
+    
+    zmq_msg_t frame;
+    if (zmq_msg_init_data(&frame, const_cast<uint8_t*>(buffer.data()), buffer.size(),
+                          releaseSharedBuffer, owner) != 0) {
+        delete owner;
+        return -1;
+    }
+    
+    int sent = zmq_msg_send(&frame, socket, flags);
+    if (sent == -1) {
+        // Frame was not consumed, closing it releases the owner
+        int saved_errno = errno;
+        zmq_msg_close(&frame);
+        errno = saved_errno;
+    }
+    return sent;
+}
+
+SharedBuffer takeMessage(ZmqMessage& message) {
+    auto frame = std::make_shared<ZmqMessage>();
+    zmq_msg_move(frame->get(), message.get());
+    return SharedBuffer(frame, frame->data(), frame->size());
+}
+
+bool hasMoreFrames(void* socket) {
+    int more = 0;
+    size_t more_size = sizeof(more);
+    if (zmq_getsockopt(socket, ZMQ_RCVMORE, &more, &more_size) != 0) {
+        return false;
+    }
+    return more != 0;
+}
+
+void discardRemainingFrames(void* socket) {
+    while (hasMoreFrames(socket)) {
+        zmq_msg_t frame;
+        zmq_msg_init(&frame);
+        int rc = zmq_msg_recv(&frame, socket, 0);
+        zmq_msg_close(&frame);
+        if (rc == -1) {
+            break;
+        }
+    }
+}
+
+} // namespace imaging
@@ -85,6 +85,7 @@ bool DatabaseManager::createTables() {
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             image_id INTEGER NOT NULL,
             descriptor_data BLOB NOT NULL,
+            encoding INTEGER NOT NULL DEFAULT 0,
             FOREIGN KEY (image_id) REFERENCES images(id) ON DELETE CASCADE
         );
     )";
@@ -93,6 +94,10 @@ bool DatabaseManager::createTables() {
         return false;
     }
     
+    if (!migrateSchema()) {
+        return false;
+    }
+    
     // Create indices for faster queries
     executeSql("CREATE INDEX IF NOT EXISTS idx_keypoints_image_id ON keypoints(image_id);");
     executeSql("CREATE INDEX IF NOT EXISTS idx_descriptors_image_id ON descriptors(image_id);");
@@ -102,6 +107,38 @@ bool DatabaseManager::createTables() {
     return true;
 }
 
+bool DatabaseManager::migrateSchema() {
+    // Databases created before descriptor quantization hold float32 blobs only
+    if (!hasColumn("descriptors", "encoding")) {
+        Logger::info("Adding descriptor encoding column");
+        if (!executeSql("ALTER TABLE descriptors ADD COLUMN encoding INTEGER NOT NULL DEFAULT 0;")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DatabaseManager::hasColumn(const std::string& table, const std::string& column) {
+    sqlite3_stmt* stmt = nullptr;
+    std::string sql = "PRAGMA table_info(" + table + ");";
+    
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    bool found = false;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* name = sqlite3_column_text(stmt, 1);
+        if (name && column == reinterpret_cast<const char*>(name)) {
+            found = true;
+            break;
+        }
+    }
+    
+    sqlite3_finalize(stmt);
+    return found;
+}
+
 bool DatabaseManager::executeSql(const std::string& sql) {
     char* err_msg = nullptr;
     int rc = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &err_msg);
@@ -119,6 +156,38 @@ bool DatabaseManager::storeProcessedData(const ImageMetadata& metadata,
                                          const std::vector<uint8_t>& image_data,
                                          const std::vector<KeyPoint>& keypoints,
                                          const std::vector<float>& descriptors) {
+    return storeFrame(metadata, image_data.data(), image_data.size(),
+                      keypoints, descriptors.data(), descriptors.size() * sizeof(float),
+                      DescriptorEncoding::FLOAT32);
+}
+
+bool DatabaseManager::storeProcessedData(const ProcessedDataView& view) {
+    MessageProtocol::decodeKeyPoints(view, keypoint_scratch_);
+    
+    const uint8_t* descriptor_data = view.descriptor_data;
+    
+    // Descriptors are already laid out in native order inside the message
+    // unless they are multi-byte and came from a foreign byte order
+    if (view.byte_order != nativeByteOrder()) {
+        descriptor_scratch_.resize(view.descriptor_size);
+        if (view.descriptor_encoding == DescriptorEncoding::FLOAT32) {
+            byteSwap32(descriptor_scratch_.data(), view.descriptor_data, view.num_descriptors);
+            descriptor_data = descriptor_scratch_.data();
+        } else if (view.descriptor_encoding == DescriptorEncoding::FLOAT16) {
+            byteSwap16(descriptor_scratch_.data(), view.descriptor_data, view.num_descriptors);
+            descriptor_data = descriptor_scratch_.data();
+        }
+    }
+    
+    return storeFrame(view.metadata, view.image_data, view.image_size, keypoint_scratch_,
+                      descriptor_data, view.descriptor_size, view.descriptor_encoding);
+}
+
+bool DatabaseManager::storeFrame(const ImageMetadata& metadata,
+                                 const uint8_t* image_data, size_t image_size,
+                                 const std::vector<KeyPoint>& keypoints,
+                                 const void* descriptor_data, size_t descriptor_bytes,
+                                 DescriptorEncoding descriptor_encoding) {
     // Begin transaction
     if (!executeSql("BEGIN TRANSACTION;")) {
         return false;
@@ -145,7 +214,8 @@ bool DatabaseManager::storeProcessedData(const ImageMetadata& metadata,
     sqlite3_bind_int(stmt, 4, metadata.height);
     sqlite3_bind_int(stmt, 5, metadata.channels);
     sqlite3_bind_int(stmt, 6, metadata.data_size);
-    sqlite3_bind_blob(stmt, 7, image_data.data(), image_data.size(), SQLITE_TRANSIENT);
+    // SQLITE_STATIC: the caller's buffer outlives sqlite3_step, so no copy is made
+    sqlite3_bind_blob(stmt, 7, image_data, static_cast<int>(image_size), SQLITE_STATIC);
     
     rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
@@ -191,10 +261,10 @@ bool DatabaseManager::storeProcessedData(const ImageMetadata& metadata,
     }
     
     // Insert descriptors
-    if (!descriptors.empty()) {
+    if (descriptor_bytes > 0) {
         const char* insert_descriptor_sql = R"(
-            INSERT INTO descriptors (image_id, descriptor_data)
-            VALUES (?, ?);
+            INSERT INTO descriptors (image_id, descriptor_data, encoding)
+            VALUES (?, ?, ?);
         )";
         
         rc = sqlite3_prepare_v2(db_, insert_descriptor_sql, -1, &stmt, nullptr);
@@ -205,8 +275,9 @@ bool DatabaseManager::storeProcessedData(const ImageMetadata& metadata,
         }
         
         sqlite3_bind_int64(stmt, 1, image_id);
-        sqlite3_bind_blob(stmt, 2, descriptors.data(), 
-                         descriptors.size() * sizeof(float), SQLITE_TRANSIENT);
+        sqlite3_bind_blob(stmt, 2, descriptor_data,
+                         static_cast<int>(descriptor_bytes), SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 3, static_cast<int>(descriptor_encoding));
         
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
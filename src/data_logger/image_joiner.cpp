@@ -0,0 +1,49 @@
+/*
+ * Image Joiner Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_joiner.h"
+#include "content_hash.h"
+
+namespace imaging {
+
+ImageJoiner::ImageJoiner(size_t max_bytes)
+    : max_bytes_(max_bytes), bytes_(0) {
+}
+
+uint64_t ImageJoiner::addImage(SharedBuffer image_data) {
+    uint64_t hash = contentHash(image_data.data(), image_data.size());
+    
+    // The generator cycles through its images, so repeats only refresh the entry
+    auto existing = images_.find(hash);
+    if (existing != images_.end()) {
+        order_.splice(order_.end(), order_, existing->second.position);
+        return hash;
+    }
+    
+    bytes_ += image_data.size();
+    order_.push_back(hash);
+    Entry& entry = images_[hash];
+    entry.data = std::move(image_data);
+    entry.position = std::prev(order_.end());
+    
+    // Evict the oldest images, always keeping the newest one
+    while (bytes_ > max_bytes_ && order_.size() > 1) {
+        auto oldest = images_.find(order_.front());
+        bytes_ -= oldest->second.data.size();
+        images_.erase(oldest);
+        order_.pop_front();
+    }
+    
+    return hash;
+}
+
+const SharedBuffer* ImageJoiner::find(uint64_t hash) const {
+    auto it = images_.find(hash);
+    return it == images_.end() ? nullptr : &it->second.data;
+}
+
+} // namespace imaging
@@ -8,18 +8,35 @@
 #include "database_manager.h"
 #include "message_protocol.h"
 #include "logger.h"
+#include "shm_transport.h"
+#include "image_receiver.h"
+#include "image_joiner.h"
+#include "command_line.h"
+#include "flow_control.h"
+#include "zmq_helpers.h"
 #include <zmq.h>
 #include <csignal>
 #include <thread>
 #include <atomic>
+#include <list>
+#include <memory>
 
 static std::atomic<bool> g_running(true);
+static std::atomic<int> g_signal(0);
 
+// Async-signal-safe: no logging here, see logSignal()
 void signalHandler(int signum) {
-    imaging::Logger::info("Interrupt signal (" + std::to_string(signum) + ") received");
+    g_signal = signum;
     g_running = false;
 }
 
+static void logSignal() {
+    if (g_signal != 0) {
+        imaging::Logger::info("Interrupt signal (" + std::to_string(g_signal.load()) +
+                              ") received, shutting down");
+    }
+}
+
 int main(int argc, char* argv[]) {
     // Set up signal handler
     std::signal(SIGINT, signalHandler);
@@ -28,18 +45,34 @@ int main(int argc, char* argv[]) {
     imaging::Logger::info("=== Data Logger Starting ===");
     
     // Parse command line arguments
-    std::string subscribe_endpoint = "tcp://localhost:5556";
-    std::string db_path = "imaging_data.db";
+    imaging::CommandLine args(argc, argv);
+    std::string subscribe_endpoint = args.positional(0, "tcp://localhost:5556");
+    std::string db_path = args.positional(1, "imaging_data.db");
     
-    if (argc > 1) {
-        subscribe_endpoint = argv[1];
+    // Images for processed data sent by reference come straight from the generator
+    std::string image_endpoint = args.option("image-endpoint", "");
+    int64_t image_cache_mb = args.optionInt("image-cache-mb", 512);
+    if (image_cache_mb <= 0) {
+        imaging::Logger::error("Image cache size must be positive");
+        return 1;
     }
-    if (argc > 2) {
-        db_path = argv[2];
+    
+    // Credit-based flow control: grant credit to the extractor
+    std::string upstream_credit = args.option("upstream-credit", "");
+    int64_t credits = args.optionInt("credits", 8);
+    if (credits < 1 || credits > UINT32_MAX) {
+        imaging::Logger::error("Credits must be between 1 and 2^32-1");
+        return 1;
     }
     
     imaging::Logger::info("Subscribe endpoint: " + subscribe_endpoint);
     imaging::Logger::info("Database path: " + db_path);
+    if (!upstream_credit.empty()) {
+        imaging::Logger::info("Granting " + std::to_string(credits) + " credits on: " + upstream_credit);
+    }
+    if (!image_endpoint.empty()) {
+        imaging::Logger::info("Image endpoint: " + image_endpoint);
+    }
     
     // Initialize database
     imaging::DatabaseManager db_manager(db_path);
@@ -71,7 +104,13 @@ int main(int argc, char* argv[]) {
     zmq_setsockopt(subscriber, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
     
     // Connect to feature extractor
-    if (zmq_connect(subscriber, subscribe_endpoint.c_str()) != 0) {
+    bool shm_input = imaging::isShmEndpoint(subscribe_endpoint);
+    imaging::ShmSubscriber shm_subscriber;
+    if (shm_input) {
+        shm_subscriber.open(subscribe_endpoint);
+    }
+    
+    if (zmq_connect(subscriber, imaging::transportEndpoint(subscribe_endpoint).c_str()) != 0) {
         imaging::Logger::error("Failed to connect to: " + subscribe_endpoint);
         zmq_close(subscriber);
         zmq_ctx_destroy(context);
@@ -79,64 +118,103 @@ int main(int argc, char* argv[]) {
     }
     
     imaging::Logger::info("Connected to feature extractor");
+    
+    // Optional second subscription to the generator's images
+    void* image_subscriber = nullptr;
+    if (!image_endpoint.empty()) {
+        image_subscriber = zmq_socket(context, ZMQ_SUB);
+        if (!image_subscriber ||
+            zmq_setsockopt(image_subscriber, ZMQ_SUBSCRIBE, "", 0) != 0 ||
+            zmq_connect(image_subscriber,
+                        imaging::transportEndpoint(image_endpoint).c_str()) != 0) {
+            imaging::Logger::error("Failed to connect to: " + image_endpoint);
+            if (image_subscriber) {
+                zmq_close(image_subscriber);
+            }
+            zmq_close(subscriber);
+            zmq_ctx_destroy(context);
+            return 1;
+        }
+        imaging::Logger::info("Connected to image generator");
+    }
+    
+    imaging::CreditAdvertiser credit_advertiser;
+    if (!upstream_credit.empty() &&
+        !credit_advertiser.open(context, upstream_credit, "data_logger",
+                                static_cast<uint32_t>(credits))) {
+        if (image_subscriber) {
+            zmq_close(image_subscriber);
+        }
+        zmq_close(subscriber);
+        zmq_ctx_destroy(context);
+        return 1;
+    }
     imaging::Logger::info("Starting data logging...");
     
     uint64_t frame_count = 0;
     uint64_t last_stats_time = 0;
-    std::vector<uint8_t> receive_buffer(100 * 1024 * 1024);  // 100MB buffer
+    imaging::ZmqMessage message;           // Received frame, parsed in place
+    std::vector<uint8_t> record_copy;      // Records copied out of the shared-memory ring
+    std::vector<uint8_t> feature_scratch;  // Inflated features of compressed messages
     
-    while (g_running) {
-        // Receive processed data
-        int received = zmq_recv(subscriber, receive_buffer.data(), receive_buffer.size(), 0);
-        
-        if (received == -1) {
-            if (errno == EAGAIN || errno == EINTR) {
-                // Timeout or interrupted, continue
-                // Print stats periodically
-                auto now = std::chrono::system_clock::now().time_since_epoch().count();
-                if (now - last_stats_time > 10000000000LL) {  // Every 10 seconds
-                    int64_t total_images = db_manager.getTotalImagesStored();
-                    int64_t total_keypoints = db_manager.getTotalKeypointsStored();
-                    imaging::Logger::info("Stats - Total images: " + std::to_string(total_images) + 
-                                        ", Total keypoints: " + std::to_string(total_keypoints));
-                    last_stats_time = now;
-                }
-                continue;
-            }
-            imaging::Logger::error("Error receiving message: " + std::string(zmq_strerror(errno)));
-            continue;
-        }
+    std::unique_ptr<imaging::ImageReceiver> image_receiver;
+    if (image_subscriber) {
+        image_receiver = std::make_unique<imaging::ImageReceiver>(image_endpoint);
+    }
+    imaging::ImageJoiner joiner(static_cast<size_t>(image_cache_mb) * 1024 * 1024);
+    
+    // Processed data whose image has not arrived yet, oldest first. Entries are
+    // stored without image bytes once they expire or the queue overflows.
+    struct PendingMessage {
+        imaging::SharedBuffer data;
+        std::chrono::steady_clock::time_point arrived;
+    };
+    std::list<PendingMessage> pending;
+    const size_t max_pending = 64;
+    const auto pending_timeout = std::chrono::seconds(5);
+    static const uint8_t no_image = 0;
+    
+    // Parse, join and store one processed data message. Returns false if it
+    // refers to an image that has not arrived yet and may_defer is set.
+    auto storeMessage = [&](const uint8_t* data, size_t size, bool may_defer) {
+        // Parse processed data in place, without copying out of the received message
+        imaging::ProcessedDataView view;
         
-        if (received == 0) {
-            continue;
+        if (!imaging::MessageProtocol::parseProcessedData(data, size, view, feature_scratch)) {
+            imaging::Logger::error("Failed to deserialize processed data");
+            return true;
         }
         
-        // Copy received data to message vector
-        std::vector<uint8_t> message(receive_buffer.begin(), receive_buffer.begin() + received);
-        
-        // Deserialize processed data
-        imaging::ImageMetadata metadata;
-        std::vector<uint8_t> image_data;
-        std::vector<imaging::KeyPoint> keypoints;
-        std::vector<float> descriptors;
+        const imaging::ImageMetadata& metadata = view.metadata;
         
-        if (!imaging::MessageProtocol::deserializeProcessedData(message, metadata, 
-                                                               image_data, keypoints, descriptors)) {
-            imaging::Logger::error("Failed to deserialize processed data");
-            continue;
+        if (view.image_by_reference) {
+            const imaging::SharedBuffer* image = joiner.find(view.image_hash);
+            if (!image && may_defer && image_subscriber) {
+                return false;
+            }
+            if (image && image->size() == metadata.data_size) {
+                view.image_data = image->data();
+                view.image_size = image->size();
+            } else {
+                // Keep the features even though the image bytes are unavailable
+                imaging::Logger::warning("Image for " + metadata.filename +
+                                         " not received, storing features only");
+                view.image_data = &no_image;
+                view.image_size = 0;
+            }
         }
         
         frame_count++;
         imaging::Logger::info("Received frame " + std::to_string(frame_count) + 
                             ": " + metadata.filename + " with " + 
-                            std::to_string(keypoints.size()) + " keypoints");
+                            std::to_string(view.num_keypoints) + " keypoints");
         
         // Store in database
         auto start_time = std::chrono::high_resolution_clock::now();
         
-        if (!db_manager.storeProcessedData(metadata, image_data, keypoints, descriptors)) {
+        if (!db_manager.storeProcessedData(view)) {
             imaging::Logger::error("Failed to store data: " + metadata.filename);
-            continue;
+            return true;
         }
         
         auto end_time = std::chrono::high_resolution_clock::now();
@@ -144,6 +222,119 @@ int main(int argc, char* argv[]) {
         
         imaging::Logger::info("Stored frame " + metadata.filename + " in " + 
                             std::to_string(duration.count()) + " ms");
+        return true;
+    };
+    
+    // Retry waiting messages; expired ones are stored with what is available
+    auto retryPending = [&]() {
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = pending.begin(); it != pending.end();) {
+            bool expired = now - it->arrived > pending_timeout;
+            if (storeMessage(it->data.data(), it->data.size(), !expired)) {
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+    
+    while (g_running) {
+        // Wait for processed data and, if subscribed, images
+        zmq_pollitem_t items[2] = {
+            {subscriber, 0, ZMQ_POLLIN, 0},
+            {image_subscriber, 0, ZMQ_POLLIN, 0}
+        };
+        int ready = zmq_poll(items, image_subscriber ? 2 : 1, 1000);
+        
+        if (ready <= 0) {
+            if (ready == -1 && errno != EINTR) {
+                imaging::Logger::error("Error polling sockets: " + std::string(zmq_strerror(errno)));
+            }
+            // Timeout or interrupted: print stats periodically
+            auto now = std::chrono::system_clock::now().time_since_epoch().count();
+            if (now - last_stats_time > 10000000000LL) {  // Every 10 seconds
+                int64_t total_images = db_manager.getTotalImagesStored();
+                int64_t total_keypoints = db_manager.getTotalKeypointsStored();
+                imaging::Logger::info("Stats - Total images: " + std::to_string(total_images) + 
+                                    ", Total keypoints: " + std::to_string(total_keypoints));
+                last_stats_time = now;
+            }
+            retryPending();
+            continue;
+        }
+        
+        if (image_subscriber && (items[1].revents & ZMQ_POLLIN)) {
+            // Keep the image in the join cache (payload frames are taken
+            // over without copying), then retry waiting messages
+            imaging::ImageDataView image;
+            if (image_receiver->receive(image_subscriber, ZMQ_DONTWAIT, image) == 1) {
+                imaging::SharedBuffer image_data = image_receiver->detach(image);
+                if (image_receiver->intact()) {
+                    joiner.addImage(std::move(image_data));
+                }
+            }
+            retryPending();
+        }
+        
+        if (!(items[0].revents & ZMQ_POLLIN)) {
+            continue;
+        }
+        
+        // Receive processed data straight into a ZeroMQ message, whatever its size
+        if (message.receive(subscriber, ZMQ_DONTWAIT) == -1) {
+            if (errno != EAGAIN && errno != EINTR) {
+                imaging::Logger::error("Error receiving message: " + std::string(zmq_strerror(errno)));
+            }
+            continue;
+        }
+        
+        if (message.size() == 0) {
+            continue;
+        }
+        
+        // Off the input queue; pending messages are bounded separately
+        credit_advertiser.consumed();
+        
+        const uint8_t* data = message.data();
+        size_t size = message.size();
+        if (shm_input) {
+            // Copy the record out of the ring before storing it, since the
+            // producer may overwrite it at any time
+            const uint8_t* record = nullptr;
+            size_t record_size = 0;
+            if (!shm_subscriber.resolve(message.data(), message.size(), record, record_size)) {
+                imaging::Logger::warning("Shared memory frame unavailable or already overwritten");
+                continue;
+            }
+            record_copy.assign(record, record + record_size);
+            if (!shm_subscriber.intact()) {
+                imaging::Logger::warning("Frame overwritten in shared memory while copying");
+                continue;
+            }
+            data = record_copy.data();
+            size = record_copy.size();
+        }
+        
+        if (storeMessage(data, size, true)) {
+            continue;
+        }
+        
+        // The image is still in flight from the generator; keep the message
+        // (the received frame itself, or the copy out of the ring) and wait
+        pending.push_back({shm_input ? imaging::SharedBuffer(std::move(record_copy))
+                                     : imaging::takeMessage(message),
+                           std::chrono::steady_clock::now()});
+        if (pending.size() > max_pending) {
+            storeMessage(pending.front().data.data(), pending.front().data.size(), false);
+            pending.pop_front();
+        }
+    }
+    
+    logSignal();
+    
+    // Store whatever is still waiting for its image
+    for (const auto& message : pending) {
+        storeMessage(message.data.data(), message.data.size(), false);
     }
     
     imaging::Logger::info("Cleaning up...");
@@ -155,6 +346,10 @@ int main(int argc, char* argv[]) {
                         ", Total keypoints: " + std::to_string(total_keypoints));
     
     // Cleanup
+    credit_advertiser.close();
+    if (image_subscriber) {
+        zmq_close(image_subscriber);
+    }
     zmq_close(subscriber);
     zmq_ctx_destroy(context);
     
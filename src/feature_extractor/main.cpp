@@ -8,18 +8,38 @@
 #include "sift_processor.h"
 #include "message_protocol.h"
 #include "logger.h"
+#include "command_line.h"
+#include "image_receiver.h"
+#include "shm_transport.h"
+#include "flow_control.h"
+#include "staged_pipeline.h"
 #include <zmq.h>
+#include <algorithm>
 #include <csignal>
 #include <thread>
 #include <atomic>
+#include <memory>
 
 static std::atomic<bool> g_running(true);
+static std::atomic<int> g_signal(0);
 
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Only sets flags; the signal is logged by logSignal() after the loops stop
 void signalHandler(int signum) {
-    imaging::Logger::info("Interrupt signal (" + std::to_string(signum) + ") received");
+    g_signal = signum;
     g_running = false;
 }
 
+static void logSignal() {
+    if (g_signal != 0) {
+        imaging::Logger::info("Interrupt signal (" + std::to_string(g_signal.load()) +
+                              ") received, shutting down");
+    }
+}
+
 int main(int argc, char* argv[]) {
     // Set up signal handler
     std::signal(SIGINT, signalHandler);
@@ -28,18 +48,117 @@ int main(int argc, char* argv[]) {
     imaging::Logger::info("=== Feature Extractor Starting ===");
     
     // Parse command line arguments
-    std::string subscribe_endpoint = "tcp://localhost:5555";
-    std::string publish_endpoint = "tcp://*:5556";
+    imaging::CommandLine args(argc, argv);
+    std::string subscribe_endpoint = args.positional(0, "tcp://localhost:5555");
+    std::string publish_endpoint = args.positional(1, "tcp://*:5556");
     
-    if (argc > 1) {
-        subscribe_endpoint = argv[1];
+    imaging::ProcessedDataOptions encode_options;
+    std::string encoding_name = args.option("descriptor-encoding", "float32");
+    if (!imaging::parseDescriptorEncoding(encoding_name, encode_options.descriptor_encoding)) {
+        imaging::Logger::error("Unknown descriptor encoding: " + encoding_name);
+        return 1;
+    }
+    
+    std::string compression_name = args.option("compression", "none");
+    if (!imaging::parseCompressionCodec(compression_name, encode_options.compression)) {
+        imaging::Logger::error("Unknown compression codec: " + compression_name);
+        return 1;
+    }
+    if (!imaging::compressionAvailable(encode_options.compression)) {
+        imaging::Logger::error("Compression codec not available in this build: " + compression_name);
+        return 1;
     }
-    if (argc > 2) {
-        publish_endpoint = argv[2];
+    encode_options.compression_level = args.optionInt("compression-level", -1);
+    encode_options.image_by_reference = args.hasOption("image-by-reference");
+    
+    int64_t shm_size = args.optionInt("shm-size", 256 * 1024 * 1024);
+    if (shm_size <= 0) {
+        imaging::Logger::error("Shared memory size must be positive");
+        return 1;
+    }
+    
+    // Credit-based flow control: grant credit to the generator on
+    // --upstream-credit and take it from the logger on --credit-endpoint
+    std::string upstream_credit = args.option("upstream-credit", "");
+    std::string credit_endpoint = args.option("credit-endpoint", "");
+    int64_t credits = args.optionInt("credits", 4);
+    if (credits < 1 || credits > UINT32_MAX) {
+        imaging::Logger::error("Credits must be between 1 and 2^32-1");
+        return 1;
+    }
+    
+    // Decode, detect and serialize run as pipeline stages with their own
+    // threads (detection: 0 = one per core); results leave in input order
+    // unless --unordered
+    int64_t threads = args.optionInt("threads", 0);
+    int64_t decode_threads = args.optionInt("decode-threads", 1);
+    int64_t serialize_threads = args.optionInt("serialize-threads", 1);
+    int64_t queue_depth = args.optionInt("queue-depth", 2);
+    if (threads < 0 || threads > 1024 || decode_threads < 1 || decode_threads > 1024 ||
+        serialize_threads < 1 || serialize_threads > 1024) {
+        imaging::Logger::error("Thread counts must be between 1 and 1024 (0 detection threads "
+                               "for one per core)");
+        return 1;
+    }
+    if (queue_depth < 1 || queue_depth > 1024) {
+        imaging::Logger::error("Queue depth must be between 1 and 1024");
+        return 1;
     }
+    bool unordered = args.hasOption("unordered");
+    
+    // Images that have to be copied on receipt (read from shared memory, or
+    // not sent as a separate payload frame) go into recycled buffers of this
+    // size; larger ones use the heap (0 = always the heap)
+    int64_t pool_buffer_mb = args.optionInt("pool-buffer-mb", 16);
+    if (pool_buffer_mb < 0 || pool_buffer_mb > 4096) {
+        imaging::Logger::error("Pool buffer size must be between 0 and 4096 MB");
+        return 1;
+    }
+    
+    // Large frames can be split into overlapping tiles extracted in parallel
+    // (off by default: keypoints near seams can differ slightly from
+    // whole-image extraction)
+    imaging::SiftTiling tiling;
+    int64_t tile_pixels = args.optionInt("tile-pixels", 0);
+    int64_t tile_size = args.optionInt("tile-size", tiling.tile_size);
+    int64_t tile_overlap = args.optionInt("tile-overlap", tiling.overlap);
+    int64_t tile_threads = args.optionInt("tile-threads", 0);
+    if (tile_pixels < 0 || tile_size < 64 || tile_size > 65536 ||
+        tile_overlap < 0 || tile_overlap > tile_size || tile_threads < 0 || tile_threads > 1024) {
+        imaging::Logger::error("Invalid tiling options (tile size 64..65536, overlap up to the tile "
+                               "size, tile threads 0..1024)");
+        return 1;
+    }
+    
+    // By default the cores are shared out between the detection threads,
+    // so with one per core tiles are extracted without extra threads
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    unsigned workers = threads > 0 ? static_cast<unsigned>(threads) : cores;
+    tiling.min_pixels = static_cast<uint64_t>(tile_pixels);
+    tiling.tile_size = static_cast<int>(tile_size);
+    tiling.overlap = static_cast<int>(tile_overlap);
+    tiling.threads = tile_threads > 0 ? static_cast<unsigned>(tile_threads)
+                                      : std::max(1u, cores / workers);
     
     imaging::Logger::info("Subscribe endpoint: " + subscribe_endpoint);
     imaging::Logger::info("Publish endpoint: " + publish_endpoint);
+    imaging::Logger::info("Descriptor encoding: " + encoding_name);
+    imaging::Logger::info("Feature compression: " + compression_name);
+    if (encode_options.image_by_reference) {
+        imaging::Logger::info("Sending image references instead of image bytes");
+    }
+    if (!upstream_credit.empty()) {
+        imaging::Logger::info("Granting " + std::to_string(credits) + " credits on: " + upstream_credit);
+    }
+    if (!credit_endpoint.empty()) {
+        imaging::Logger::info("Waiting for credit on: " + credit_endpoint);
+    }
+    if (tiling.min_pixels > 0) {
+        imaging::Logger::info("Tiling images of " + std::to_string(tiling.min_pixels) +
+                              "+ pixels into " + std::to_string(tiling.tile_size) + " px tiles (" +
+                              std::to_string(tiling.overlap) + " px overlap, " +
+                              std::to_string(tiling.threads) + " threads each)");
+    }
     
     // Create ZeroMQ context
     void* context = zmq_ctx_new();
@@ -63,8 +182,8 @@ int main(int argc, char* argv[]) {
     int timeout = 1000;  // 1 second
     zmq_setsockopt(subscriber, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
     
-    // Connect to publisher
-    if (zmq_connect(subscriber, subscribe_endpoint.c_str()) != 0) {
+    // Connect to publisher (shm:// endpoints carry descriptors of ring records)
+    if (zmq_connect(subscriber, imaging::transportEndpoint(subscribe_endpoint).c_str()) != 0) {
         imaging::Logger::error("Failed to connect to: " + subscribe_endpoint);
         zmq_close(subscriber);
         zmq_ctx_destroy(context);
@@ -85,7 +204,17 @@ int main(int argc, char* argv[]) {
     int linger = 1000;
     zmq_setsockopt(publisher, ZMQ_LINGER, &linger, sizeof(linger));
     
-    if (zmq_bind(publisher, publish_endpoint.c_str()) != 0) {
+    bool shm_output = imaging::isShmEndpoint(publish_endpoint);
+    imaging::ShmPublisher shm_publisher;
+    if (shm_output && !shm_publisher.open(publish_endpoint, static_cast<size_t>(shm_size))) {
+        imaging::Logger::error("Failed to create shared memory ring for: " + publish_endpoint);
+        zmq_close(publisher);
+        zmq_close(subscriber);
+        zmq_ctx_destroy(context);
+        return 1;
+    }
+    
+    if (zmq_bind(publisher, imaging::transportEndpoint(publish_endpoint).c_str()) != 0) {
         imaging::Logger::error("Failed to bind to: " + publish_endpoint);
         zmq_close(publisher);
         zmq_close(subscriber);
@@ -95,20 +224,173 @@ int main(int argc, char* argv[]) {
     
     imaging::Logger::info("Publisher bound to: " + publish_endpoint);
     
+    imaging::CreditListener credit_listener;
+    imaging::CreditGate credit_gate;
+    imaging::CreditAdvertiser credit_advertiser;
+    if ((!credit_endpoint.empty() && !credit_listener.open(context, credit_endpoint)) ||
+        (!upstream_credit.empty() &&
+         !credit_advertiser.open(context, upstream_credit, "feature_extractor",
+                                 static_cast<uint32_t>(credits)))) {
+        credit_listener.close();
+        credit_advertiser.close();
+        zmq_close(publisher);
+        zmq_close(subscriber);
+        zmq_ctx_destroy(context);
+        return 1;
+    }
+    
     // Give time for subscribers to connect
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
     
-    // Create SIFT processor
-    imaging::SIFTProcessor processor;
+    // Stages: decode, detect and (for socket output) serialize, with the
+    // publishing thread below as the last. Decoding frame N+1 and sending
+    // frame N-1 overlap with SIFT on frame N. With a shared-memory output,
+    // messages are serialized straight into the ring by the publisher.
+    using Pipeline = imaging::StagedPipeline<imaging::SiftFrame>;
+    std::vector<Pipeline::Stage> stages;
+    stages.push_back({"decode", static_cast<unsigned>(decode_threads), []() {
+        return Pipeline::Step([](imaging::SiftFrame& frame) {
+            auto start = std::chrono::steady_clock::now();
+            frame.ok = imaging::SIFTProcessor::decodeImage(frame.image.data(), frame.image.size(),
+                                                           frame.gray);
+            frame.decode_ms = millisecondsSince(start);
+            if (!frame.ok) {
+                imaging::Logger::error("Failed to process image: " + frame.metadata.filename);
+            }
+        });
+    }});
+    stages.push_back({"detect", workers, [&tiling]() {
+        // One detector per thread
+        auto sift = std::make_shared<imaging::SIFTProcessor>(tiling);
+        return Pipeline::Step([sift](imaging::SiftFrame& frame) {
+            if (!frame.ok) {
+                return;
+            }
+            auto start = std::chrono::steady_clock::now();
+            frame.ok = sift->extractFeatures(frame.gray, frame.keypoints, frame.descriptors);
+            frame.detect_ms = millisecondsSince(start);
+            frame.gray.release();
+            if (!frame.ok) {
+                imaging::Logger::error("Failed to process image: " + frame.metadata.filename);
+            }
+        });
+    }});
+    if (!shm_output) {
+        stages.push_back({"serialize", static_cast<unsigned>(serialize_threads), [&encode_options]() {
+            return Pipeline::Step([&encode_options](imaging::SiftFrame& frame) {
+                if (frame.ok &&
+                    imaging::MessageProtocol::serializeProcessedDataInto(
+                        frame.message, frame.metadata, frame.image.data(), frame.image.size(),
+                        frame.keypoints, frame.descriptors, encode_options) == 0) {
+                    imaging::Logger::error("Failed to serialize processed data for: " +
+                                           frame.metadata.filename);
+                    frame.ok = false;
+                }
+            });
+        }});
+    }
     
-    imaging::Logger::info("Starting feature extraction...");
+    Pipeline pipeline(stages, static_cast<size_t>(queue_depth), !unordered);
+    if (pipeline.threadCount() == 0) {
+        imaging::Logger::error("Failed to start extraction pipeline");
+        credit_listener.close();
+        credit_advertiser.close();
+        zmq_close(publisher);
+        zmq_close(subscriber);
+        zmq_ctx_destroy(context);
+        return 1;
+    }
+    
+    // OpenCV's own threads would only compete with the detectors for cores
+    if (workers > 1) {
+        cv::setNumThreads(1);
+    }
+    
+    imaging::Logger::info("Starting feature extraction: " + std::to_string(decode_threads) +
+                          " decode, " + std::to_string(workers) + " detect" +
+                          (shm_output ? "" : ", " + std::to_string(serialize_threads) + " serialize") +
+                          " threads" + (unordered ? ", publishing out of order" : ""));
+    
+    // Publishing thread: takes frames from the last stage (in input order
+    // unless unordered) and is the only user of the output socket
+    std::thread output_thread([&]() {
+        // Swapped with the pipeline's queues, so steady state does not allocate
+        imaging::SiftFrame frame;
+        
+        while (g_running) {
+            if (!pipeline.next(frame, std::chrono::milliseconds(100))) {
+                continue;
+            }
+            const imaging::ImageMetadata& metadata = frame.metadata;
+            if (!frame.ok) {
+                continue;
+            }
+            
+            imaging::Logger::info("Extracted " + std::to_string(frame.keypoints.size()) + 
+                                " keypoints from " + metadata.filename + " (decode " +
+                                std::to_string(static_cast<int64_t>(frame.decode_ms)) + " ms, detect " +
+                                std::to_string(static_cast<int64_t>(frame.detect_ms)) + " ms)");
+            
+            // Hold the frame until the logger has room for it. The queues
+            // fill up meanwhile, input stops being read and our own grants
+            // stop, so the generator holds back too.
+            while (g_running &&
+                   !credit_listener.waitForCredit(credit_gate, std::chrono::milliseconds(100))) {
+            }
+            
+            // Serialize straight into the output ring, or send the serialized message
+            int sent = -1;
+            if (shm_output) {
+                size_t capacity = imaging::MessageProtocol::processedDataSize(
+                    metadata, frame.image.size(), frame.keypoints.size(),
+                    frame.descriptors.size(), encode_options);
+                uint8_t* slot = shm_publisher.reserve(capacity);
+                size_t message_size = slot ?
+                    imaging::MessageProtocol::serializeProcessedDataInto(
+                        slot, capacity, metadata, frame.image.data(), frame.image.size(),
+                        frame.keypoints, frame.descriptors, encode_options) : 0;
+                if (message_size == 0) {
+                    imaging::Logger::error("Failed to serialize processed data for: " + metadata.filename);
+                    if (slot) {
+                        shm_publisher.abort();
+                    }
+                    continue;
+                }
+                sent = shm_publisher.publish(publisher, message_size, ZMQ_DONTWAIT);
+            } else {
+                sent = zmq_send(publisher, frame.message.data(), frame.message.size(), ZMQ_DONTWAIT);
+            }
+            
+            if (sent == -1) {
+                imaging::Logger::warning("Failed to send processed data");
+            } else {
+                credit_gate.sent();
+                imaging::Logger::info("Published processed frame: " + metadata.filename);
+            }
+            
+            // The frame goes back round the queues; do not keep the image alive with it
+            frame.image = imaging::SharedBuffer();
+        }
+    });
+    
+    // Enough buffers for every frame the pipeline can hold; they are only
+    // allocated when first needed
+    std::unique_ptr<imaging::BufferPool> buffer_pool;
+    if (pool_buffer_mb > 0) {
+        buffer_pool.reset(new imaging::BufferPool(
+            static_cast<size_t>(pool_buffer_mb) * 1024 * 1024,
+            pipeline.threadCount() * (2 * static_cast<size_t>(queue_depth) + 1) + 2));
+    }
     
     uint64_t frame_count = 0;
-    std::vector<uint8_t> receive_buffer(50 * 1024 * 1024);  // 50MB buffer
+    imaging::ImageReceiver receiver(subscribe_endpoint);
+    receiver.setBufferPool(buffer_pool.get());
+    imaging::SiftFrame frame;
     
     while (g_running) {
-        // Receive image data
-        int received = zmq_recv(subscriber, receive_buffer.data(), receive_buffer.size(), 0);
+        // Receive image data in any framing; the image is parsed in place
+        imaging::ImageDataView image;
+        int received = receiver.receive(subscriber, 0, image);
         
         if (received == -1) {
             if (errno == EAGAIN || errno == EINTR) {
@@ -123,56 +405,51 @@ int main(int argc, char* argv[]) {
             continue;
         }
         
-        // Copy received data to message vector
-        std::vector<uint8_t> message(receive_buffer.begin(), receive_buffer.begin() + received);
-        
-        // Deserialize image data
-        imaging::ImageMetadata metadata;
-        std::vector<uint8_t> image_data;
+        // The image is off the input queue, so upstream may send another
+        credit_advertiser.consumed();
         
-        if (!imaging::MessageProtocol::deserializeImageData(message, metadata, image_data)) {
-            imaging::Logger::error("Failed to deserialize image data");
+        // Keep the image past the next receive: payload frames are taken
+        // over as they are, images read in place from shared memory are
+        // copied out before the producer can overwrite them
+        frame.metadata = image.metadata;
+        frame.image = receiver.detach(image);
+        frame.ok = true;
+        if (!receiver.intact()) {
+            imaging::Logger::warning("Frame overwritten in shared memory while receiving: " +
+                                     frame.metadata.filename);
             continue;
         }
         
         frame_count++;
         imaging::Logger::info("Processing frame " + std::to_string(frame_count) + 
-                            ": " + metadata.filename);
-        
-        // Extract SIFT features
-        std::vector<imaging::KeyPoint> keypoints;
-        std::vector<float> descriptors;
-        
-        auto start_time = std::chrono::high_resolution_clock::now();
-        
-        if (!processor.processImage(image_data, keypoints, descriptors)) {
-            imaging::Logger::error("Failed to process image: " + metadata.filename);
-            continue;
-        }
-        
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-        
-        imaging::Logger::info("Extracted " + std::to_string(keypoints.size()) + 
-                            " keypoints in " + std::to_string(duration.count()) + " ms");
-        
-        // Serialize processed data
-        std::vector<uint8_t> processed_message = 
-            imaging::MessageProtocol::serializeProcessedData(metadata, image_data, 
-                                                            keypoints, descriptors);
+                            ": " + frame.metadata.filename);
         
-        // Publish processed data
-        int sent = zmq_send(publisher, processed_message.data(), processed_message.size(), ZMQ_DONTWAIT);
-        if (sent == -1) {
-            imaging::Logger::warning("Failed to send processed data");
-        } else {
-            imaging::Logger::info("Published processed frame: " + metadata.filename);
+        // Waits while the decode stage's queue is full
+        while (g_running && !pipeline.submit(frame, std::chrono::milliseconds(100))) {
         }
     }
     
+    logSignal();
+    output_thread.join();
+    pipeline.stop();
+    
+    std::string processed;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        processed += (i ? ", " : "") + stages[i].name + " " + std::to_string(pipeline.processed(i));
+    }
+    imaging::Logger::info("Frames processed per stage: " + processed);
+    
+    if (buffer_pool) {
+        imaging::Logger::info("Image buffers: " + std::to_string(buffer_pool->allocated()) +
+                              " allocated, " + std::to_string(buffer_pool->misses()) +
+                              " copies on the heap");
+    }
+    
     imaging::Logger::info("Cleaning up...");
     
     // Cleanup
+    credit_listener.close();
+    credit_advertiser.close();
     zmq_close(publisher);
     zmq_close(subscriber);
     zmq_ctx_destroy(context);
@@ -7,10 +7,16 @@
 
 #include "sift_processor.h"
 #include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <system_error>
+#include <thread>
 
 namespace imaging {
 
-SIFTProcessor::SIFTProcessor() {
+SIFTProcessor::SIFTProcessor(const SiftTiling& tiling) : tiling_(tiling) {
     // Create SIFT detector with default parameters
     sift_ = cv::SIFT::create();
     Logger::info("SIFT processor initialized");
@@ -19,19 +25,49 @@ SIFTProcessor::SIFTProcessor() {
 bool SIFTProcessor::processImage(const std::vector<uint8_t>& image_data,
                                  std::vector<KeyPoint>& keypoints,
                                  std::vector<float>& descriptors) {
+    return processImage(image_data.data(), image_data.size(), keypoints, descriptors);
+}
+
+bool SIFTProcessor::processImage(const uint8_t* image_data, size_t image_size,
+                                 std::vector<KeyPoint>& keypoints,
+                                 std::vector<float>& descriptors) {
+    cv::Mat img;
+    return decodeImage(image_data, image_size, img) && extractFeatures(img, keypoints, descriptors);
+}
+
+bool SIFTProcessor::decodeImage(const uint8_t* image_data, size_t image_size, cv::Mat& gray) {
     try {
-        // Decode image from buffer
-        cv::Mat img = cv::imdecode(image_data, cv::IMREAD_GRAYSCALE);
-        if (img.empty()) {
+        // Decode image straight from the caller's buffer (wrapping, not copying)
+        cv::Mat encoded(1, static_cast<int>(image_size), CV_8UC1,
+                        const_cast<uint8_t*>(image_data));
+        gray = cv::imdecode(encoded, cv::IMREAD_GRAYSCALE);
+        if (gray.empty()) {
             Logger::error("Failed to decode image");
             return false;
         }
-        
+        return true;
+    } catch (const cv::Exception& e) {
+        Logger::error("OpenCV exception: " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool SIFTProcessor::extractFeatures(const cv::Mat& image,
+                                    std::vector<KeyPoint>& keypoints,
+                                    std::vector<float>& descriptors) {
+    try {
         // Detect keypoints and compute descriptors
         std::vector<cv::KeyPoint> cv_keypoints;
         cv::Mat cv_descriptors;
         
-        sift_->detectAndCompute(img, cv::noArray(), cv_keypoints, cv_descriptors);
+        uint64_t pixels = static_cast<uint64_t>(image.rows) * static_cast<uint64_t>(image.cols);
+        if (tiling_.min_pixels > 0 && pixels >= tiling_.min_pixels) {
+            if (!extractTiled(image, cv_keypoints, cv_descriptors)) {
+                return false;
+            }
+        } else {
+            sift_->detectAndCompute(image, cv::noArray(), cv_keypoints, cv_descriptors);
+        }
         
         // Convert to our format
         convertKeyPoints(cv_keypoints, keypoints);
@@ -44,6 +80,204 @@ bool SIFTProcessor::processImage(const std::vector<uint8_t>& image_data,
     }
 }
 
+namespace {
+
+// Keypoints from different tiles this close together, with similar scale
+// and orientation, are one feature found on both sides of a seam
+constexpr float kSeamRadius = 2.0f;
+constexpr float kSeamAngle = 10.0f;
+
+struct TileFeatures {
+    std::vector<cv::KeyPoint> keypoints;  // Global coordinates, inside the core
+    cv::Mat descriptors;                  // One row per keypoint
+    std::vector<bool> duplicate;
+};
+
+bool nearSeam(float position, int tile_size, int extent) {
+    long seam = std::lround(position / tile_size) * tile_size;
+    return seam > 0 && seam < extent && std::fabs(position - seam) < kSeamRadius;
+}
+
+bool sameFeature(const cv::KeyPoint& a, const cv::KeyPoint& b) {
+    float dx = a.pt.x - b.pt.x;
+    float dy = a.pt.y - b.pt.y;
+    if (dx * dx + dy * dy >= kSeamRadius * kSeamRadius) {
+        return false;
+    }
+    if (std::fabs(a.size - b.size) > 0.25f * std::max(a.size, b.size)) {
+        return false;
+    }
+    float angle = std::fabs(a.angle - b.angle);
+    return std::min(angle, 360.0f - angle) < kSeamAngle;
+}
+
+} // namespace
+
+bool SIFTProcessor::extractTiled(const cv::Mat& image,
+                                 std::vector<cv::KeyPoint>& cv_keypoints,
+                                 cv::Mat& cv_descriptors) {
+    const int tile_size = std::max(tiling_.tile_size, 1);
+    const int overlap = std::max(tiling_.overlap, 0);
+    
+    std::vector<cv::Rect> cores;
+    for (int y = 0; y < image.rows; y += tile_size) {
+        for (int x = 0; x < image.cols; x += tile_size) {
+            cores.emplace_back(x, y, std::min(tile_size, image.cols - x),
+                               std::min(tile_size, image.rows - y));
+        }
+    }
+    
+    std::vector<TileFeatures> tiles(cores.size());
+    std::atomic<size_t> next_tile(0);
+    std::atomic<bool> failed(false);
+    std::mutex error_mutex;
+    std::string error;
+    
+    auto work = [&]() {
+        // Runs on helper threads too, where an escaping exception would
+        // terminate the process, so every failure is reported through failed
+        try {
+            // cv::SIFT instances are not documented as thread-safe, so each
+            // thread has its own, with the same parameters as sift_
+            cv::Ptr<cv::SIFT> sift = cv::SIFT::create();
+            size_t i;
+            while (!failed && (i = next_tile++) < cores.size()) {
+                const cv::Rect& core = cores[i];
+                int x0 = std::max(core.x - overlap, 0);
+                int y0 = std::max(core.y - overlap, 0);
+                int x1 = std::min(core.x + core.width + overlap, image.cols);
+                int y1 = std::min(core.y + core.height + overlap, image.rows);
+                cv::Rect region(x0, y0, x1 - x0, y1 - y0);
+                
+                std::vector<cv::KeyPoint> found;
+                cv::Mat descriptors;
+                sift->detectAndCompute(image(region), cv::noArray(), found, descriptors);
+                
+                // Keep what lies in the core; the overlap belongs to neighbours
+                TileFeatures& tile = tiles[i];
+                for (size_t k = 0; k < found.size(); ++k) {
+                    cv::KeyPoint keypoint = found[k];
+                    keypoint.pt.x += static_cast<float>(region.x);
+                    keypoint.pt.y += static_cast<float>(region.y);
+                    if (keypoint.pt.x < core.x || keypoint.pt.x >= core.x + core.width ||
+                        keypoint.pt.y < core.y || keypoint.pt.y >= core.y + core.height) {
+                        continue;
+                    }
+                    tile.keypoints.push_back(keypoint);
+                    tile.descriptors.push_back(descriptors.row(static_cast<int>(k)));
+                }
+                tile.duplicate.assign(tile.keypoints.size(), false);
+            }
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = e.what();
+            failed = true;
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = "unknown exception";
+            failed = true;
+        }
+    };
+    
+    unsigned threads = tiling_.threads > 0 ? tiling_.threads
+                                           : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, cores.size()));
+    std::vector<std::thread> helpers;
+    for (unsigned t = 1; t < threads; ++t) {
+        try {
+            helpers.emplace_back(work);
+        } catch (const std::system_error& e) {
+            // Carry on with the threads we have; they share out every tile
+            Logger::warning("Could not start tile thread: " + std::string(e.what()));
+            break;
+        }
+    }
+    work();
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+    if (failed) {
+        Logger::error("Exception while extracting a tile: " + error);
+        return false;
+    }
+    
+    // A feature straddling a seam can land just inside both cores; keep the
+    // stronger response. Only keypoints near a seam need comparing.
+    struct Candidate {
+        float x;
+        size_t tile;
+        size_t index;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t t = 0; t < tiles.size(); ++t) {
+        for (size_t k = 0; k < tiles[t].keypoints.size(); ++k) {
+            const cv::Point2f& pt = tiles[t].keypoints[k].pt;
+            if (nearSeam(pt.x, tile_size, image.cols) || nearSeam(pt.y, tile_size, image.rows)) {
+                candidates.push_back({pt.x, t, k});
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.x < b.x; });
+    
+    size_t duplicates = 0;
+    for (size_t a = 0; a < candidates.size(); ++a) {
+        for (size_t b = a + 1; b < candidates.size() &&
+                               candidates[b].x - candidates[a].x < kSeamRadius; ++b) {
+            const Candidate& first = candidates[a];
+            const Candidate& second = candidates[b];
+            if (first.tile == second.tile ||
+                tiles[first.tile].duplicate[first.index] ||
+                tiles[second.tile].duplicate[second.index]) {
+                continue;
+            }
+            const cv::KeyPoint& kp1 = tiles[first.tile].keypoints[first.index];
+            const cv::KeyPoint& kp2 = tiles[second.tile].keypoints[second.index];
+            if (sameFeature(kp1, kp2)) {
+                const Candidate& weaker = kp1.response >= kp2.response ? second : first;
+                tiles[weaker.tile].duplicate[weaker.index] = true;
+                duplicates++;
+            }
+        }
+    }
+    
+    // Merge in tile order
+    size_t total = 0;
+    int descriptor_cols = 0;
+    int descriptor_type = CV_32F;
+    for (const auto& tile : tiles) {
+        total += tile.keypoints.size();
+        if (!tile.descriptors.empty()) {
+            descriptor_cols = tile.descriptors.cols;
+            descriptor_type = tile.descriptors.type();
+        }
+    }
+    total -= duplicates;
+    
+    cv_keypoints.clear();
+    cv_keypoints.reserve(total);
+    cv_descriptors.release();
+    if (total > 0) {
+        cv_descriptors.create(static_cast<int>(total), descriptor_cols, descriptor_type);
+    }
+    int row = 0;
+    for (const auto& tile : tiles) {
+        for (size_t k = 0; k < tile.keypoints.size(); ++k) {
+            if (tile.duplicate[k]) {
+                continue;
+            }
+            cv_keypoints.push_back(tile.keypoints[k]);
+            tile.descriptors.row(static_cast<int>(k)).copyTo(cv_descriptors.row(row++));
+        }
+    }
+    
+    Logger::debug("Extracted " + std::to_string(total) + " features from " +
+                  std::to_string(cores.size()) + " tiles of " + std::to_string(image.cols) +
+                  "x" + std::to_string(image.rows) + " image (" + std::to_string(duplicates) +
+                  " seam duplicates removed)");
+    return true;
+}
+
 void SIFTProcessor::convertKeyPoints(const std::vector<cv::KeyPoint>& cv_keypoints,
                                      std::vector<KeyPoint>& keypoints) {
     keypoints.clear();
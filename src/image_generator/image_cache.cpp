@@ -0,0 +1,96 @@
+/*
+ * Image Cache Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_cache.h"
+
+namespace imaging {
+
+ImageCache::ImageCache(size_t max_bytes)
+    : max_bytes_(max_bytes), bytes_(0), hits_(0), misses_(0) {
+}
+
+void ImageCache::setMaxBytes(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_bytes_ = max_bytes;
+    evict();
+}
+
+size_t ImageCache::maxBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_bytes_;
+}
+
+bool ImageCache::fits(size_t size) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size > 0 && size <= max_bytes_;
+}
+
+bool ImageCache::find(const std::string& key, SharedBuffer& image) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = images_.find(key);
+    if (it == images_.end()) {
+        misses_++;
+        return false;
+    }
+    
+    order_.splice(order_.end(), order_, it->second.position);
+    image = it->second.image;
+    hits_++;
+    return true;
+}
+
+void ImageCache::insert(const std::string& key, const SharedBuffer& image) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (image.empty() || image.size() > max_bytes_) {
+        return;
+    }
+    
+    auto it = images_.find(key);
+    if (it != images_.end()) {
+        bytes_ -= it->second.image.size();
+        order_.splice(order_.end(), order_, it->second.position);
+    } else {
+        order_.push_back(key);
+        it = images_.emplace(key, Entry()).first;
+        it->second.position = std::prev(order_.end());
+    }
+    
+    it->second.image = image;
+    bytes_ += image.size();
+    evict();
+}
+
+size_t ImageCache::imageCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return images_.size();
+}
+
+size_t ImageCache::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+uint64_t ImageCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+uint64_t ImageCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+void ImageCache::evict() {
+    while (bytes_ > max_bytes_ && !order_.empty()) {
+        auto oldest = images_.find(order_.front());
+        bytes_ -= oldest->second.image.size();
+        images_.erase(oldest);
+        order_.pop_front();
+    }
+}
+
+} // namespace imaging
@@ -0,0 +1,278 @@
+/*
+ * Image Index Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_index.h"
+#include "image_probe.h"
+#include "content_hash.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace imaging {
+
+namespace {
+
+const char kIndexFileName[] = ".imaging_index";
+
+// Written in native byte order; an index from a machine of the other byte
+// order fails the magic check and is simply rebuilt
+constexpr uint64_t kIndexMagic = 0x3130584449474d49ULL;  // "IMGIDX01"
+
+template<typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+bool get(const std::vector<uint8_t>& in, size_t& offset, T& value) {
+    if (in.size() - offset < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, in.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+// Hash the whole file and probe its header; buffer is reused between files
+bool scanFile(ImageIndexEntry& entry, std::vector<uint8_t>& buffer) {
+    std::ifstream file(entry.path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    buffer.resize(entry.size);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()))) {
+        return false;
+    }
+    
+    entry.content_hash = contentHash(buffer.data(), buffer.size());
+    
+    ImageDimensions dimensions;
+    if (probeImageDimensions(buffer.data(), buffer.size(), dimensions)) {
+        entry.width = dimensions.width;
+        entry.height = dimensions.height;
+        entry.channels = dimensions.channels;
+    }
+    return true;
+}
+
+} // namespace
+
+bool statImageFile(ImageIndexEntry& entry) {
+    struct stat info;
+    if (stat(entry.path.c_str(), &info) != 0) {
+        return false;
+    }
+    entry.size = static_cast<uint64_t>(info.st_size);
+    entry.mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    return true;
+}
+
+ImageIndex::ImageIndex(const std::string& directory, bool recursive)
+    : directory_(directory), recursive_(recursive),
+      index_path_((fs::path(directory) / kIndexFileName).string()), reused_(0), scanned_(0) {
+}
+
+bool ImageIndex::isImageFile(const std::string& path) {
+    static const char* const kExtensions[] = {".png", ".jpg", ".jpeg", ".bmp", ".tiff"};
+    
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    for (const char* extension : kExtensions) {
+        if (ext == extension) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ImageIndex::load() {
+    entries_.clear();
+    
+    std::ifstream file(index_path_, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        return false;
+    }
+    
+    size_t offset = 0;
+    uint64_t magic = 0;
+    uint32_t count = 0;
+    if (!get(data, offset, magic) || magic != kIndexMagic || !get(data, offset, count)) {
+        Logger::warning("Ignoring unreadable image index: " + index_path_);
+        return false;
+    }
+    
+    std::vector<ImageIndexEntry> entries;
+    entries.reserve(std::min<size_t>(count, data.size() / 40));
+    for (uint32_t i = 0; i < count; ++i) {
+        ImageIndexEntry entry;
+        uint16_t name_length = 0;
+        if (!get(data, offset, name_length) || data.size() - offset < name_length) {
+            Logger::warning("Ignoring truncated image index: " + index_path_);
+            return false;
+        }
+        std::string name(reinterpret_cast<const char*>(data.data() + offset), name_length);
+        offset += name_length;
+        
+        if (!get(data, offset, entry.size) || !get(data, offset, entry.mtime) ||
+            !get(data, offset, entry.width) || !get(data, offset, entry.height) ||
+            !get(data, offset, entry.channels) || !get(data, offset, entry.content_hash)) {
+            Logger::warning("Ignoring truncated image index: " + index_path_);
+            return false;
+        }
+        entry.path = (fs::path(directory_) / name).string();
+        entries.push_back(std::move(entry));
+    }
+    
+    entries_ = std::move(entries);
+    return true;
+}
+
+bool ImageIndex::save() const {
+    std::vector<uint8_t> data;
+    put(data, kIndexMagic);
+    put(data, static_cast<uint32_t>(entries_.size()));
+    for (const ImageIndexEntry& entry : entries_) {
+        std::string name = fs::path(entry.path).lexically_relative(directory_).string();
+        put(data, static_cast<uint16_t>(name.size()));
+        data.insert(data.end(), name.begin(), name.end());
+        put(data, entry.size);
+        put(data, entry.mtime);
+        put(data, entry.width);
+        put(data, entry.height);
+        put(data, entry.channels);
+        put(data, entry.content_hash);
+    }
+    
+    // Readers never see a half-written index
+    std::string temp_path = index_path_ + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(reinterpret_cast<const char*>(data.data()),
+                                 static_cast<std::streamsize>(data.size()))) {
+            return false;
+        }
+    }
+    if (std::rename(temp_path.c_str(), index_path_.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ImageIndex::refresh(unsigned threads) {
+    std::error_code ec;
+    fs::recursive_directory_iterator it(directory_, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        Logger::error("Cannot list directory " + directory_ + ": " + ec.message());
+        return false;
+    }
+    
+    std::unordered_map<std::string, const ImageIndexEntry*> previous;
+    previous.reserve(entries_.size());
+    for (const ImageIndexEntry& entry : entries_) {
+        previous[entry.path] = &entry;
+    }
+    
+    // Unchanged files (same size and mtime) keep their indexed metadata
+    std::vector<ImageIndexEntry> entries;
+    std::vector<size_t> pending;
+    for (; it != fs::end(it); it.increment(ec)) {
+        if (ec) {
+            Logger::error("Error listing " + directory_ + ": " + ec.message());
+            return false;
+        }
+        if (!recursive_) {
+            it.disable_recursion_pending();
+        }
+        
+        std::string path = it->path().string();
+        if (!it->is_regular_file(ec) || !isImageFile(path)) {
+            continue;
+        }
+        
+        ImageIndexEntry entry;
+        entry.path = path;
+        if (!statImageFile(entry)) {
+            continue;
+        }
+        
+        auto found = previous.find(path);
+        if (found != previous.end() && found->second->size == entry.size &&
+            found->second->mtime == entry.mtime) {
+            entries.push_back(*found->second);
+        } else {
+            pending.push_back(entries.size());
+            entries.push_back(std::move(entry));
+        }
+    }
+    
+    // Reading and hashing new files dominates, so spread it over threads
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, pending.size()));
+    
+    std::atomic<size_t> next(0);
+    std::vector<uint8_t> failed(entries.size(), 0);
+    auto worker = [&]() {
+        std::vector<uint8_t> buffer;
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            if (!scanFile(entries[pending[i]], buffer)) {
+                failed[pending[i]] = 1;
+            }
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+    
+    reused_ = entries.size() - pending.size();
+    scanned_ = pending.size();
+    
+    // Drop files that vanished or could not be read during the scan
+    size_t kept = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (failed[i]) {
+            Logger::warning("Failed to index image: " + entries[i].path);
+        } else {
+            if (kept != i) {
+                entries[kept] = std::move(entries[i]);
+            }
+            kept++;
+        }
+    }
+    entries.resize(kept);
+    
+    std::sort(entries.begin(), entries.end(),
+              [](const ImageIndexEntry& a, const ImageIndexEntry& b) { return a.path < b.path; });
+    
+    entries_ = std::move(entries);
+    return true;
+}
+
+} // namespace imaging
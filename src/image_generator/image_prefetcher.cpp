@@ -0,0 +1,366 @@
+/*
+ * Image Prefetcher Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_prefetcher.h"
+#include "logger.h"
+#include <algorithm>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef IMAGING_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+namespace imaging {
+
+namespace {
+
+// Disk reads overlap well with a few threads; more only add contention
+constexpr size_t kMaxPrefetchThreads = 4;
+constexpr size_t kPageSize = 4096;
+
+// Fault every page of a mapped file in now rather than on the sending path
+void touchPages(const SharedBuffer& image) {
+    volatile uint8_t sink = 0;
+    for (size_t offset = 0; offset < image.size(); offset += kPageSize) {
+        sink = sink + image.data()[offset];
+    }
+}
+
+} // namespace
+
+#ifdef IMAGING_HAVE_LIBURING
+struct ImagePrefetcher::Uring {
+    io_uring ring;
+    
+    // One file being read, possibly in several short reads
+    struct Read {
+        uint64_t sequence;
+        PrefetchedImage image;
+        int fd;
+        std::vector<uint8_t> buffer;
+        size_t done;
+    };
+    
+    bool submit(Read* read) {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        if (!sqe) {
+            return false;
+        }
+        io_uring_prep_read(sqe, read->fd, read->buffer.data() + read->done,
+                           static_cast<unsigned>(read->buffer.size() - read->done), read->done);
+        io_uring_sqe_set_data(sqe, read);
+        return io_uring_submit(&ring) > 0;
+    }
+};
+#else
+struct ImagePrefetcher::Uring {};
+#endif
+
+ImagePrefetcher::ImagePrefetcher(ImageSource& source, ImageCache& cache, size_t depth,
+                                 size_t max_read_size)
+    : source_(source), cache_(cache), depth_(std::max<size_t>(depth, 1)),
+      max_read_size_(max_read_size), position_(0), slots_(depth_),
+      next_claim_(0), next_consume_(0), running_(false), exhausted_(false) {
+}
+
+ImagePrefetcher::~ImagePrefetcher() {
+    stop();
+}
+
+void ImagePrefetcher::start() {
+    stop();
+    
+    position_ = 0;
+    next_claim_ = 0;
+    next_consume_ = 0;
+    running_ = true;
+    exhausted_ = false;
+
+#ifdef IMAGING_HAVE_LIBURING
+    uring_.reset(new Uring());
+    if (io_uring_queue_init(static_cast<unsigned>(depth_), &uring_->ring, 0) == 0) {
+        threads_.emplace_back(&ImagePrefetcher::uringWorker, this);
+        return;
+    }
+    uring_.reset();
+    Logger::warning("io_uring unavailable, prefetching with threads");
+#endif
+
+    size_t count = std::min(depth_, kMaxPrefetchThreads);
+    for (size_t i = 0; i < count; ++i) {
+        threads_.emplace_back(&ImagePrefetcher::poolWorker, this);
+    }
+}
+
+void ImagePrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    space_.notify_all();
+    ready_.notify_all();
+    
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+
+#ifdef IMAGING_HAVE_LIBURING
+    if (uring_) {
+        io_uring_queue_exit(&uring_->ring);
+        uring_.reset();
+    }
+#endif
+
+    for (Slot& slot : slots_) {
+        slot = Slot();
+    }
+}
+
+bool ImagePrefetcher::next(PrefetchedImage& image, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Slot& slot = slots_[next_consume_ % depth_];
+    if (!ready_.wait_for(lock, timeout, [&]() {
+            return slot.ready || !running_ || (exhausted_ && next_consume_ == next_claim_);
+        }) || !slot.ready) {
+        return false;
+    }
+    
+    image = std::move(slot.image);
+    slot = Slot();
+    next_consume_++;
+    lock.unlock();
+    space_.notify_all();
+    return true;
+}
+
+bool ImagePrefetcher::exhausted() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return exhausted_ && next_consume_ == next_claim_;
+}
+
+const char* ImagePrefetcher::backendName() const {
+    return uring_ ? "io_uring" : "threads";
+}
+
+bool ImagePrefetcher::readImageFile(const std::string& path, SharedBuffer& image) {
+    // Sent straight from the page cache, without a copy into the heap
+    if (mapFile(path, image)) {
+        return true;
+    }
+    
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    
+    std::vector<uint8_t> buffer(size);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
+        return false;
+    }
+    image = SharedBuffer(std::move(buffer));
+    return true;
+}
+
+bool ImagePrefetcher::claim(uint64_t& sequence, PrefetchedImage& image, bool wait) {
+    std::lock_guard<std::mutex> claim_lock(claim_mutex_);
+    auto stopped = [this]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !running_ || exhausted_;
+    };
+    
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_ && !exhausted_ && next_claim_ >= next_consume_ + depth_) {
+            if (!wait) {
+                return false;
+            }
+            space_.wait(lock);
+        }
+        if (!running_ || exhausted_) {
+            return false;
+        }
+    }
+    
+    // No other thread claims meanwhile, so the free slot stays free while the
+    // source is asked; blocking sources are polled to notice stop(). Workers
+    // reuse image, so nothing from the previous frame may carry over.
+    image = PrefetchedImage();
+    std::chrono::milliseconds timeout(wait ? 100 : 0);
+    while (true) {
+        ImageSource::Result result = source_.next(image.entry, timeout);
+        if (result == ImageSource::Result::IMAGE) {
+            break;
+        }
+        if (result == ImageSource::Result::END_OF_PASS) {
+            bool empty_pass = position_ == 0;
+            position_ = 0;
+            if (!empty_pass && source_.rewind()) {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                exhausted_ = true;
+            }
+            ready_.notify_all();
+            return false;
+        }
+        if (!wait || stopped()) {
+            return false;
+        }
+    }
+    
+    image.position = position_++;
+    image.loaded = source_.takeImage(image.image);
+    std::lock_guard<std::mutex> lock(mutex_);
+    sequence = next_claim_++;
+    return true;
+}
+
+void ImagePrefetcher::complete(uint64_t sequence, PrefetchedImage&& image) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& slot = slots_[sequence % depth_];
+        slot.image = std::move(image);
+        slot.ready = true;
+    }
+    ready_.notify_all();
+}
+
+void ImagePrefetcher::load(PrefetchedImage& image) {
+    const ImageIndexEntry& entry = image.entry;
+    if (image.loaded) {
+        return;  // Generated by the source
+    }
+    
+    image.loaded = cache_.find(entry.path, image.image) || loadFile(entry, image.image);
+    
+    // Cached mappings may have lost pages to memory pressure since last time
+    if (image.loaded) {
+        touchPages(image.image);
+    }
+}
+
+bool ImagePrefetcher::loadFile(const ImageIndexEntry& entry, SharedBuffer& image) {
+    bool loaded = entry.size > max_read_size_ ? mapFile(entry.path, image) :
+                                                readImageFile(entry.path, image);
+    if (loaded) {
+        cache_.insert(entry.path, image);
+    }
+    return loaded;
+}
+
+void ImagePrefetcher::poolWorker() {
+    uint64_t sequence;
+    PrefetchedImage image;
+    while (claim(sequence, image, true)) {
+        load(image);
+        complete(sequence, std::move(image));
+    }
+}
+
+#ifdef IMAGING_HAVE_LIBURING
+void ImagePrefetcher::uringWorker() {
+    using Read = Uring::Read;
+    size_t in_flight = 0;
+    
+    while (true) {
+        // Keep up to depth reads in flight; only block for a free slot when idle
+        uint64_t sequence;
+        std::unique_ptr<Read> claimed(new Read());
+        while (in_flight < depth_ && claim(sequence, claimed->image, in_flight == 0)) {
+            Read* read = claimed.get();
+            read->sequence = sequence;
+            read->fd = -1;
+            read->done = 0;
+            const ImageIndexEntry& entry = read->image.entry;
+            
+            // Generated and cached images need no read, empty and large
+            // (mapped only) ones are loaded synchronously
+            PrefetchedImage& image = read->image;
+            if (image.loaded) {
+                complete(sequence, std::move(image));
+                continue;
+            } else if (cache_.find(entry.path, image.image)) {
+                image.loaded = true;
+            } else if (entry.size == 0 || entry.size > max_read_size_) {
+                image.loaded = loadFile(entry, image.image);
+            } else {
+                // Read the file as it is now, not as it was indexed; one
+                // that grew would otherwise be sent cut off at the old size
+                struct stat info;
+                read->fd = open(entry.path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (read->fd != -1 && fstat(read->fd, &info) == 0 && info.st_size > 0 &&
+                    static_cast<uint64_t>(info.st_size) <= max_read_size_) {
+                    read->buffer.resize(static_cast<size_t>(info.st_size));
+                    if (uring_->submit(read)) {
+                        claimed.release();
+                        claimed.reset(new Read());
+                        in_flight++;
+                        continue;
+                    }
+                }
+                if (read->fd != -1) {
+                    close(read->fd);
+                }
+                image.loaded = loadFile(entry, image.image);
+            }
+            
+            if (image.loaded) {
+                touchPages(image.image);
+            }
+            complete(sequence, std::move(image));
+        }
+        
+        if (in_flight == 0) {
+            break;  // Stopped
+        }
+        
+        io_uring_cqe* cqe;
+        if (io_uring_wait_cqe(&uring_->ring, &cqe) != 0) {
+            continue;
+        }
+        std::unique_ptr<Read> read(static_cast<Read*>(io_uring_cqe_get_data(cqe)));
+        int result = cqe->res;
+        io_uring_cqe_seen(&uring_->ring, cqe);
+        
+        // Short read: continue where it stopped
+        bool finished = false;
+        if (result > 0) {
+            read->done += static_cast<size_t>(result);
+            finished = read->done == read->buffer.size();
+            if (!finished && uring_->submit(read.get())) {
+                read.release();
+                continue;
+            }
+        }
+        
+        close(read->fd);
+        in_flight--;
+        if (finished) {
+            read->image.image = SharedBuffer(std::move(read->buffer));
+            read->image.loaded = true;
+            cache_.insert(read->image.entry.path, read->image.image);
+        } else {
+            // The file changed size or the read failed; load it the slow way
+            read->image.loaded = loadFile(read->image.entry, read->image.image);
+        }
+        complete(read->sequence, std::move(read->image));
+    }
+}
+#else
+void ImagePrefetcher::uringWorker() {
+}
+#endif
+
+} // namespace imaging
@@ -7,24 +7,46 @@
 
 #include "image_publisher.h"
 #include "logger.h"
+#include "zmq_helpers.h"
+#include "image_probe.h"
+#include "image_prefetcher.h"
 #include <opencv2/opencv.hpp>
 #include <filesystem>
 #include <fstream>
 #include <chrono>
 #include <thread>
 #include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
 
 namespace fs = std::filesystem;
 
 namespace imaging {
 
+namespace {
+
+std::string formatDouble(double value, int decimals) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.*f", decimals, value);
+    return text;
+}
+
+} // namespace
+
 ImagePublisher::ImagePublisher(const std::string& endpoint)
-    : endpoint_(endpoint), context_(nullptr), publisher_(nullptr), 
-      running_(false), current_index_(0) {
+    : endpoint_(endpoint), context_(nullptr), publisher_(nullptr), recursive_(false),
+      running_(false), multipart_(true),
+      chunk_size_(4 * 1024 * 1024), next_transfer_id_(0),
+      shm_(isShmEndpoint(endpoint)), shm_capacity_(256 * 1024 * 1024),
+      cache_(1024 * 1024 * 1024), prefetch_depth_(4), send_flags_(ZMQ_DONTWAIT),
+      frame_count_(0), drop_policy_(DropPolicy::OLDEST), credit_queue_depth_(4), drop_nth_(2) {
+    rate_.setFrameRate(10.0);
 }
 
 ImagePublisher::~ImagePublisher() {
     stop();
+    credit_listener_.close();
     if (publisher_) {
         zmq_close(publisher_);
     }
@@ -57,14 +79,36 @@ bool ImagePublisher::initialize() {
     int sndhwm = 100;  // Send high water mark
     zmq_setsockopt(publisher_, ZMQ_SNDHWM, &sndhwm, sizeof(sndhwm));
     
+    // Unthrottled: wait for subscribers at the high water mark instead of
+    // dropping, so the rate is whatever downstream sustains
+    if (rate_.mode() == RateController::Mode::UNTHROTTLED) {
+        int nodrop = 1;
+        zmq_setsockopt(publisher_, ZMQ_XPUB_NODROP, &nodrop, sizeof(nodrop));
+    }
+    
+    // Shared-memory endpoints publish descriptors of records in the ring
+    if (shm_ && !shm_publisher_.open(endpoint_, shm_capacity_)) {
+        Logger::error("Failed to create shared memory ring for: " + endpoint_);
+        return false;
+    }
+    
     // Bind to endpoint
-    if (zmq_bind(publisher_, endpoint_.c_str()) != 0) {
+    if (zmq_bind(publisher_, transportEndpoint(endpoint_).c_str()) != 0) {
         Logger::error("Failed to bind to endpoint: " + endpoint_);
         return false;
     }
     
     Logger::info("Publisher bound to: " + endpoint_);
     
+    // Side channel on which downstream stages grant credit
+    if (!credit_endpoint_.empty()) {
+        if (!credit_listener_.open(context_, credit_endpoint_)) {
+            return false;
+        }
+        Logger::info("Waiting for credit on: " + credit_endpoint_ + " (drop policy " +
+                     dropPolicyName(drop_policy_) + ")");
+    }
+    
     // Give time for subscribers to connect
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
     
@@ -79,129 +123,433 @@ bool ImagePublisher::loadImagesFromDirectory(const std::string& directory) {
         return false;
     }
     
-    image_paths_.clear();
-    
-    // Supported image extensions
-    std::vector<std::string> extensions = {".png", ".jpg", ".jpeg", ".bmp", ".tiff"};
-    
-    for (const auto& entry : fs::directory_iterator(directory)) {
-        if (entry.is_regular_file()) {
-            std::string path = entry.path().string();
-            std::string ext = entry.path().extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-            
-            if (std::find(extensions.begin(), extensions.end(), ext) != extensions.end()) {
-                image_paths_.push_back(path);
-            }
-        }
+    // Only files added or changed since the index was written are scanned
+    auto start = std::chrono::steady_clock::now();
+    ImageIndex index(directory, recursive_);
+    index.load();
+    if (!index.refresh()) {
+        return false;
+    }
+    if (index.scannedCount() > 0 && !index.save()) {
+        Logger::warning("Failed to write image index: " + index.indexPath());
     }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
     
-    // Sort paths for consistent ordering
-    std::sort(image_paths_.begin(), image_paths_.end());
+    size_t count = index.entries().size();
+    source_.reset(new ImageListSource(index.entries()));
     
-    Logger::info("Found " + std::to_string(image_paths_.size()) + " images");
+    Logger::info("Found " + std::to_string(count) + " images (" +
+                 std::to_string(index.reusedCount()) + " from index, " +
+                 std::to_string(index.scannedCount()) + " scanned) in " +
+                 std::to_string(elapsed) + " ms");
+    
+    return count > 0;
+}
+
+bool ImagePublisher::loadImagesFromManifest(const std::string& manifest_path) {
+    Logger::info("Loading images from manifest: " + manifest_path);
     
-    return !image_paths_.empty();
+    std::unique_ptr<ManifestImageSource> manifest(new ManifestImageSource(manifest_path));
+    if (!manifest->open()) {
+        return false;
+    }
+    source_ = std::move(manifest);
+    return true;
 }
 
-bool ImagePublisher::readImageFile(const std::string& path, std::vector<uint8_t>& buffer) {
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file) {
+bool ImagePublisher::streamImagesFromDirectory(const std::string& directory) {
+    Logger::info("Streaming images from directory: " + directory);
+    
+    if (!fs::exists(directory) || !fs::is_directory(directory)) {
+        Logger::error("Directory does not exist: " + directory);
         return false;
     }
     
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
+    source_.reset(new DirectoryStreamSource(directory, recursive_));
+    return true;
+}
+
+bool ImagePublisher::watchDirectory(const std::string& directory) {
+    Logger::info("Watching directory for new images: " + directory);
     
-    buffer.resize(size);
-    return file.read(reinterpret_cast<char*>(buffer.data()), size).good();
+    std::unique_ptr<WatchDirectorySource> watch(new WatchDirectorySource(directory, recursive_));
+    if (!watch->open()) {
+        return false;
+    }
+    source_ = std::move(watch);
+    cache_.setMaxBytes(0);
+    return true;
 }
 
-bool ImagePublisher::getImageInfo(const std::string& path, uint32_t& width, 
-                                   uint32_t& height, uint32_t& channels) {
-    cv::Mat img = cv::imread(path, cv::IMREAD_UNCHANGED);
+bool ImagePublisher::getImageInfo(const std::string& path, const uint8_t* data, size_t size,
+                                  ImageMetadata& metadata) {
+    // Streamed images are not in memory; their header is at the start of the file
+    std::vector<uint8_t> prefix;
+    if (!data) {
+        std::ifstream file(path, std::ios::binary);
+        prefix.resize(kImageProbeBytes);
+        file.read(reinterpret_cast<char*>(prefix.data()), prefix.size());
+        prefix.resize(static_cast<size_t>(file.gcount()));
+    }
+    
+    ImageDimensions dimensions;
+    if (data ? probeImageDimensions(data, size, dimensions) :
+               probeImageDimensions(prefix.data(), prefix.size(), dimensions)) {
+        metadata.width = dimensions.width;
+        metadata.height = dimensions.height;
+        metadata.channels = dimensions.channels;
+        return true;
+    }
+    
+    // Unusual headers: decode the image, from memory when we have it
+    Logger::debug("Header probe failed, decoding: " + path);
+    cv::Mat img;
+    if (data) {
+        cv::Mat encoded(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t*>(data));
+        img = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+    } else {
+        img = cv::imread(path, cv::IMREAD_UNCHANGED);
+    }
     if (img.empty()) {
         return false;
     }
     
-    width = img.cols;
-    height = img.rows;
-    channels = img.channels();
+    metadata.width = img.cols;
+    metadata.height = img.rows;
+    metadata.channels = img.channels();
     
     return true;
 }
 
 void ImagePublisher::publishImages() {
-    if (image_paths_.empty()) {
+    if (!source_) {
         Logger::error("No images to publish");
         return;
     }
     
     running_ = true;
-    current_index_ = 0;
     
     Logger::info("Starting continuous image publishing...");
     Logger::info("Press Ctrl+C to stop");
     
-    uint64_t frame_count = 0;
+    frame_count_ = 0;
+    DropQueue<PendingFrame> waiting(credit_queue_depth_, drop_policy_, drop_nth_);
+    
+    // Images are loaded ahead in the background; this thread only sends.
+    // Large images that will be chunked are never read into the heap.
+    bool chunking = !shm_ && chunk_size_ > 0;
+    ImagePrefetcher prefetcher(*source_, cache_, prefetch_depth_,
+                               chunking ? chunk_size_ : SIZE_MAX);
+    prefetcher.start();
+    Logger::info("Publishing " + source_->describe() + ", prefetching " +
+                 std::to_string(prefetch_depth_) + " images ahead using " +
+                 prefetcher.backendName());
     
     while (running_) {
-        const std::string& path = image_paths_[current_index_];
+        PrefetchedImage prefetched;
+        if (!prefetcher.next(prefetched, std::chrono::milliseconds(100))) {
+            if (prefetcher.exhausted()) {
+                Logger::error("No images to publish");
+                break;
+            }
+            // Nothing new to send (e.g. watching an idle directory); frames
+            // waiting for credit still go out as soon as it arrives
+            if (credit_listener_.isOpen()) {
+                credit_listener_.poll(credit_gate_, std::chrono::milliseconds(0));
+                drainWaiting(waiting);
+            }
+            continue;
+        }
+        
+        // Report on the cache after each pass over the dataset
+        if (prefetched.position == 0 && frame_count_ > 0 && cache_.maxBytes() > 0) {
+            uint64_t lookups = cache_.hits() + cache_.misses();
+            Logger::info("Image cache: " + std::to_string(cache_.imageCount()) + " images, " +
+                         std::to_string(cache_.bytes() / (1024 * 1024)) + " MB, " +
+                         std::to_string(lookups ? cache_.hits() * 100 / lookups : 0) + "% hits");
+        }
+        const ImageIndexEntry& entry = prefetched.entry;
+        const std::string& path = entry.path;
         
-        // Read image data
-        std::vector<uint8_t> image_data;
-        if (!readImageFile(path, image_data)) {
+        // Images that could not be mapped are streamed from disk one chunk
+        // at a time when they are sent in chunks anyway
+        bool in_memory = prefetched.loaded;
+        if (!in_memory) {
+            prefetched.image = SharedBuffer();
+        }
+        const SharedBuffer& image = prefetched.image;
+        if (entry.size > UINT32_MAX) {
+            Logger::error("Image too large: " + path);
+            continue;
+        }
+        if (!in_memory && !(chunking && entry.size > chunk_size_)) {
             Logger::error("Failed to read image: " + path);
-            current_index_ = (current_index_ + 1) % image_paths_.size();
             continue;
         }
         
         // Get image metadata
         ImageMetadata metadata;
-        metadata.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
-        metadata.data_size = static_cast<uint32_t>(image_data.size());
+        metadata.timestamp = entry.timestamp ? entry.timestamp :
+                             std::chrono::system_clock::now().time_since_epoch().count();
+        metadata.data_size = in_memory ? static_cast<uint32_t>(image.size()) :
+                                         static_cast<uint32_t>(entry.size);
         metadata.filename = fs::path(path).filename().string();
+        metadata.width = entry.width;
+        metadata.height = entry.height;
+        metadata.channels = entry.channels;
         
-        if (!getImageInfo(path, metadata.width, metadata.height, metadata.channels)) {
+        // The index could not probe this file, or it changed since indexing
+        bool stale = in_memory && image.size() != entry.size;
+        if ((entry.width == 0 || stale) &&
+            !getImageInfo(path, in_memory ? image.data() : nullptr, image.size(), metadata)) {
             Logger::error("Failed to get image info: " + path);
-            current_index_ = (current_index_ + 1) % image_paths_.size();
             continue;
         }
         
-        // Serialize message
-        std::vector<uint8_t> message = MessageProtocol::serializeImageData(metadata, image_data);
+        // Wait for this frame's slot in the schedule, then send
+        if (credit_listener_.isOpen()) {
+            drainUntilDue(waiting);
+        }
+        rate_.pace(metadata.data_size);
+        PendingFrame frame = {path, metadata, image};
+        if (credit_listener_.isOpen()) {
+            sendWithCredit(std::move(frame), waiting);
+        } else {
+            sendFrame(frame);
+        }
         
-        // Send message
-        int sent = zmq_send(publisher_, message.data(), message.size(), ZMQ_DONTWAIT);
-        if (sent == -1) {
-            if (errno == EAGAIN) {
-                Logger::warning("Send buffer full, skipping frame");
-            } else {
-                Logger::error("Failed to send message: " + std::string(zmq_strerror(errno)));
-            }
+        // Report the achieved rate and pacing error periodically
+        RateController::Stats rate = rate_.stats();
+        if (rate.elapsed_seconds >= 10.0) {
+            Logger::info("Rate: " + formatDouble(rate.frames_per_second, 1) + " fps, " +
+                         formatDouble(rate.bytes_per_second / (1024 * 1024), 1) + " MB/s, pacing error " +
+                         formatDouble(rate.mean_lateness_us, 0) + " us mean / " +
+                         formatDouble(rate.max_lateness_us, 0) + " us max" +
+                         (rate.resyncs ? ", " + std::to_string(rate.resyncs) + " resyncs" : ""));
+            rate_.resetStats();
+        }
+    }
+    
+    // Frames still waiting for credit: send what downstream accepts, and
+    // keep waiting for more unless we were told to stop
+    if (credit_listener_.isOpen()) {
+        credit_listener_.poll(credit_gate_, std::chrono::milliseconds(0));
+        drainWaiting(waiting);
+        while (running_ && !waiting.empty()) {
+            credit_listener_.waitForCredit(credit_gate_, std::chrono::milliseconds(100));
+            drainWaiting(waiting);
+        }
+        if (!waiting.empty()) {
+            Logger::warning("Discarded " + std::to_string(waiting.size()) +
+                            " frames still waiting for credit");
+        }
+    }
+    
+    prefetcher.stop();
+    Logger::info("Stopped publishing images");
+}
+
+bool ImagePublisher::sendFrame(const PendingFrame& frame) {
+    const ImageMetadata& metadata = frame.metadata;
+    bool chunked = !shm_ && chunk_size_ > 0 && metadata.data_size > chunk_size_;
+    int sent = chunked ? sendImageChunks(frame.path, metadata, frame.image) :
+                         sendImage(metadata, frame.image);
+    if (sent == -1) {
+        if (errno == EAGAIN) {
+            Logger::warning("Send buffer full, skipping frame");
         } else {
-            frame_count++;
-            if (frame_count % 10 == 0) {
-                Logger::info("Published frame " + std::to_string(frame_count) + 
-                           ": " + metadata.filename + 
-                           " (" + std::to_string(metadata.width) + "x" + 
-                           std::to_string(metadata.height) + ", " + 
-                           std::to_string(metadata.data_size / 1024) + " KB)");
-            }
+            Logger::error("Failed to send message: " + std::string(zmq_strerror(errno)));
         }
+        return false;
+    }
+    
+    frame_count_++;
+    if (frame_count_ % 10 == 0) {
+        Logger::info("Published frame " + std::to_string(frame_count_) + 
+                   ": " + metadata.filename + 
+                   " (" + std::to_string(metadata.width) + "x" + 
+                   std::to_string(metadata.height) + ", " + 
+                   std::to_string(metadata.data_size / 1024) + " KB)");
+    }
+    return true;
+}
+
+void ImagePublisher::sendWithCredit(PendingFrame&& frame, DropQueue<PendingFrame>& waiting) {
+    if (rate_.mode() == RateController::Mode::UNTHROTTLED) {
+        // Nothing forces frames out on a schedule, so wait rather than drop
+        while (running_ &&
+               !credit_listener_.waitForCredit(credit_gate_, std::chrono::milliseconds(100))) {
+        }
+    } else {
+        credit_listener_.poll(credit_gate_, std::chrono::milliseconds(0));
+    }
+    
+    if (!waiting.push(std::move(frame))) {
+        Logger::warning("No credit downstream, dropped a frame (" +
+                        std::to_string(waiting.dropped()) + " so far, policy " +
+                        dropPolicyName(drop_policy_) + ")");
+    }
+    
+    drainWaiting(waiting);
+}
+
+void ImagePublisher::drainWaiting(DropQueue<PendingFrame>& waiting) {
+    // Only frames that left the socket use up credit
+    while (!waiting.empty() && credit_gate_.available(CreditGate::Clock::now()) > 0) {
+        if (sendFrame(waiting.front())) {
+            credit_gate_.sent();
+        }
+        waiting.pop();
+    }
+}
+
+void ImagePublisher::drainUntilDue(DropQueue<PendingFrame>& waiting) {
+    // At low rates the gap between frames is long; spend it listening for
+    // credit instead of leaving queued frames until the next slot
+    RateController::Clock::time_point due = rate_.due();
+    while (running_ && !waiting.empty()) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            due - RateController::Clock::now());
+        if (remaining.count() <= 0) {
+            break;
+        }
+        credit_listener_.poll(credit_gate_, std::min(remaining, std::chrono::milliseconds(100)));
+        drainWaiting(waiting);
+    }
+}
+
+int ImagePublisher::sendImage(const ImageMetadata& metadata, const SharedBuffer& image) {
+    if (shm_) {
+        // Serialize straight into the ring; only the descriptor goes over ZeroMQ
+        size_t size = MessageProtocol::imageDataSize(metadata, image.size());
+        uint8_t* slot = shm_publisher_.reserve(size);
+        if (!slot) {
+            return -1;
+        }
+        MessageProtocol::serializeImageDataInto(slot, size, metadata, image.data(), image.size());
+        return shm_publisher_.publish(publisher_, size, send_flags_);
+    }
+    
+    if (!multipart_) {
+        size_t size = MessageProtocol::serializeImageDataInto(message_buffer_, metadata,
+                                                              image.data(), image.size());
+        return zmq_send(publisher_, message_buffer_.data(), size, send_flags_);
+    }
+    
+    // Header frame first, then the image bytes handed to ZeroMQ without a copy
+    std::vector<uint8_t> header = MessageProtocol::serializeImageHeader(metadata);
+    if (zmq_send(publisher_, header.data(), header.size(), ZMQ_SNDMORE | send_flags_) == -1) {
+        return -1;
+    }
+    
+    return sendSharedBuffer(publisher_, image, send_flags_);
+}
+
+int ImagePublisher::sendImageChunks(const std::string& path, const ImageMetadata& metadata,
+                                    const SharedBuffer& image) {
+    std::ifstream file;
+    if (image.empty()) {
+        file.open(path, std::ios::binary);
+        if (!file) {
+            errno = EIO;
+            return -1;
+        }
+    }
+    
+    ImageChunkHeader header;
+    header.metadata = metadata;
+    header.transfer_id = next_transfer_id_++;
+    header.chunk_count = static_cast<uint32_t>((metadata.data_size + chunk_size_ - 1) / chunk_size_);
+    
+    for (uint32_t index = 0; index < header.chunk_count; ++index) {
+        header.chunk_index = index;
+        header.chunk_offset = static_cast<uint32_t>(index * chunk_size_);
         
-        // Move to next image (loop back if at end)
-        current_index_ = (current_index_ + 1) % image_paths_.size();
+        // Each chunk from disk gets its own buffer, released by ZeroMQ once
+        // it is sent; chunks of a mapped or cached image share its buffer
+        size_t length = std::min(chunk_size_, metadata.data_size - static_cast<size_t>(header.chunk_offset));
+        SharedBuffer chunk;
+        if (image.empty()) {
+            std::vector<uint8_t> bytes(length);
+            if (!file.read(reinterpret_cast<char*>(bytes.data()), length)) {
+                errno = EIO;
+                return -1;
+            }
+            chunk = SharedBuffer(std::move(bytes));
+        } else {
+            chunk = image.slice(header.chunk_offset, length);
+        }
         
-        // Small delay to avoid overwhelming the system
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::vector<uint8_t> frame = MessageProtocol::serializeImageChunkHeader(header);
+        if (zmq_send(publisher_, frame.data(), frame.size(), ZMQ_SNDMORE | send_flags_) == -1 ||
+            sendSharedBuffer(publisher_, chunk, send_flags_) == -1) {
+            return -1;
+        }
     }
     
-    Logger::info("Stopped publishing images");
+    return static_cast<int>(metadata.data_size);
 }
 
 void ImagePublisher::stop() {
     running_ = false;
 }
 
+void ImagePublisher::setMultipartFraming(bool enabled) {
+    multipart_ = enabled;
+}
+
+void ImagePublisher::setChunkSize(size_t chunk_size) {
+    chunk_size_ = chunk_size;
+}
+
+void ImagePublisher::setShmCapacity(size_t capacity) {
+    shm_capacity_ = capacity;
+}
+
+void ImagePublisher::setCacheSize(size_t bytes) {
+    cache_.setMaxBytes(bytes);
+}
+
+void ImagePublisher::useSyntheticImages(const SyntheticImageOptions& options) {
+    // The source keeps its encoded frames within the cache budget itself
+    SyntheticImageOptions synthetic = options;
+    synthetic.cache_bytes = cache_.maxBytes();
+    source_.reset(new SyntheticImageSource(synthetic));
+    cache_.setMaxBytes(0);
+}
+
+void ImagePublisher::setRecursive(bool recursive) {
+    recursive_ = recursive;
+}
+
+void ImagePublisher::setPrefetchDepth(size_t depth) {
+    prefetch_depth_ = std::max<size_t>(depth, 1);
+}
+
+void ImagePublisher::setFrameRate(double frames_per_second) {
+    rate_.setFrameRate(frames_per_second);
+    send_flags_ = ZMQ_DONTWAIT;
+}
+
+void ImagePublisher::setByteRate(double bytes_per_second) {
+    rate_.setByteRate(bytes_per_second);
+    send_flags_ = ZMQ_DONTWAIT;
+}
+
+void ImagePublisher::setUnthrottled() {
+    rate_.setUnthrottled();
+    send_flags_ = 0;
+}
+
+void ImagePublisher::setCreditEndpoint(const std::string& endpoint) {
+    credit_endpoint_ = endpoint;
+}
+
+void ImagePublisher::setDropPolicy(DropPolicy policy, size_t queue_depth, size_t nth) {
+    drop_policy_ = policy;
+    credit_queue_depth_ = std::max<size_t>(queue_depth, 1);
+    drop_nth_ = std::max<size_t>(nth, 1);
+}
+
 } // namespace imaging
@@ -0,0 +1,377 @@
+/*
+ * Image Source Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_source.h"
+#include "logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace imaging {
+
+ImageListSource::ImageListSource(std::vector<ImageIndexEntry> images)
+    : images_(std::move(images)), position_(0) {
+}
+
+ImageSource::Result ImageListSource::next(ImageIndexEntry& entry, std::chrono::milliseconds) {
+    if (position_ >= images_.size()) {
+        return Result::END_OF_PASS;
+    }
+    entry = images_[position_++];
+    return Result::IMAGE;
+}
+
+bool ImageListSource::rewind() {
+    position_ = 0;
+    return true;
+}
+
+std::string ImageListSource::describe() const {
+    return std::to_string(images_.size()) + " indexed images";
+}
+
+ManifestImageSource::ManifestImageSource(const std::string& manifest_path)
+    : manifest_path_(manifest_path),
+      base_directory_(fs::path(manifest_path).parent_path().string()) {
+}
+
+bool ManifestImageSource::open() {
+    file_.close();
+    file_.clear();
+    file_.open(manifest_path_);
+    if (!file_) {
+        Logger::error("Cannot open manifest: " + manifest_path_);
+        return false;
+    }
+    return true;
+}
+
+bool ManifestImageSource::parseLine(const std::string& line, std::string& path, int64_t& timestamp) {
+    size_t begin = 0;
+    size_t end = line.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(line[begin]))) {
+        begin++;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(line[end - 1]))) {
+        end--;
+    }
+    if (begin == end || line[begin] == '#') {
+        return false;
+    }
+    
+    // A trailing all-digit field is the timestamp; anything else belongs to
+    // the path, so paths may contain spaces
+    timestamp = 0;
+    size_t split = line.find_last_of(" \t", end - 1);
+    if (split != std::string::npos && split > begin) {
+        std::string field = line.substr(split + 1, end - split - 1);
+        char* field_end = nullptr;
+        long long value = std::strtoll(field.c_str(), &field_end, 10);
+        if (std::isdigit(static_cast<unsigned char>(field[0])) && *field_end == '\0') {
+            timestamp = value;
+            end = split;
+            while (end > begin && std::isspace(static_cast<unsigned char>(line[end - 1]))) {
+                end--;
+            }
+        }
+    }
+    
+    path = line.substr(begin, end - begin);
+    return true;
+}
+
+ImageSource::Result ManifestImageSource::next(ImageIndexEntry& entry, std::chrono::milliseconds) {
+    std::string line;
+    while (std::getline(file_, line)) {
+        std::string path;
+        int64_t timestamp;
+        if (!parseLine(line, path, timestamp)) {
+            continue;
+        }
+        
+        entry = ImageIndexEntry();
+        entry.path = fs::path(path).is_absolute() ? path : (fs::path(base_directory_) / path).string();
+        entry.timestamp = timestamp;
+        
+        // Missing files are reported when they fail to load
+        statImageFile(entry);
+        return Result::IMAGE;
+    }
+    return Result::END_OF_PASS;
+}
+
+bool ManifestImageSource::rewind() {
+    file_.clear();
+    file_.seekg(0, std::ios::beg);
+    return static_cast<bool>(file_);
+}
+
+std::string ManifestImageSource::describe() const {
+    return "manifest " + manifest_path_;
+}
+
+DirectoryStreamSource::DirectoryStreamSource(const std::string& directory, bool recursive,
+                                             size_t queue_capacity)
+    : directory_(directory), recursive_(recursive),
+      queue_capacity_(std::max<size_t>(queue_capacity, 1)), listed_(0),
+      listing_done_(false), stopping_(false) {
+    startListing();
+}
+
+DirectoryStreamSource::~DirectoryStreamSource() {
+    stopListing();
+}
+
+ImageSource::Result DirectoryStreamSource::next(ImageIndexEntry& entry,
+                                                std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!filled_.wait_for(lock, timeout, [this]() { return !queue_.empty() || listing_done_; })) {
+        return Result::PENDING;
+    }
+    if (queue_.empty()) {
+        return Result::END_OF_PASS;
+    }
+    
+    entry = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    space_.notify_one();
+    return Result::IMAGE;
+}
+
+bool DirectoryStreamSource::rewind() {
+    stopListing();
+    startListing();
+    return true;
+}
+
+std::string DirectoryStreamSource::describe() const {
+    return "directory " + directory_ + (recursive_ ? " (recursive, streamed)" : " (streamed)");
+}
+
+size_t DirectoryStreamSource::listedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return listed_;
+}
+
+void DirectoryStreamSource::startListing() {
+    queue_.clear();
+    listed_ = 0;
+    listing_done_ = false;
+    stopping_ = false;
+    lister_ = std::thread(&DirectoryStreamSource::listDirectory, this);
+}
+
+void DirectoryStreamSource::stopListing() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    space_.notify_all();
+    if (lister_.joinable()) {
+        lister_.join();
+    }
+}
+
+bool DirectoryStreamSource::push(ImageIndexEntry&& entry) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_.wait(lock, [this]() { return queue_.size() < queue_capacity_ || stopping_; });
+    if (stopping_) {
+        return false;
+    }
+    queue_.push_back(std::move(entry));
+    listed_++;
+    lock.unlock();
+    filled_.notify_one();
+    return true;
+}
+
+void DirectoryStreamSource::listDirectory() {
+    // Entries are stat()ed here so the publisher knows file sizes up front;
+    // probing and hashing are left to the loader
+    auto list = [this](auto& it) {
+        std::error_code ec;
+        for (; it != fs::end(it); it.increment(ec)) {
+            if (ec) {
+                Logger::warning("Error listing " + directory_ + ": " + ec.message());
+                break;
+            }
+            std::string path = it->path().string();
+            if (!it->is_regular_file(ec) || !ImageIndex::isImageFile(path)) {
+                continue;
+            }
+            ImageIndexEntry entry;
+            entry.path = path;
+            if (statImageFile(entry) && !push(std::move(entry))) {
+                return;
+            }
+        }
+    };
+    
+    std::error_code ec;
+    if (recursive_) {
+        fs::recursive_directory_iterator it(directory_, fs::directory_options::skip_permission_denied, ec);
+        if (!ec) {
+            list(it);
+        }
+    } else {
+        fs::directory_iterator it(directory_, ec);
+        if (!ec) {
+            list(it);
+        }
+    }
+    if (ec) {
+        Logger::error("Cannot list directory " + directory_ + ": " + ec.message());
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listing_done_ = true;
+    }
+    filled_.notify_all();
+}
+
+WatchDirectorySource::WatchDirectorySource(const std::string& directory, bool recursive,
+                                           size_t queue_capacity)
+    : directory_(directory), recursive_(recursive),
+      queue_capacity_(std::max<size_t>(queue_capacity, 1)), fd_(-1),
+      event_buffer_(64 * 1024), dropped_(0) {
+}
+
+WatchDirectorySource::~WatchDirectorySource() {
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+bool WatchDirectorySource::open() {
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ == -1) {
+        Logger::error("inotify_init1 failed: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    if (!addWatch(directory_)) {
+        return false;
+    }
+    
+    if (recursive_) {
+        std::error_code ec;
+        fs::recursive_directory_iterator it(directory_, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != fs::end(it); it.increment(ec)) {
+            if (it->is_directory(ec)) {
+                addWatch(it->path().string());
+            }
+        }
+    }
+    return true;
+}
+
+bool WatchDirectorySource::addWatch(const std::string& directory) {
+    // IN_CREATE only matters for new subdirectories
+    uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | (recursive_ ? IN_CREATE : 0);
+    int wd = inotify_add_watch(fd_, directory.c_str(), mask | IN_ONLYDIR);
+    if (wd == -1) {
+        Logger::error("Cannot watch " + directory + ": " + std::strerror(errno));
+        return false;
+    }
+    watches_[wd] = directory;
+    return true;
+}
+
+bool WatchDirectorySource::readEvents(std::chrono::milliseconds timeout) {
+    pollfd pfd = {fd_, POLLIN, 0};
+    int ready = poll(&pfd, 1, static_cast<int>(timeout.count()));
+    if (ready <= 0) {
+        return ready == 0 || errno == EINTR;
+    }
+    
+    while (true) {
+        ssize_t length = read(fd_, event_buffer_.data(), event_buffer_.size());
+        if (length <= 0) {
+            return length == -1 && (errno == EAGAIN || errno == EINTR);
+        }
+        
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event =
+                reinterpret_cast<const inotify_event*>(event_buffer_.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+            
+            if (event->mask & IN_Q_OVERFLOW) {
+                Logger::warning("Watch notifications overflowed, files were missed in " + directory_);
+                continue;
+            }
+            auto watch = watches_.find(event->wd);
+            if (event->mask & IN_IGNORED) {
+                if (watch != watches_.end()) {
+                    watches_.erase(watch);
+                }
+                continue;
+            }
+            if (watch == watches_.end() || event->len == 0) {
+                continue;
+            }
+            
+            std::string path = (fs::path(watch->second) / event->name).string();
+            if (event->mask & IN_ISDIR) {
+                if (recursive_ && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                    addWatch(path);
+                }
+                continue;
+            }
+            if (!(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) || !ImageIndex::isImageFile(path)) {
+                continue;
+            }
+            
+            if (queue_.size() == queue_capacity_) {
+                queue_.pop_front();
+                if (dropped_++ % 100 == 0) {
+                    Logger::warning("Watch queue full, dropping oldest files (" +
+                                    std::to_string(dropped_) + " so far)");
+                }
+            }
+            queue_.push_back(std::move(path));
+        }
+    }
+}
+
+ImageSource::Result WatchDirectorySource::next(ImageIndexEntry& entry,
+                                               std::chrono::milliseconds timeout) {
+    // Take whatever else arrived first, so a full queue drops the oldest
+    if (!readEvents(queue_.empty() ? timeout : std::chrono::milliseconds(0))) {
+        Logger::error("Failed to read watch notifications: " + std::string(std::strerror(errno)));
+    }
+    
+    while (!queue_.empty()) {
+        entry = ImageIndexEntry();
+        entry.path = std::move(queue_.front());
+        queue_.pop_front();
+        
+        // Files removed again before their turn are skipped
+        if (statImageFile(entry)) {
+            return Result::IMAGE;
+        }
+    }
+    return Result::PENDING;
+}
+
+bool WatchDirectorySource::rewind() {
+    return true;
+}
+
+std::string WatchDirectorySource::describe() const {
+    return "new files in " + directory_ + (recursive_ ? " (recursive, watched)" : " (watched)");
+}
+
+} // namespace imaging
@@ -7,19 +7,67 @@
 
 #include "image_publisher.h"
 #include "logger.h"
+#include "command_line.h"
+#include <atomic>
 #include <csignal>
+#include <cstdio>
 #include <iostream>
 #include <memory>
 
 static std::unique_ptr<imaging::ImagePublisher> g_publisher;
+static std::atomic<int> g_signal(0);
 
+// Only async-signal-safe work here: Logger takes a lock the interrupted
+// thread may hold, so the signal is logged once publishing has stopped
 void signalHandler(int signum) {
-    imaging::Logger::info("Interrupt signal (" + std::to_string(signum) + ") received");
+    g_signal = signum;
     if (g_publisher) {
         g_publisher->stop();
     }
 }
 
+static void logSignal() {
+    if (g_signal != 0) {
+        imaging::Logger::info("Interrupt signal (" + std::to_string(g_signal.load()) +
+                              ") received, shutting down");
+    }
+}
+
+// --synthetic=WIDTHxHEIGHT with --texture, --encoding, --channels,
+// --synthetic-frames and --seed
+static bool parseSyntheticOptions(const imaging::CommandLine& args,
+                                  imaging::SyntheticImageOptions& options) {
+    std::string resolution = args.option("synthetic", "1920x1080");
+    unsigned width = 0;
+    unsigned height = 0;
+    char separator = 0;
+    if (std::sscanf(resolution.c_str(), "%u%c%u", &width, &separator, &height) != 3 ||
+        separator != 'x' || width == 0 || height == 0 || width > 32768 || height > 32768) {
+        imaging::Logger::error("Synthetic resolution must be WIDTHxHEIGHT: " + resolution);
+        return false;
+    }
+    options.width = width;
+    options.height = height;
+    
+    std::string encoding = args.option("encoding", "png");
+    if (!imaging::parseSyntheticEncoding(encoding, options.encoding)) {
+        imaging::Logger::error("Unknown synthetic encoding: " + encoding);
+        return false;
+    }
+    
+    options.texture_density = args.optionDouble("texture", options.texture_density);
+    int64_t channels = args.optionInt("channels", options.channels);
+    int64_t frames = args.optionInt("synthetic-frames", static_cast<int64_t>(options.frame_count));
+    if (options.texture_density < 0.0 || (channels != 1 && channels != 3) || frames < 1) {
+        imaging::Logger::error("Invalid synthetic image options");
+        return false;
+    }
+    options.channels = static_cast<uint32_t>(channels);
+    options.frame_count = static_cast<size_t>(frames);
+    options.seed = static_cast<uint64_t>(args.optionInt("seed", 1));
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     // Set up signal handler
     std::signal(SIGINT, signalHandler);
@@ -28,35 +76,115 @@ int main(int argc, char* argv[]) {
     imaging::Logger::info("=== Image Generator Starting ===");
     
     // Parse command line arguments
-    std::string image_directory = "./deep_sea_imaging/raw";
-    std::string endpoint = "tcp://*:5555";
-    
-    if (argc > 1) {
-        image_directory = argv[1];
-    }
-    if (argc > 2) {
-        endpoint = argv[2];
-    }
+    imaging::CommandLine args(argc, argv);
+    std::string image_directory = args.positional(0, "./deep_sea_imaging/raw");
+    std::string endpoint = args.positional(1, "tcp://*:5555");
     
     imaging::Logger::info("Image directory: " + image_directory);
     imaging::Logger::info("Publish endpoint: " + endpoint);
     
     // Create and initialize publisher
     g_publisher = std::make_unique<imaging::ImagePublisher>(endpoint);
+    g_publisher->setMultipartFraming(!args.hasOption("single-frame"));
+    
+    int64_t chunk_size = args.optionInt("chunk-size", 4 * 1024 * 1024);
+    if (chunk_size < 0) {
+        imaging::Logger::error("Chunk size must not be negative");
+        return 1;
+    }
+    g_publisher->setChunkSize(static_cast<size_t>(chunk_size));
+    
+    int64_t shm_size = args.optionInt("shm-size", 256 * 1024 * 1024);
+    if (shm_size <= 0) {
+        imaging::Logger::error("Shared memory size must be positive");
+        return 1;
+    }
+    g_publisher->setShmCapacity(static_cast<size_t>(shm_size));
+    
+    int64_t cache_mb = args.optionInt("cache-mb", 1024);
+    if (cache_mb < 0) {
+        imaging::Logger::error("Cache size must not be negative");
+        return 1;
+    }
+    g_publisher->setCacheSize(static_cast<size_t>(cache_mb) * 1024 * 1024);
+    
+    int64_t prefetch = args.optionInt("prefetch", 4);
+    if (prefetch < 1) {
+        imaging::Logger::error("Prefetch depth must be at least 1");
+        return 1;
+    }
+    g_publisher->setPrefetchDepth(static_cast<size_t>(prefetch));
+    
+    // Pacing: --max-rate, --rate-mb=MB/s or --fps=N (default 10)
+    if (args.hasOption("max-rate")) {
+        g_publisher->setUnthrottled();
+    } else if (args.hasOption("rate-mb")) {
+        double rate_mb = args.optionDouble("rate-mb", 0.0);
+        if (rate_mb <= 0.0) {
+            imaging::Logger::error("Byte rate must be positive");
+            return 1;
+        }
+        g_publisher->setByteRate(rate_mb * 1024 * 1024);
+    } else {
+        double fps = args.optionDouble("fps", 10.0);
+        if (fps <= 0.0) {
+            imaging::Logger::error("Frame rate must be positive");
+            return 1;
+        }
+        g_publisher->setFrameRate(fps);
+    }
+    
+    // Credit-based flow control: --credit-endpoint=EP with --drop-policy,
+    // --credit-queue and --drop-nth for frames that find no credit
+    if (args.hasOption("credit-endpoint")) {
+        imaging::DropPolicy policy;
+        std::string policy_name = args.option("drop-policy", "oldest");
+        if (!imaging::parseDropPolicy(policy_name, policy)) {
+            imaging::Logger::error("Unknown drop policy: " + policy_name);
+            return 1;
+        }
+        int64_t queue_depth = args.optionInt("credit-queue", 4);
+        int64_t nth = args.optionInt("drop-nth", 2);
+        if (queue_depth < 1 || nth < 1) {
+            imaging::Logger::error("Credit queue depth and drop interval must be at least 1");
+            return 1;
+        }
+        g_publisher->setCreditEndpoint(args.option("credit-endpoint", ""));
+        g_publisher->setDropPolicy(policy, static_cast<size_t>(queue_depth), static_cast<size_t>(nth));
+    }
     
     if (!g_publisher->initialize()) {
         imaging::Logger::error("Failed to initialize publisher");
         return 1;
     }
     
-    // Load images
-    if (!g_publisher->loadImagesFromDirectory(image_directory)) {
-        imaging::Logger::error("Failed to load images from directory");
+    // Load images: synthetic ones, a manifest, a watched directory, a
+    // streamed listing or the indexed directory
+    g_publisher->setRecursive(args.hasOption("recursive"));
+    bool loaded = true;
+    if (args.hasOption("synthetic")) {
+        imaging::SyntheticImageOptions synthetic;
+        if (!parseSyntheticOptions(args, synthetic)) {
+            return 1;
+        }
+        g_publisher->useSyntheticImages(synthetic);
+    } else if (args.hasOption("watch")) {
+        loaded = g_publisher->watchDirectory(image_directory);
+    } else if (args.hasOption("manifest")) {
+        loaded = g_publisher->loadImagesFromManifest(args.option("manifest", ""));
+    } else if (args.hasOption("stream")) {
+        loaded = g_publisher->streamImagesFromDirectory(image_directory);
+    } else {
+        loaded = g_publisher->loadImagesFromDirectory(image_directory);
+    }
+    if (!loaded) {
+        imaging::Logger::error("Failed to load images");
         return 1;
     }
     
     // Start publishing
     g_publisher->publishImages();
+    logSignal();
     
     imaging::Logger::info("=== Image Generator Stopped ===");
     return 0;
@@ -0,0 +1,235 @@
+/*
+ * Synthetic Image Source Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "synthetic_source.h"
+#include "logger.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdio>
+
+namespace imaging {
+
+namespace {
+
+const char* fileExtension(SyntheticEncoding encoding) {
+    switch (encoding) {
+        case SyntheticEncoding::RAW:
+            return ".bmp";
+        case SyntheticEncoding::PNG:
+            return ".png";
+        case SyntheticEncoding::JPEG:
+            return ".jpg";
+    }
+    return ".png";
+}
+
+cv::Scalar randomColor(cv::RNG& rng) {
+    return cv::Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+}
+
+} // namespace
+
+std::string syntheticEncodingName(SyntheticEncoding encoding) {
+    switch (encoding) {
+        case SyntheticEncoding::RAW:
+            return "raw";
+        case SyntheticEncoding::PNG:
+            return "png";
+        case SyntheticEncoding::JPEG:
+            return "jpeg";
+    }
+    return "unknown";
+}
+
+bool parseSyntheticEncoding(const std::string& name, SyntheticEncoding& encoding) {
+    if (name == "raw") {
+        encoding = SyntheticEncoding::RAW;
+    } else if (name == "png") {
+        encoding = SyntheticEncoding::PNG;
+    } else if (name == "jpeg" || name == "jpg") {
+        encoding = SyntheticEncoding::JPEG;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SyntheticImageSource::SyntheticImageSource(const SyntheticImageOptions& options)
+    : options_(options), rendered_(options.cache_bytes), next_render_(0), next_consume_(0),
+      stopping_(false), returned_in_pass_(0) {
+    options_.frame_count = std::max<size_t>(options_.frame_count, 1);
+    options_.queue_depth = std::max<size_t>(options_.queue_depth, 1);
+    slots_.resize(options_.queue_depth);
+    
+    unsigned threads = options_.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, options_.queue_depth));
+    for (unsigned i = 0; i < threads; ++i) {
+        threads_.emplace_back(&SyntheticImageSource::worker, this);
+    }
+}
+
+SyntheticImageSource::~SyntheticImageSource() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    space_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+bool SyntheticImageSource::renderFrame(const SyntheticImageOptions& options, size_t index,
+                                       std::vector<uint8_t>& encoded) {
+    try {
+        cv::RNG rng(options.seed * 0x9E3779B97F4A7C15ULL + index + 1);
+        int type = options.channels == 1 ? CV_8UC1 : CV_8UC3;
+        int width = static_cast<int>(options.width);
+        int height = static_cast<int>(options.height);
+        
+        // Smooth gradient with mild sensor-like noise; on its own it yields
+        // few keypoints
+        cv::Mat image(height, width, type);
+        cv::Mat ramp(1, width, CV_8UC1);
+        for (int x = 0; x < width; ++x) {
+            ramp.at<uint8_t>(0, x) = static_cast<uint8_t>(32 + 96 * x / std::max(width - 1, 1));
+        }
+        cv::Mat row = ramp;
+        if (options.channels != 1) {
+            cv::cvtColor(ramp, row, cv::COLOR_GRAY2BGR);
+        }
+        cv::repeat(row, height, 1, image);
+        cv::Mat noise(height, width, CV_16SC(image.channels()));
+        cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(4));
+        cv::add(image, noise, image, cv::noArray(), type);
+        
+        // Shapes add corners and blobs, so their number controls the
+        // keypoint count
+        double area = static_cast<double>(width) * height;
+        size_t shapes = static_cast<size_t>(options.texture_density * area / 10000.0);
+        int max_size = std::max(4, std::min(width, height) / 12);
+        for (size_t i = 0; i < shapes; ++i) {
+            cv::Point center(rng.uniform(0, width), rng.uniform(0, height));
+            int size = rng.uniform(3, max_size);
+            cv::Scalar color = randomColor(rng);
+            switch (rng.uniform(0, 4)) {
+                case 0:
+                    cv::circle(image, center, size, color, cv::FILLED);
+                    break;
+                case 1:
+                    cv::rectangle(image, center, center + cv::Point(size, size * 2 / 3), color, cv::FILLED);
+                    break;
+                case 2:
+                    cv::ellipse(image, center, cv::Size(size, size / 2 + 1), rng.uniform(0, 180),
+                                0, 360, color, cv::FILLED);
+                    break;
+                default:
+                    cv::line(image, center, center + cv::Point(rng.uniform(-size, size), rng.uniform(-size, size)),
+                             color, rng.uniform(1, 4));
+                    break;
+            }
+        }
+        
+        std::vector<int> params;
+        if (options.encoding == SyntheticEncoding::JPEG) {
+            params = {cv::IMWRITE_JPEG_QUALITY, options.jpeg_quality};
+        }
+        return cv::imencode(fileExtension(options.encoding), image, encoded, params);
+    } catch (const cv::Exception& e) {
+        Logger::error("Failed to render synthetic frame: " + std::string(e.what()));
+        return false;
+    }
+}
+
+void SyntheticImageSource::worker() {
+    while (true) {
+        uint64_t sequence;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_.wait(lock, [this]() {
+                return stopping_ || next_render_ < next_consume_ + options_.queue_depth;
+            });
+            if (stopping_) {
+                return;
+            }
+            sequence = next_render_++;
+        }
+        
+        // Frames are deterministic, so a kept one is identical to a new render
+        size_t index = static_cast<size_t>(sequence % options_.frame_count);
+        std::string key = std::to_string(index);
+        std::vector<uint8_t> encoded;
+        SharedBuffer image;
+        if (!rendered_.find(key, image) && renderFrame(options_, index, encoded)) {
+            image = SharedBuffer(std::move(encoded));
+            rendered_.insert(key, image);
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Slot& slot = slots_[sequence % options_.queue_depth];
+            slot.image = std::move(image);
+            slot.ready = true;
+        }
+        ready_.notify_all();
+    }
+}
+
+ImageSource::Result SyntheticImageSource::next(ImageIndexEntry& entry,
+                                               std::chrono::milliseconds timeout) {
+    if (returned_in_pass_ == options_.frame_count) {
+        return Result::END_OF_PASS;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    Slot& slot = slots_[next_consume_ % options_.queue_depth];
+    if (!ready_.wait_for(lock, timeout, [&slot]() { return slot.ready; })) {
+        return Result::PENDING;
+    }
+    taken_ = std::move(slot.image);
+    slot = Slot();
+    next_consume_++;
+    lock.unlock();
+    space_.notify_all();
+    
+    char name[64];
+    std::snprintf(name, sizeof(name), "synthetic_%06zu%s", returned_in_pass_,
+                  fileExtension(options_.encoding));
+    entry = ImageIndexEntry();
+    entry.path = name;
+    entry.size = taken_.size();
+    entry.width = options_.width;
+    entry.height = options_.height;
+    entry.channels = options_.channels;
+    returned_in_pass_++;
+    return Result::IMAGE;
+}
+
+bool SyntheticImageSource::rewind() {
+    returned_in_pass_ = 0;
+    return true;
+}
+
+std::string SyntheticImageSource::describe() const {
+    char texture[32];
+    std::snprintf(texture, sizeof(texture), "%g", options_.texture_density);
+    return std::to_string(options_.frame_count) + " synthetic " + std::to_string(options_.width) + "x" +
+           std::to_string(options_.height) + " " + syntheticEncodingName(options_.encoding) +
+           " images (texture " + texture + ", " + std::to_string(threads_.size()) +
+           " generator threads)";
+}
+
+bool SyntheticImageSource::takeImage(SharedBuffer& image) {
+    image = std::move(taken_);
+    taken_ = SharedBuffer();
+    return image.size() > 0;
+}
+
+} // namespace imaging
@@ -0,0 +1,265 @@
+/*
+ * Pipeline Tap Application
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ *
+ * Records every message published on an endpoint and replays recordings, so
+ * the feature extractor and data logger can be benchmarked on identical input
+ * without the image generator's disk and decode costs.
+ */
+
+#include "tap_recording.h"
+#include "logger.h"
+#include "command_line.h"
+#include "shm_transport.h"
+#include "zmq_helpers.h"
+#include <zmq.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static std::atomic<bool> g_running(true);
+static std::atomic<int> g_signal(0);
+
+// Only async-signal-safe work here: Logger takes a lock the interrupted
+// thread may hold, so the signal is logged once the main loop has stopped
+void signalHandler(int signum) {
+    g_signal = signum;
+    g_running = false;
+}
+
+static void logSignal() {
+    if (g_signal != 0) {
+        imaging::Logger::info("Interrupt signal (" + std::to_string(g_signal.load()) +
+                              ") received, shutting down");
+    }
+}
+
+static void printUsage() {
+    imaging::Logger::info("Usage: pipeline_tap record ENDPOINT FILE [--max-messages=N]");
+    imaging::Logger::info("       pipeline_tap replay FILE ENDPOINT [--max-rate] [--speed=X] [--loop]");
+}
+
+static uint64_t nowNanoseconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+static int record(void* context, const std::string& endpoint, const std::string& path,
+                  uint64_t max_messages) {
+    imaging::TapWriter writer;
+    if (!writer.open(path)) {
+        return 1;
+    }
+    uint64_t existing = writer.recordCount();
+    
+    void* subscriber = zmq_socket(context, ZMQ_SUB);
+    zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, "", 0);
+    int timeout = 1000;
+    zmq_setsockopt(subscriber, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    // Do not drop anything ourselves while the disk catches up
+    int rcvhwm = 0;
+    zmq_setsockopt(subscriber, ZMQ_RCVHWM, &rcvhwm, sizeof(rcvhwm));
+    
+    if (zmq_connect(subscriber, endpoint.c_str()) != 0) {
+        imaging::Logger::error("Failed to connect to: " + endpoint);
+        zmq_close(subscriber);
+        return 1;
+    }
+    imaging::Logger::info("Recording " + endpoint + " to " + path +
+                          (existing ? " (appending after " + std::to_string(existing) + " records)" : ""));
+    
+    // Frames stay in their ZeroMQ messages until written
+    std::vector<std::unique_ptr<imaging::ZmqMessage>> parts;
+    std::vector<imaging::TapFrame> frames;
+    uint64_t recorded = 0;
+    
+    while (g_running && (max_messages == 0 || recorded < max_messages)) {
+        size_t count = 0;
+        uint64_t timestamp = 0;
+        bool more = true;
+        while (more) {
+            if (count == parts.size()) {
+                parts.emplace_back(new imaging::ZmqMessage());
+            }
+            if (parts[count]->receive(subscriber, 0) == -1) {
+                break;
+            }
+            if (count == 0) {
+                timestamp = nowNanoseconds();
+            }
+            more = imaging::hasMoreFrames(subscriber);
+            count++;
+        }
+        if (more) {
+            if (count > 0) {
+                imaging::Logger::warning("Message interrupted, discarding its frames");
+                imaging::discardRemainingFrames(subscriber);
+            } else if (errno != EAGAIN && errno != EINTR) {
+                imaging::Logger::error("Error receiving message: " + std::string(zmq_strerror(errno)));
+            }
+            continue;
+        }
+        
+        frames.clear();
+        for (size_t i = 0; i < count; ++i) {
+            frames.push_back({parts[i]->data(), parts[i]->size()});
+        }
+        if (!writer.append(timestamp, frames.data(), frames.size())) {
+            break;
+        }
+        
+        recorded++;
+        if (recorded % 100 == 0) {
+            imaging::Logger::info("Recorded " + std::to_string(recorded) + " messages, " +
+                                  std::to_string(writer.bytesWritten() / (1024 * 1024)) + " MB");
+        }
+    }
+    
+    imaging::Logger::info("Recorded " + std::to_string(recorded) + " messages (" +
+                          std::to_string(writer.bytesWritten()) + " bytes) to " + path);
+    zmq_close(subscriber);
+    return 0;
+}
+
+static int replay(void* context, const std::string& path, const std::string& endpoint,
+                  bool max_rate, double speed, bool loop) {
+    imaging::TapReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    
+    void* publisher = zmq_socket(context, ZMQ_PUB);
+    int sndhwm = 100;
+    zmq_setsockopt(publisher, ZMQ_SNDHWM, &sndhwm, sizeof(sndhwm));
+    int linger = 1000;
+    zmq_setsockopt(publisher, ZMQ_LINGER, &linger, sizeof(linger));
+    
+    // As fast as possible means as fast as subscribers take it, not dropping
+    int send_flags = ZMQ_DONTWAIT;
+    if (max_rate) {
+        int nodrop = 1;
+        zmq_setsockopt(publisher, ZMQ_XPUB_NODROP, &nodrop, sizeof(nodrop));
+        send_flags = 0;
+    }
+    
+    if (zmq_bind(publisher, endpoint.c_str()) != 0) {
+        imaging::Logger::error("Failed to bind to: " + endpoint);
+        zmq_close(publisher);
+        return 1;
+    }
+    imaging::Logger::info("Replaying " + path + " on " + endpoint +
+                          (max_rate ? " as fast as possible" : " at recorded timing"));
+    
+    // Give time for subscribers to connect
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    auto started = std::chrono::steady_clock::now();
+    do {
+        // Each pass keeps the recorded gaps between messages, measured from
+        // the first record
+        auto pass_start = std::chrono::steady_clock::now();
+        uint64_t first_timestamp = 0;
+        bool first = true;
+        uint64_t pass_sent = 0;
+        
+        imaging::TapRecord record;
+        while (g_running && reader.next(record)) {
+            if (first) {
+                first_timestamp = record.timestamp;
+                first = false;
+            }
+            if (!max_rate && record.timestamp > first_timestamp) {
+                auto offset = std::chrono::nanoseconds(static_cast<int64_t>(
+                    static_cast<double>(record.timestamp - first_timestamp) / speed));
+                std::this_thread::sleep_until(pass_start + offset);
+            }
+            
+            // Frames are slices of the mapped recording, sent without copying
+            bool ok = true;
+            for (size_t i = 0; i < record.frames.size() && ok; ++i) {
+                int flags = send_flags | (i + 1 < record.frames.size() ? ZMQ_SNDMORE : 0);
+                ok = imaging::sendSharedBuffer(publisher, record.frames[i], flags) != -1;
+            }
+            if (ok) {
+                sent++;
+                pass_sent++;
+            } else {
+                dropped++;
+            }
+        }
+        
+        if (reader.truncated()) {
+            imaging::Logger::warning("Recording ends with an incomplete record");
+        }
+        reader.rewind();
+        
+        // Another pass would do the same, so --loop would spin on nothing
+        if (g_running && pass_sent == 0) {
+            imaging::Logger::error(first ? "Recording has no complete records: " + path :
+                                           "No message of the recording could be sent");
+            zmq_close(publisher);
+            return 1;
+        }
+    } while (loop && g_running);
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    imaging::Logger::info("Replayed " + std::to_string(sent) + " messages in " +
+                          std::to_string(seconds) + " s (" + std::to_string(dropped) + " dropped)");
+    zmq_close(publisher);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+    
+    imaging::CommandLine args(argc, argv);
+    std::string mode = args.positional(0, "");
+    if (mode != "record" && mode != "replay") {
+        printUsage();
+        return 1;
+    }
+    
+    // Shared memory endpoints carry descriptors of ring records that are
+    // gone by the time a recording is replayed
+    std::string endpoint = args.positional(mode == "record" ? 1 : 2, "");
+    std::string path = args.positional(mode == "record" ? 2 : 1, "");
+    if (endpoint.empty() || path.empty()) {
+        printUsage();
+        return 1;
+    }
+    if (imaging::isShmEndpoint(endpoint)) {
+        imaging::Logger::error("Shared memory endpoints cannot be tapped: " + endpoint);
+        return 1;
+    }
+    
+    double speed = args.optionDouble("speed", 1.0);
+    int64_t max_messages = args.optionInt("max-messages", 0);
+    if (speed <= 0.0 || max_messages < 0) {
+        imaging::Logger::error("Speed must be positive and the message limit not negative");
+        return 1;
+    }
+    
+    void* context = zmq_ctx_new();
+    if (!context) {
+        imaging::Logger::error("Failed to create ZeroMQ context");
+        return 1;
+    }
+    
+    int result = mode == "record" ?
+                 record(context, endpoint, path, static_cast<uint64_t>(max_messages)) :
+                 replay(context, path, endpoint, args.hasOption("max-rate"), speed, args.hasOption("loop"));
+    logSignal();
+    
+    zmq_ctx_destroy(context);
+    return result;
+}
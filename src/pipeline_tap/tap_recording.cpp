@@ -0,0 +1,233 @@
+/*
+ * Tap Recording Implementation
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "tap_recording.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace imaging {
+
+namespace {
+
+// Written in native byte order, like the image index
+constexpr uint64_t kTapMagic = 0x3130504154474d49ULL;  // "IMGTAP01"
+constexpr uint32_t kTapVersion = 1;
+constexpr size_t kAlignment = 8;
+
+struct FileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct RecordHeader {
+    uint64_t timestamp;
+    uint32_t frame_count;
+    uint32_t reserved;
+};
+
+const uint8_t kPadding[kAlignment] = {};
+
+size_t paddingFor(size_t size) {
+    return (kAlignment - size % kAlignment) % kAlignment;
+}
+
+// writev() everything, resuming after partial writes
+bool writeAll(int fd, std::vector<iovec>& iov) {
+    size_t first = 0;
+    while (first < iov.size()) {
+        int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        ssize_t written = writev(fd, iov.data() + first, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        
+        size_t remaining = static_cast<size_t>(written);
+        while (first < iov.size() && remaining >= iov[first].iov_len) {
+            remaining -= iov[first].iov_len;
+            first++;
+        }
+        if (remaining > 0) {
+            iov[first].iov_base = static_cast<uint8_t*>(iov[first].iov_base) + remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TapWriter::TapWriter() : fd_(-1), records_(0), bytes_(0) {
+}
+
+TapWriter::~TapWriter() {
+    close();
+}
+
+bool TapWriter::open(const std::string& path) {
+    close();
+    
+    // An existing recording is validated, and a record cut short by a crash
+    // is cut off so new records are not hidden behind it
+    size_t valid_end = 0;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && info.st_size > 0) {
+        TapReader reader;
+        if (!reader.open(path)) {
+            Logger::error("Not a tap recording, refusing to append: " + path);
+            return false;
+        }
+        TapRecord record;
+        while (reader.next(record)) {
+            records_++;
+        }
+        valid_end = reader.offset();
+        if (reader.truncated()) {
+            Logger::warning("Dropping incomplete last record of " + path);
+        }
+    }
+    
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        Logger::error("Cannot open recording " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    if (valid_end > 0) {
+        if (ftruncate(fd_, static_cast<off_t>(valid_end)) != 0) {
+            Logger::error("Cannot truncate recording " + path + ": " + std::strerror(errno));
+            close();
+            return false;
+        }
+        return true;
+    }
+    
+    FileHeader header = {kTapMagic, kTapVersion, 0};
+    std::vector<iovec> iov = {{&header, sizeof(header)}};
+    if (!writeAll(fd_, iov)) {
+        Logger::error("Cannot write recording " + path + ": " + std::strerror(errno));
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TapWriter::close() {
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool TapWriter::append(uint64_t timestamp, const TapFrame* frames, size_t count) {
+    if (fd_ == -1 || count > UINT32_MAX) {
+        return false;
+    }
+    
+    // Frame bytes go to the kernel straight from the caller's buffers
+    RecordHeader header = {timestamp, static_cast<uint32_t>(count), 0};
+    std::vector<uint64_t> sizes(count);
+    std::vector<iovec> iov;
+    iov.reserve(1 + 3 * count);
+    iov.push_back({&header, sizeof(header)});
+    size_t total = sizeof(header);
+    for (size_t i = 0; i < count; ++i) {
+        sizes[i] = frames[i].size;
+        iov.push_back({&sizes[i], sizeof(uint64_t)});
+        if (frames[i].size > 0) {
+            iov.push_back({const_cast<uint8_t*>(frames[i].data), frames[i].size});
+        }
+        size_t padding = paddingFor(frames[i].size);
+        if (padding > 0) {
+            iov.push_back({const_cast<uint8_t*>(kPadding), padding});
+        }
+        total += sizeof(uint64_t) + frames[i].size + padding;
+    }
+    
+    if (!writeAll(fd_, iov)) {
+        Logger::error("Failed to write recording: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    records_++;
+    bytes_ += total;
+    return true;
+}
+
+TapReader::TapReader() : offset_(0), truncated_(false) {
+}
+
+bool TapReader::open(const std::string& path) {
+    mapping_ = SharedBuffer();
+    offset_ = 0;
+    truncated_ = false;
+    
+    FileHeader header;
+    if (!mapFile(path, mapping_) || mapping_.size() < sizeof(header)) {
+        Logger::error("Cannot read recording: " + path);
+        return false;
+    }
+    std::memcpy(&header, mapping_.data(), sizeof(header));
+    if (header.magic != kTapMagic || header.version != kTapVersion) {
+        Logger::error("Not a tap recording: " + path);
+        mapping_ = SharedBuffer();
+        return false;
+    }
+    
+    offset_ = sizeof(header);
+    return true;
+}
+
+bool TapReader::next(TapRecord& record) {
+    size_t size = mapping_.size();
+    RecordHeader header;
+    if (truncated_ || size - offset_ < sizeof(header)) {
+        truncated_ = truncated_ || offset_ < size;
+        return false;
+    }
+    std::memcpy(&header, mapping_.data() + offset_, sizeof(header));
+    
+    // Only advance once the whole record is known to be present
+    size_t position = offset_ + sizeof(header);
+    record.timestamp = header.timestamp;
+    record.frames.clear();
+    for (uint32_t i = 0; i < header.frame_count; ++i) {
+        uint64_t frame_size;
+        if (size - position < sizeof(frame_size)) {
+            truncated_ = true;
+            return false;
+        }
+        std::memcpy(&frame_size, mapping_.data() + position, sizeof(frame_size));
+        position += sizeof(frame_size);
+        
+        size_t padding = paddingFor(static_cast<size_t>(frame_size % kAlignment));
+        if (frame_size > size - position || padding > size - position - frame_size) {
+            truncated_ = true;
+            return false;
+        }
+        record.frames.push_back(mapping_.slice(position, static_cast<size_t>(frame_size)));
+        position += static_cast<size_t>(frame_size) + padding;
+    }
+    
+    offset_ = position;
+    return true;
+}
+
+void TapReader::rewind() {
+    offset_ = mapping_.size() > 0 ? sizeof(FileHeader) : 0;
+    truncated_ = false;
+}
+
+} // namespace imaging
@@ -0,0 +1,234 @@
+/**
+ * Unit Tests for the MPMC Queue, Buffer Pool and Padded Counter
+ *
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "mpmc_queue.h"
+#include "buffer_pool.h"
+#include "padded_counter.h"
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace imaging;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+bool test_mpmc_queue() {
+    std::cout << "Testing: MPMC queue order, bounds and concurrent use..." << std::endl;
+    
+    MpmcQueue<std::unique_ptr<int>> queue(3);
+    TEST_ASSERT(queue.capacity() == 4, "Capacity should round up to a power of two");
+    TEST_ASSERT(MpmcQueue<int>(1).capacity() == 2, "Capacity should be at least 2");
+    
+    std::unique_ptr<int> item;
+    for (int i = 0; i < 4; ++i) {
+        item.reset(new int(i));
+        TEST_ASSERT(queue.tryPush(item), "Push should succeed while there is room");
+        TEST_ASSERT(!item, "Pushed item should be swapped out");
+    }
+    item.reset(new int(99));
+    TEST_ASSERT(!queue.tryPush(item) && *item == 99, "Full queue should refuse and keep the item");
+    TEST_ASSERT(queue.size() == 4, "Size mismatch");
+    
+    // Wraps around the ring in FIFO order
+    std::unique_ptr<int> popped;
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT(queue.tryPop(popped) && *popped == i, "FIFO order expected");
+        popped.reset(new int(i + 4));
+        TEST_ASSERT(queue.tryPush(popped), "Push into freed cell should succeed");
+    }
+    for (int i = 10; i < 14; ++i) {
+        TEST_ASSERT(queue.tryPop(popped) && *popped == i, "FIFO order expected");
+    }
+    TEST_ASSERT(!queue.tryPop(popped) && queue.size() == 0, "Queue should now be empty");
+    
+    // Four producers and four consumers: every item arrives exactly once
+    const int producers = 4;
+    const int per_producer = 50000;
+    MpmcQueue<int> numbers(64);
+    std::vector<std::vector<int>> seen(producers, std::vector<int>(per_producer, 0));
+    PaddedCounter consumed;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&numbers, p]() {
+            for (int i = 0; i < per_producer; ++i) {
+                int value = p * per_producer + i;
+                while (!numbers.tryPush(value)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<std::vector<int>> received(4);
+    for (int c = 0; c < 4; ++c) {
+        threads.emplace_back([&, c]() {
+            int value = -1;
+            while (consumed.get() < static_cast<uint64_t>(producers * per_producer)) {
+                if (numbers.tryPop(value)) {
+                    received[c].push_back(value);
+                    consumed.add();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    // Each consumer sees a producer's items in the order they were pushed
+    bool per_producer_order = true;
+    for (const auto& values : received) {
+        std::vector<int> last(producers, -1);
+        for (int value : values) {
+            int producer = value / per_producer;
+            per_producer_order = per_producer_order && value > last[producer];
+            last[producer] = value;
+            seen[producer][value % per_producer]++;
+        }
+    }
+    bool exactly_once = true;
+    for (const auto& counts : seen) {
+        for (int count : counts) {
+            exactly_once = exactly_once && count == 1;
+        }
+    }
+    TEST_ASSERT(exactly_once, "Every item should be received exactly once");
+    TEST_ASSERT(per_producer_order, "Items from one producer should not be reordered");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_buffer_pool() {
+    std::cout << "Testing: Buffer pool reuse, exhaustion and lifetime..." << std::endl;
+    
+    SharedBuffer survivor;
+    {
+        BufferPool pool(1024, 2);
+        TEST_ASSERT(pool.bufferSize() == 1024 && pool.count() == 2, "Pool shape mismatch");
+        TEST_ASSERT(pool.allocated() == 0, "Buffers should be allocated lazily");
+        
+        std::shared_ptr<uint8_t> first = pool.acquire();
+        std::shared_ptr<uint8_t> second = pool.acquire();
+        TEST_ASSERT(first && second && first != second, "Two distinct buffers expected");
+        TEST_ASSERT(!pool.acquire(), "Exhausted pool should return null");
+        TEST_ASSERT(pool.allocated() == 2, "Allocation count mismatch");
+        
+        // A released buffer is handed out again rather than reallocated
+        uint8_t* recycled = first.get();
+        first.reset();
+        std::shared_ptr<uint8_t> third = pool.acquire();
+        TEST_ASSERT(third.get() == recycled && pool.allocated() == 2, "Buffer should be recycled");
+        third.reset();
+        
+        // Copies go into pooled buffers while they fit and one is free
+        std::vector<uint8_t> bytes(100, 7);
+        SharedBuffer copy = pool.copy(bytes.data(), bytes.size());
+        TEST_ASSERT(copy.size() == 100 && copy.data() == recycled && copy.data()[99] == 7,
+                    "Copy should use the free buffer");
+        SharedBuffer heap = pool.copy(bytes.data(), bytes.size());
+        TEST_ASSERT(heap.size() == 100 && heap.data()[0] == 7 && pool.misses() == 1,
+                    "Copy with no free buffer should fall back to the heap");
+        std::vector<uint8_t> large(2048, 1);
+        SharedBuffer oversized = pool.copy(large.data(), large.size());
+        TEST_ASSERT(oversized.size() == 2048 && pool.misses() == 2,
+                    "Copy larger than a buffer should fall back to the heap");
+        
+        survivor = copy;
+    }
+    
+    // Buffers stay valid after the pool is gone
+    TEST_ASSERT(survivor.size() == 100 && survivor.data()[0] == 7, "Buffer should outlive the pool");
+    survivor = SharedBuffer();
+    
+    // Buffers released from other threads all come back to the pool
+    BufferPool pool(64, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool]() {
+            for (int i = 0; i < 10000; ++i) {
+                std::shared_ptr<uint8_t> buffer = pool.acquire();
+                if (buffer) {
+                    buffer.get()[0] = static_cast<uint8_t>(i);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::vector<std::shared_ptr<uint8_t>> held;
+    for (size_t i = 0; i < pool.count(); ++i) {
+        held.push_back(pool.acquire());
+        TEST_ASSERT(held.back() != nullptr, "Every buffer should be available again");
+    }
+    TEST_ASSERT(!pool.acquire() && pool.allocated() == pool.count(), "No buffer should be lost");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_padded_counter() {
+    std::cout << "Testing: Padded counters..." << std::endl;
+    
+    PaddedCounter counters[2];
+    TEST_ASSERT(reinterpret_cast<uintptr_t>(&counters[0]) % kCacheLineSize == 0 &&
+                reinterpret_cast<uint8_t*>(&counters[1]) -
+                reinterpret_cast<uint8_t*>(&counters[0]) == static_cast<ptrdiff_t>(kCacheLineSize),
+                "Counters should sit on separate cache lines");
+    
+    TEST_ASSERT(counters[0].add(5) == 0 && counters[0].get() == 5, "Add should return the old value");
+    TEST_ASSERT(counters[0].exchange(0) == 5 && counters[0].get() == 0, "Exchange should restart");
+    
+    // Concurrent adds are not lost; incrementBelow stops exactly at the limit
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&counters]() {
+            for (int i = 0; i < 100000; ++i) {
+                counters[0].add();
+                counters[1].incrementBelow(1000);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    TEST_ASSERT(counters[0].get() == 400000, "Concurrent adds should all count");
+    TEST_ASSERT(counters[1].get() == 1000, "Increments should stop at the limit");
+    TEST_ASSERT(!counters[1].incrementBelow(1000), "Increment at the limit should fail");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Concurrency Primitive Unit Tests" << std::endl;
+    std::cout << "Author: Haobo (Brian) Liu" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    int passed = 0;
+    int total = 0;
+    
+    total++; if (test_mpmc_queue()) passed++;
+    total++; if (test_buffer_pool()) passed++;
+    total++; if (test_padded_counter()) passed++;
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    return (passed == total) ? 0 : 1;
+}
@@ -7,6 +7,8 @@
  */
 
 #include "database_manager.h"
+#include "image_joiner.h"
+#include "content_hash.h"
 #include <cassert>
 #include <iostream>
 #include <filesystem>
@@ -134,6 +136,156 @@ bool test_multiple_inserts() {
     return true;
 }
 
+bool test_store_from_view() {
+    std::cout << "Testing: Store from message view..." << std::endl;
+    
+    const std::string test_db = "test_view.db";
+    
+    if (fs::exists(test_db)) {
+        fs::remove(test_db);
+    }
+    
+    DatabaseManager db(test_db);
+    TEST_ASSERT(db.initialize(), "Database initialization failed");
+    
+    ImageMetadata metadata;
+    metadata.timestamp = 987654;
+    metadata.width = 320;
+    metadata.height = 240;
+    metadata.channels = 1;
+    metadata.data_size = 32;
+    metadata.filename = "view_image.png";
+    
+    std::vector<uint8_t> image_data(32, 9);
+    std::vector<KeyPoint> keypoints(4);
+    std::vector<float> descriptors(4 * 128, 0.25f);
+    
+    std::vector<uint8_t> message = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors);
+    
+    ProcessedDataView view;
+    TEST_ASSERT(MessageProtocol::parseProcessedData(message.data(), message.size(), view),
+                "View parsing failed");
+    TEST_ASSERT(db.storeProcessedData(view), "Storing from view should succeed");
+    
+    TEST_ASSERT(db.getTotalImagesStored() == 1, "Should have 1 image stored");
+    TEST_ASSERT(db.getTotalKeypointsStored() == 4, "Should have 4 keypoints stored");
+    
+    // Cleanup
+    fs::remove(test_db);
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_quantized_descriptor_storage() {
+    std::cout << "Testing: Quantized descriptor storage..." << std::endl;
+    
+    const std::string test_db = "test_quantized.db";
+    
+    if (fs::exists(test_db)) {
+        fs::remove(test_db);
+    }
+    
+    DatabaseManager db(test_db);
+    TEST_ASSERT(db.initialize(), "Database initialization failed");
+    
+    ImageMetadata metadata;
+    metadata.filename = "quantized.png";
+    metadata.data_size = 8;
+    std::vector<uint8_t> image_data(8, 1);
+    std::vector<KeyPoint> keypoints(2);
+    std::vector<float> descriptors(2 * 128, 42.0f);
+    
+    ProcessedDataOptions options;
+    options.descriptor_encoding = DescriptorEncoding::UINT8;
+    std::vector<uint8_t> message = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors, options);
+    
+    ProcessedDataView view;
+    TEST_ASSERT(MessageProtocol::parseProcessedData(message.data(), message.size(), view),
+                "View parsing failed");
+    TEST_ASSERT(db.storeProcessedData(view), "Storing quantized descriptors should succeed");
+    
+    // Inspect the stored blob directly
+    sqlite3* raw = nullptr;
+    TEST_ASSERT(sqlite3_open(test_db.c_str(), &raw) == SQLITE_OK, "Failed to reopen database");
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(raw, "SELECT encoding, length(descriptor_data) FROM descriptors;",
+                       -1, &stmt, nullptr);
+    bool has_row = sqlite3_step(stmt) == SQLITE_ROW;
+    int encoding = has_row ? sqlite3_column_int(stmt, 0) : -1;
+    int blob_size = has_row ? sqlite3_column_int(stmt, 1) : -1;
+    sqlite3_finalize(stmt);
+    sqlite3_close(raw);
+    
+    TEST_ASSERT(encoding == static_cast<int>(DescriptorEncoding::UINT8), "Encoding column mismatch");
+    TEST_ASSERT(blob_size == 2 * 128, "uint8 blob should use one byte per element");
+    
+    // Cleanup
+    fs::remove(test_db);
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_image_join_by_reference() {
+    std::cout << "Testing: Joining by-reference data with received images..." << std::endl;
+    
+    const std::string test_db = "test_join.db";
+    
+    if (fs::exists(test_db)) {
+        fs::remove(test_db);
+    }
+    
+    DatabaseManager db(test_db);
+    TEST_ASSERT(db.initialize(), "Database initialization failed");
+    
+    ImageMetadata metadata;
+    metadata.filename = "joined.png";
+    std::vector<uint8_t> image_data(64, 3);
+    metadata.data_size = image_data.size();
+    std::vector<KeyPoint> keypoints(2);
+    std::vector<float> descriptors(2 * 128, 1.0f);
+    
+    ProcessedDataOptions options;
+    options.image_by_reference = true;
+    std::vector<uint8_t> message = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors, options);
+    
+    // The image arrives separately from the generator
+    ImageJoiner joiner(200);
+    uint64_t hash = joiner.addImage(SharedBuffer(std::vector<uint8_t>(image_data)));
+    
+    ProcessedDataView view;
+    TEST_ASSERT(MessageProtocol::parseProcessedData(message.data(), message.size(), view),
+                "View parsing failed");
+    const SharedBuffer* image = joiner.find(view.image_hash);
+    TEST_ASSERT(view.image_hash == hash && image != nullptr, "Image should be found by hash");
+    
+    view.image_data = image->data();
+    view.image_size = image->size();
+    TEST_ASSERT(db.storeProcessedData(view), "Storing joined data should succeed");
+    TEST_ASSERT(db.getTotalImagesStored() == 1, "Should have 1 image stored");
+    
+    // Repeats refresh an entry; the byte budget evicts the oldest others
+    joiner.addImage(SharedBuffer(std::vector<uint8_t>(64, 4)));
+    joiner.addImage(SharedBuffer(std::vector<uint8_t>(image_data)));
+    joiner.addImage(SharedBuffer(std::vector<uint8_t>(64, 5)));
+    joiner.addImage(SharedBuffer(std::vector<uint8_t>(64, 6)));
+    TEST_ASSERT(joiner.imageCount() == 3 && joiner.bytes() <= 200, "Budget should be enforced");
+    TEST_ASSERT(joiner.find(hash) != nullptr, "Refreshed image should survive");
+    std::vector<uint8_t> evicted(64, 4);
+    TEST_ASSERT(joiner.find(contentHash(evicted.data(), evicted.size())) == nullptr,
+                "Oldest image should be evicted");
+    
+    // Cleanup
+    fs::remove(test_db);
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
 int main() {
     std::cout << "\n======================================" << std::endl;
     std::cout << "Database Manager Unit Tests" << std::endl;
@@ -146,6 +298,9 @@ int main() {
     total++; if (test_database_initialization()) passed++;
     total++; if (test_store_and_retrieve()) passed++;
     total++; if (test_multiple_inserts()) passed++;
+    total++; if (test_store_from_view()) passed++;
+    total++; if (test_quantized_descriptor_storage()) passed++;
+    total++; if (test_image_join_by_reference()) passed++;
     
     std::cout << "\n======================================" << std::endl;
     std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
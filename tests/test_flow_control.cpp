@@ -0,0 +1,183 @@
+/**
+ * Unit Tests for Credit-Based Flow Control
+ *
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "flow_control.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace imaging;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+std::vector<int> drain(DropQueue<int>& queue) {
+    std::vector<int> items;
+    while (!queue.empty()) {
+        items.push_back(queue.front());
+        queue.pop();
+    }
+    return items;
+}
+
+CreditGrant makeGrant(const std::string& stage, uint64_t consumed, uint32_t window) {
+    CreditGrant grant;
+    grant.stage = stage;
+    grant.consumed = consumed;
+    grant.window = window;
+    return grant;
+}
+
+} // namespace
+
+bool test_drop_policies() {
+    std::cout << "Testing: Drop policies of a full queue..." << std::endl;
+    
+    DropPolicy policy;
+    TEST_ASSERT(parseDropPolicy("every-nth", policy) && policy == DropPolicy::EVERY_NTH,
+                "Policy names should parse");
+    TEST_ASSERT(!parseDropPolicy("random", policy), "Unknown policies should be rejected");
+    TEST_ASSERT(dropPolicyName(DropPolicy::NEWEST) == "newest", "Policy name mismatch");
+    
+    // Oldest: the queue always holds the latest arrivals
+    DropQueue<int> oldest(3, DropPolicy::OLDEST);
+    for (int i = 1; i <= 6; ++i) {
+        TEST_ASSERT(oldest.push(int(i)) == (i <= 3), "Pushes beyond capacity should drop");
+    }
+    TEST_ASSERT((drain(oldest) == std::vector<int>{4, 5, 6}), "Oldest frames should be dropped");
+    TEST_ASSERT(oldest.dropped() == 3, "Drops should be counted");
+    
+    // Newest: arrivals are refused while the queue is full
+    DropQueue<int> newest(3, DropPolicy::NEWEST);
+    for (int i = 1; i <= 6; ++i) {
+        newest.push(int(i));
+    }
+    TEST_ASSERT((drain(newest) == std::vector<int>{1, 2, 3}), "Newest frames should be dropped");
+    
+    // Every third arrival into a full queue replaces the oldest frame
+    DropQueue<int> nth(2, DropPolicy::EVERY_NTH, 3);
+    for (int i = 1; i <= 8; ++i) {
+        nth.push(int(i));
+    }
+    TEST_ASSERT((drain(nth) == std::vector<int>{5, 8}), "One in three arrivals should be kept");
+    TEST_ASSERT(nth.dropped() == 6, "Refused and evicted frames should be counted");
+    
+    // Having room again restarts the count
+    nth.push(9);
+    nth.push(10);
+    nth.push(11);
+    nth.push(12);
+    TEST_ASSERT((drain(nth) == std::vector<int>{9, 10}), "Count should restart after draining");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_credit_window() {
+    std::cout << "Testing: Credit window accounting..." << std::endl;
+    
+    CreditGate gate;
+    auto now = CreditGate::Clock::now();
+    TEST_ASSERT(gate.available(now) == UINT64_MAX, "No stage means no limit");
+    
+    // Messages sent before a stage appears are not charged to it
+    gate.sent();
+    gate.sent();
+    gate.grant(makeGrant("logger", 0, 3), now);
+    TEST_ASSERT(gate.stageCount(now) == 1, "Stage should be registered");
+    TEST_ASSERT(gate.available(now) == 3, "Window should be available");
+    
+    for (int i = 0; i < 3; ++i) {
+        gate.sent();
+    }
+    TEST_ASSERT(gate.available(now) == 0, "Window should be used up");
+    
+    // Consuming returns credit; repeated grants are idempotent
+    gate.grant(makeGrant("logger", 2, 3), now);
+    gate.grant(makeGrant("logger", 2, 3), now);
+    TEST_ASSERT(gate.available(now) == 2, "Consumed messages should return credit");
+    
+    // Plain heartbeats carry no credit and change nothing
+    gate.grant(makeGrant("monitor", 0, 0), now);
+    TEST_ASSERT(gate.stageCount(now) == 1, "Window 0 should be ignored");
+    
+    // The slowest stage limits the sender
+    gate.grant(makeGrant("extractor", 0, 1), now);
+    TEST_ASSERT(gate.available(now) == 1, "Smallest credit should win");
+    gate.sent();
+    TEST_ASSERT(gate.available(now) == 0, "Either stage can block");
+    gate.grant(makeGrant("extractor", 1, 1), now);
+    TEST_ASSERT(gate.available(now) == 1, "Other stage still has credit");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_stale_and_lost_credit() {
+    std::cout << "Testing: Silent stages, restarts and lost messages..." << std::endl;
+    
+    CreditGate gate(std::chrono::milliseconds(100));
+    auto start = CreditGate::Clock::now();
+    gate.grant(makeGrant("extractor", 0, 2), start);
+    gate.sent();
+    gate.sent();
+    TEST_ASSERT(gate.available(start) == 0, "Window should be used up");
+    
+    // Still heartbeating without progress: the messages it waits for are
+    // taken as lost and its window is counted again
+    gate.grant(makeGrant("extractor", 0, 2), start + std::chrono::milliseconds(50));
+    TEST_ASSERT(gate.available(start + std::chrono::milliseconds(50)) == 0,
+                "Short stalls should keep waiting");
+    gate.grant(makeGrant("extractor", 0, 2), start + std::chrono::milliseconds(150));
+    TEST_ASSERT(gate.available(start + std::chrono::milliseconds(150)) == 2,
+                "Credit should be reset after a long stall");
+    
+    // A restarted stage counts from zero again
+    gate.sent();
+    gate.grant(makeGrant("extractor", 5, 2), start + std::chrono::milliseconds(160));
+    gate.grant(makeGrant("extractor", 0, 2), start + std::chrono::milliseconds(170));
+    TEST_ASSERT(gate.available(start + std::chrono::milliseconds(170)) == 2,
+                "Restart should start a new window");
+    
+    // A silent stage is forgotten and no longer limits the sender
+    gate.sent();
+    gate.sent();
+    TEST_ASSERT(gate.available(start + std::chrono::milliseconds(200)) == 0, "Window used up");
+    TEST_ASSERT(gate.available(start + std::chrono::milliseconds(300)) == UINT64_MAX,
+                "Silent stage should be dropped");
+    TEST_ASSERT(gate.stageCount(start + std::chrono::milliseconds(300)) == 0, "No stage left");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Flow Control Unit Tests" << std::endl;
+    std::cout << "Author: Haobo (Brian) Liu" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    int passed = 0;
+    int total = 0;
+    
+    total++; if (test_drop_policies()) passed++;
+    total++; if (test_credit_window()) passed++;
+    total++; if (test_stale_and_lost_credit()) passed++;
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    return (passed == total) ? 0 : 1;
+}
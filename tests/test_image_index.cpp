@@ -0,0 +1,584 @@
+/**
+ * Unit Tests for Image Loading in the Generator (index, sources, cache, prefetch)
+ *
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_index.h"
+#include "image_cache.h"
+#include "image_prefetcher.h"
+#include "image_source.h"
+#include "content_hash.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <vector>
+
+using namespace imaging;
+namespace fs = std::filesystem;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+const std::string kTestDirectory = "test_image_index_dir";
+
+// Minimal 24-bit BMP header followed by some pixel bytes
+std::vector<uint8_t> makeBmp(uint32_t width, uint32_t height, uint8_t fill) {
+    std::vector<uint8_t> bmp(54 + 16, fill);
+    auto put32 = [&bmp](size_t offset, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            bmp[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    };
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    put32(10, 54);
+    put32(14, 40);
+    put32(18, width);
+    put32(22, height);
+    bmp[26] = 1;
+    bmp[27] = 0;
+    bmp[28] = 24;
+    bmp[29] = 0;
+    put32(30, 0);
+    put32(46, 0);
+    return bmp;
+}
+
+void writeFile(const std::string& name, const std::vector<uint8_t>& data) {
+    std::ofstream file(fs::path(kTestDirectory) / name, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+// Produces numbered in-memory images, like the synthetic source
+class CountingSource : public ImageSource {
+public:
+    explicit CountingSource(size_t count) : count_(count), position_(0) {}
+    
+    Result next(ImageIndexEntry& entry, std::chrono::milliseconds) override {
+        if (position_ == count_) {
+            return Result::END_OF_PASS;
+        }
+        entry = ImageIndexEntry();
+        entry.path = "generated_" + std::to_string(position_);
+        image_ = SharedBuffer(std::vector<uint8_t>(16, static_cast<uint8_t>(position_)));
+        position_++;
+        return Result::IMAGE;
+    }
+    bool rewind() override {
+        position_ = 0;
+        return true;
+    }
+    std::string describe() const override { return "counting"; }
+    bool takeImage(SharedBuffer& image) override {
+        image = image_;
+        return true;
+    }
+    
+private:
+    size_t count_;
+    size_t position_;
+    SharedBuffer image_;
+};
+
+} // namespace
+
+bool test_build_and_reload() {
+    std::cout << "Testing: Building and reloading the index..." << std::endl;
+    
+    fs::remove_all(kTestDirectory);
+    fs::create_directory(kTestDirectory);
+    std::vector<uint8_t> first = makeBmp(640, 480, 1);
+    writeFile("b.bmp", makeBmp(32, 16, 2));
+    writeFile("a.bmp", first);
+    writeFile("notes.txt", {'x'});
+    
+    ImageIndex index(kTestDirectory);
+    TEST_ASSERT(!index.load(), "No index file should exist yet");
+    TEST_ASSERT(index.refresh(2), "Refresh should succeed");
+    TEST_ASSERT(index.entries().size() == 2, "Only image files should be indexed");
+    TEST_ASSERT(index.scannedCount() == 2 && index.reusedCount() == 0, "Everything is scanned");
+    
+    const ImageIndexEntry& entry = index.entries()[0];
+    TEST_ASSERT(fs::path(entry.path).filename() == "a.bmp", "Entries should be sorted by path");
+    TEST_ASSERT(entry.width == 640 && entry.height == 480 && entry.channels == 3, "Dimensions");
+    TEST_ASSERT(entry.size == first.size(), "Size");
+    TEST_ASSERT(entry.content_hash == contentHash(first.data(), first.size()), "Content hash");
+    TEST_ASSERT(index.save(), "Save should succeed");
+    
+    ImageIndex reloaded(kTestDirectory);
+    TEST_ASSERT(reloaded.load(), "Saved index should load");
+    TEST_ASSERT(reloaded.entries().size() == 2, "Reloaded entry count");
+    TEST_ASSERT(reloaded.entries()[0].path == entry.path &&
+                reloaded.entries()[0].mtime == entry.mtime &&
+                reloaded.entries()[0].content_hash == entry.content_hash,
+                "Reloaded entry should match");
+    
+    TEST_ASSERT(reloaded.refresh() && reloaded.scannedCount() == 0 && reloaded.reusedCount() == 2,
+                "Unchanged files should not be scanned again");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_incremental_refresh() {
+    std::cout << "Testing: Incremental refresh..." << std::endl;
+    
+    ImageIndex index(kTestDirectory);
+    TEST_ASSERT(index.load(), "Index from the previous test should load");
+    
+    // Change one file's size, add one and remove one
+    std::vector<uint8_t> changed = makeBmp(100, 50, 3);
+    changed.resize(changed.size() + 100, 3);
+    writeFile("a.bmp", changed);
+    writeFile("c.bmp", makeBmp(8, 8, 4));
+    fs::remove(fs::path(kTestDirectory) / "b.bmp");
+    
+    TEST_ASSERT(index.refresh(), "Refresh should succeed");
+    TEST_ASSERT(index.entries().size() == 2, "Removed file should be dropped");
+    TEST_ASSERT(index.scannedCount() == 2 && index.reusedCount() == 0,
+                "Changed and new files should be scanned");
+    TEST_ASSERT(index.entries()[0].width == 100 &&
+                index.entries()[0].content_hash == contentHash(changed.data(), changed.size()),
+                "Changed file should be re-probed");
+    TEST_ASSERT(fs::path(index.entries()[1].path).filename() == "c.bmp", "New file indexed");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_corrupt_index() {
+    std::cout << "Testing: Corrupt index files are ignored..." << std::endl;
+    
+    ImageIndex index(kTestDirectory);
+    TEST_ASSERT(index.refresh() && index.save(), "Index should be written");
+    
+    // Truncate the saved index in the middle of an entry
+    std::string path = index.indexPath();
+    fs::resize_file(path, fs::file_size(path) - 5);
+    
+    ImageIndex truncated(kTestDirectory);
+    TEST_ASSERT(!truncated.load(), "Truncated index should be rejected");
+    TEST_ASSERT(truncated.entries().empty(), "No partial entries");
+    TEST_ASSERT(truncated.refresh() && truncated.entries().size() == 2 &&
+                truncated.scannedCount() == 2, "Refresh should rebuild from scratch");
+    
+    fs::remove_all(kTestDirectory);
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_image_cache() {
+    std::cout << "Testing: Byte-budgeted image cache..." << std::endl;
+    
+    ImageCache cache(250);
+    SharedBuffer image;
+    TEST_ASSERT(!cache.find("a", image) && cache.misses() == 1, "Empty cache should miss");
+    
+    SharedBuffer a(std::vector<uint8_t>(100, 1));
+    cache.insert("a", a);
+    cache.insert("b", SharedBuffer(std::vector<uint8_t>(100, 2)));
+    TEST_ASSERT(cache.find("a", image) && image.data() == a.data(), "Hit should share the buffer");
+    
+    // "b" is now least recently used and makes room for "c"
+    cache.insert("c", SharedBuffer(std::vector<uint8_t>(100, 3)));
+    TEST_ASSERT(cache.imageCount() == 2 && cache.bytes() == 200, "Budget should be enforced");
+    TEST_ASSERT(!cache.find("b", image), "Least recently used image should be evicted");
+    TEST_ASSERT(cache.find("c", image) && cache.hits() == 2, "Newest image should be cached");
+    
+    // Images larger than the budget are not cached
+    TEST_ASSERT(!cache.fits(300), "Oversized image should not fit");
+    cache.insert("d", SharedBuffer(std::vector<uint8_t>(300, 4)));
+    TEST_ASSERT(!cache.find("d", image) && cache.imageCount() == 2, "Oversized image ignored");
+    
+    // Evicted buffers stay valid for holders such as queued ZeroMQ frames
+    cache.setMaxBytes(0);
+    TEST_ASSERT(cache.imageCount() == 0 && cache.bytes() == 0, "Disabling empties the cache");
+    TEST_ASSERT(a.size() == 100 && a.data()[99] == 1, "Shared buffer outlives eviction");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_prefetcher() {
+    std::cout << "Testing: Read-ahead prefetching in playback order..." << std::endl;
+    
+    fs::create_directory(kTestDirectory);
+    for (int i = 0; i < 5; ++i) {
+        writeFile("p" + std::to_string(i) + ".bmp", makeBmp(8, 8, static_cast<uint8_t>(i)));
+    }
+    ImageIndex index(kTestDirectory);
+    TEST_ASSERT(index.refresh() && index.entries().size() == 5, "Index should list the images");
+    
+    // Two passes over the list
+    ImageListSource list(index.entries());
+    ImageCache cache(1024 * 1024);
+    ImagePrefetcher prefetcher(list, cache, 3, SIZE_MAX);
+    prefetcher.start();
+    for (size_t i = 0; i < 10; ++i) {
+        PrefetchedImage image;
+        TEST_ASSERT(prefetcher.next(image, std::chrono::milliseconds(5000)), "Image should arrive");
+        TEST_ASSERT(image.position == i % 5 && image.entry.path == index.entries()[i % 5].path,
+                    "Images should come in playback order");
+        TEST_ASSERT(image.loaded && image.image.size() == 70 &&
+                    image.image.data()[69] == static_cast<uint8_t>(image.position),
+                    "Image contents should match the file");
+    }
+    TEST_ASSERT(cache.imageCount() == 5 && cache.hits() >= 4, "Second pass should hit the cache");
+    
+    prefetcher.stop();
+    PrefetchedImage image;
+    TEST_ASSERT(!prefetcher.next(image, std::chrono::milliseconds(10)), "Stopped prefetcher is empty");
+    
+    // Missing files are reported instead of stalling the stream
+    fs::remove(fs::path(kTestDirectory) / "p0.bmp");
+    ImageListSource again(index.entries());
+    ImageCache no_cache(0);
+    ImagePrefetcher missing(again, no_cache, 2, SIZE_MAX);
+    missing.start();
+    TEST_ASSERT(missing.next(image, std::chrono::milliseconds(5000)) && !image.loaded,
+                "Missing file should be reported as not loaded");
+    TEST_ASSERT(missing.next(image, std::chrono::milliseconds(5000)) && image.loaded &&
+                image.position == 1, "Next file should follow");
+    missing.stop();
+    
+    // A missing file after a mapped one carries no bytes, so the publisher
+    // streams it from disk (when chunking) instead of sending the previous
+    // frame's released mapping; one worker reuses its image for both
+    std::vector<ImageIndexEntry> mixed = {index.entries()[1], index.entries()[0],
+                                          index.entries()[2]};
+    ImageListSource mixed_list(mixed);
+    ImagePrefetcher single(mixed_list, no_cache, 1, 0);
+    single.start();
+    PrefetchedImage first;
+    TEST_ASSERT(single.next(first, std::chrono::milliseconds(5000)) && first.loaded &&
+                first.image.size() == 70, "Mapped file should load");
+    first = PrefetchedImage();
+    TEST_ASSERT(single.next(image, std::chrono::milliseconds(5000)) && !image.loaded &&
+                image.image.empty() && image.image.data() == nullptr,
+                "Missing file should come without image bytes");
+    TEST_ASSERT(single.next(image, std::chrono::milliseconds(5000)) && image.loaded &&
+                image.image.data()[69] == 2, "File after the missing one should load");
+    single.stop();
+    
+    // A source without images ends the stream instead of spinning
+    ImageListSource empty({});
+    ImagePrefetcher idle(empty, no_cache, 2, SIZE_MAX);
+    idle.start();
+    TEST_ASSERT(!idle.next(image, std::chrono::milliseconds(5000)) && idle.exhausted(),
+                "Empty source should be exhausted");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_prefetch_changed_files() {
+    std::cout << "Testing: Prefetching files that changed size since indexing..." << std::endl;
+    
+    fs::remove_all(kTestDirectory);
+    fs::create_directory(kTestDirectory);
+    writeFile("grown.bmp", makeBmp(8, 8, 1));
+    writeFile("shrunk.bmp", makeBmp(8, 8, 2));
+    ImageIndex index(kTestDirectory);
+    TEST_ASSERT(index.refresh() && index.entries().size() == 2, "Index should list the images");
+    
+    std::vector<uint8_t> grown = makeBmp(8, 8, 1);
+    grown.resize(200, 3);
+    writeFile("grown.bmp", grown);
+    writeFile("shrunk.bmp", std::vector<uint8_t>(60, 4));
+    
+    // Read into memory, which is the io_uring path when it is built
+    ImageListSource list(index.entries());
+    ImageCache no_cache(0);
+    ImagePrefetcher prefetcher(list, no_cache, 2, SIZE_MAX);
+    prefetcher.start();
+    std::cout << "  Backend: " << prefetcher.backendName() << std::endl;
+    for (int i = 0; i < 2; ++i) {
+        PrefetchedImage image;
+        TEST_ASSERT(prefetcher.next(image, std::chrono::milliseconds(5000)) && image.loaded,
+                    "Changed file should load");
+        bool is_grown = image.entry.path.find("grown") != std::string::npos;
+        TEST_ASSERT(is_grown ? image.image.size() == 200 && image.image.data()[199] == 3 :
+                               image.image.size() == 60 && image.image.data()[59] == 4,
+                    "Image should have the file's current size and contents");
+    }
+    prefetcher.stop();
+    
+    fs::remove_all(kTestDirectory);
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_mapped_file() {
+    std::cout << "Testing: Memory-mapped image files..." << std::endl;
+    
+    fs::create_directory(kTestDirectory);
+    std::vector<uint8_t> bytes = makeBmp(16, 16, 7);
+    writeFile("mapped.bmp", bytes);
+    writeFile("empty.bmp", {});
+    std::string path = (fs::path(kTestDirectory) / "mapped.bmp").string();
+    
+    SharedBuffer mapped;
+    TEST_ASSERT(mapFile(path, mapped), "Mapping should succeed");
+    TEST_ASSERT(mapped.size() == bytes.size() &&
+                std::equal(bytes.begin(), bytes.end(), mapped.data()), "Mapped contents");
+    
+    // Slices keep the mapping alive after the original buffer is gone
+    SharedBuffer tail = mapped.slice(54, 16);
+    mapped = SharedBuffer();
+    TEST_ASSERT(tail.size() == 16 && tail.data()[15] == 7, "Slice outlives the buffer");
+    
+    // Moving leaves the source empty, not pointing at bytes it released
+    SharedBuffer moved(std::move(tail));
+    TEST_ASSERT(moved.size() == 16 && tail.empty() && tail.data() == nullptr,
+                "Moved-from buffer should be empty");
+    tail = std::move(moved);
+    TEST_ASSERT(tail.size() == 16 && moved.empty() && moved.data() == nullptr,
+                "Move-assigned-from buffer should be empty");
+    
+    SharedBuffer empty;
+    TEST_ASSERT(!mapFile((fs::path(kTestDirectory) / "empty.bmp").string(), empty),
+                "Empty files cannot be mapped");
+    TEST_ASSERT(!mapFile((fs::path(kTestDirectory) / "missing.bmp").string(), empty),
+                "Missing files cannot be mapped");
+    
+    fs::remove_all(kTestDirectory);
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_recursive_index() {
+    std::cout << "Testing: Recursive index with subdirectories..." << std::endl;
+    
+    fs::remove_all(kTestDirectory);
+    fs::create_directories(fs::path(kTestDirectory) / "day1" / "dive2");
+    writeFile("top.bmp", makeBmp(4, 4, 1));
+    writeFile("day1/a.bmp", makeBmp(8, 4, 2));
+    writeFile("day1/dive2/b.bmp", makeBmp(16, 4, 3));
+    
+    ImageIndex flat(kTestDirectory);
+    TEST_ASSERT(flat.refresh() && flat.entries().size() == 1, "Flat index ignores subdirectories");
+    
+    ImageIndex index(kTestDirectory, true);
+    TEST_ASSERT(index.refresh() && index.entries().size() == 3, "Recursive index finds all images");
+    TEST_ASSERT(index.save(), "Save should succeed");
+    
+    ImageIndex reloaded(kTestDirectory, true);
+    TEST_ASSERT(reloaded.load() && reloaded.entries().size() == 3, "Reload");
+    TEST_ASSERT(reloaded.entries()[1].path == (fs::path(kTestDirectory) / "day1" / "dive2" / "b.bmp").string(),
+                "Paths below the directory should survive a reload");
+    TEST_ASSERT(reloaded.refresh() && reloaded.reusedCount() == 3, "Nested files reused");
+    TEST_ASSERT(reloaded.entries()[1].width == 16, "Nested metadata kept");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_manifest_source() {
+    std::cout << "Testing: Manifest image source..." << std::endl;
+    
+    std::string path;
+    int64_t timestamp = 0;
+    TEST_ASSERT(!ManifestImageSource::parseLine("   ", path, timestamp), "Blank line skipped");
+    TEST_ASSERT(!ManifestImageSource::parseLine("# comment", path, timestamp), "Comment skipped");
+    TEST_ASSERT(ManifestImageSource::parseLine("a.png", path, timestamp) &&
+                path == "a.png" && timestamp == 0, "Path only");
+    TEST_ASSERT(ManifestImageSource::parseLine(" dive 2/a.png \t 1700000000123456789\r", path, timestamp) &&
+                path == "dive 2/a.png" && timestamp == 1700000000123456789LL,
+                "Path with spaces and a timestamp");
+    TEST_ASSERT(ManifestImageSource::parseLine("frame 12b.png", path, timestamp) &&
+                path == "frame 12b.png" && timestamp == 0, "Non-numeric last field belongs to the path");
+    
+    std::string absolute = fs::absolute(fs::path(kTestDirectory) / "top.bmp").string();
+    writeFile("list.txt", {});
+    {
+        std::ofstream manifest(fs::path(kTestDirectory) / "list.txt");
+        manifest << "# dive 2\n" << "day1/a.bmp 42\n\n" << absolute << "\n" << "gone.bmp\n";
+    }
+    
+    ManifestImageSource source((fs::path(kTestDirectory) / "list.txt").string());
+    TEST_ASSERT(source.open(), "Manifest should open");
+    for (int pass = 0; pass < 2; ++pass) {
+        ImageIndexEntry entry;
+        std::chrono::milliseconds timeout(0);
+        TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::IMAGE &&
+                    entry.path == (fs::path(kTestDirectory) / "day1/a.bmp").string() &&
+                    entry.timestamp == 42 && entry.size == 70, "Relative path with timestamp");
+        TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::IMAGE &&
+                    entry.path == absolute && entry.timestamp == 0, "Absolute path");
+        TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::IMAGE && entry.size == 0,
+                    "Missing files are passed on");
+        TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::END_OF_PASS, "End of pass");
+        TEST_ASSERT(source.rewind(), "Rewind should succeed");
+    }
+    
+    ManifestImageSource missing((fs::path(kTestDirectory) / "missing.txt").string());
+    TEST_ASSERT(!missing.open(), "Missing manifest should fail to open");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_directory_stream() {
+    std::cout << "Testing: Streaming directory listing..." << std::endl;
+    
+    // A queue smaller than the dataset: listing waits for the consumer
+    DirectoryStreamSource source(kTestDirectory, true, 1);
+    ImageCache cache(0);
+    ImagePrefetcher prefetcher(source, cache, 2, SIZE_MAX);
+    prefetcher.start();
+    
+    std::set<std::string> seen;
+    for (int i = 0; i < 3; ++i) {
+        PrefetchedImage image;
+        TEST_ASSERT(prefetcher.next(image, std::chrono::milliseconds(5000)), "Image should arrive");
+        TEST_ASSERT(image.loaded && image.entry.size == 70 && image.position == static_cast<size_t>(i),
+                    "Streamed image should be loaded");
+        seen.insert(image.entry.path);
+    }
+    TEST_ASSERT(seen.size() == 3, "Every image of the tree should be listed once");
+    
+    // The next pass lists the directory again and finds new files
+    writeFile("day1/new.bmp", makeBmp(2, 2, 9));
+    bool found = false;
+    for (int i = 0; i < 8 && !found; ++i) {
+        PrefetchedImage image;
+        TEST_ASSERT(prefetcher.next(image, std::chrono::milliseconds(5000)), "Looping should continue");
+        found = fs::path(image.entry.path).filename() == "new.bmp";
+    }
+    TEST_ASSERT(found, "File added during playback should be published on a later pass");
+    prefetcher.stop();
+    
+    DirectoryStreamSource flat(kTestDirectory, false);
+    ImageIndexEntry entry;
+    std::chrono::milliseconds timeout(5000);
+    TEST_ASSERT(flat.next(entry, timeout) == ImageSource::Result::IMAGE &&
+                fs::path(entry.path).filename() == "top.bmp", "Top-level image only");
+    TEST_ASSERT(flat.next(entry, timeout) == ImageSource::Result::END_OF_PASS &&
+                flat.listedCount() == 1, "Subdirectories are skipped");
+    
+    fs::remove_all(kTestDirectory);
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_watch_source() {
+    std::cout << "Testing: Watching a directory for new images..." << std::endl;
+    
+    fs::remove_all(kTestDirectory);
+    fs::create_directory(kTestDirectory);
+    writeFile("before.bmp", makeBmp(4, 4, 1));
+    
+    WatchDirectorySource source(kTestDirectory, true, 2);
+    TEST_ASSERT(source.open(), "Watch should start");
+    
+    ImageIndexEntry entry;
+    std::chrono::milliseconds timeout(1000);
+    TEST_ASSERT(source.next(entry, std::chrono::milliseconds(20)) == ImageSource::Result::PENDING,
+                "Existing files are not published");
+    
+    // Written in place, renamed into place, and not an image
+    writeFile("written.bmp", makeBmp(8, 8, 2));
+    writeFile("renamed.tmp", makeBmp(16, 8, 3));
+    fs::rename(fs::path(kTestDirectory) / "renamed.tmp", fs::path(kTestDirectory) / "renamed.bmp");
+    writeFile("notes.txt", {'x'});
+    
+    TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::IMAGE &&
+                fs::path(entry.path).filename() == "written.bmp" && entry.size == 70,
+                "Closed file should be published");
+    TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::IMAGE &&
+                fs::path(entry.path).filename() == "renamed.bmp", "Renamed file should be published");
+    TEST_ASSERT(source.next(entry, std::chrono::milliseconds(20)) == ImageSource::Result::PENDING,
+                "Other files are ignored");
+    
+    // Subdirectories created while watching are watched too
+    fs::create_directory(fs::path(kTestDirectory) / "dive3");
+    TEST_ASSERT(source.next(entry, std::chrono::milliseconds(20)) == ImageSource::Result::PENDING,
+                "A directory is not an image");
+    writeFile("dive3/deep.bmp", makeBmp(2, 2, 4));
+    TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::IMAGE &&
+                fs::path(entry.path).filename() == "deep.bmp", "New subdirectory should be watched");
+    
+    // A burst beyond the queue keeps the newest files
+    for (int i = 0; i < 4; ++i) {
+        writeFile("burst" + std::to_string(i) + ".bmp", makeBmp(2, 2, 5));
+    }
+    TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::IMAGE &&
+                fs::path(entry.path).filename() == "burst2.bmp" && source.droppedCount() == 2,
+                "Oldest files of a burst should be dropped");
+    TEST_ASSERT(source.next(entry, timeout) == ImageSource::Result::IMAGE &&
+                fs::path(entry.path).filename() == "burst3.bmp", "Newest file kept");
+    
+    WatchDirectorySource missing((fs::path(kTestDirectory) / "missing").string(), false);
+    TEST_ASSERT(!missing.open(), "Missing directory cannot be watched");
+    
+    fs::remove_all(kTestDirectory);
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_generated_images() {
+    std::cout << "Testing: Images generated by the source in memory..." << std::endl;
+    
+    // The generated paths do not exist; nothing may be read from disk
+    CountingSource source(3);
+    ImageCache cache(1024);
+    ImagePrefetcher prefetcher(source, cache, 2, SIZE_MAX);
+    prefetcher.start();
+    for (size_t i = 0; i < 6; ++i) {
+        PrefetchedImage image;
+        TEST_ASSERT(prefetcher.next(image, std::chrono::milliseconds(5000)), "Image should arrive");
+        TEST_ASSERT(image.loaded && image.position == i % 3 && image.image.size() == 16 &&
+                    image.image.data()[0] == static_cast<uint8_t>(i % 3),
+                    "Generated image should be passed through in order");
+    }
+    TEST_ASSERT(cache.hits() == 0 && cache.misses() == 0, "Generated images bypass the cache");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Image Index and Cache Unit Tests" << std::endl;
+    std::cout << "Author: Haobo (Brian) Liu" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    int passed = 0;
+    int total = 0;
+    
+    total++; if (test_build_and_reload()) passed++;
+    total++; if (test_incremental_refresh()) passed++;
+    total++; if (test_corrupt_index()) passed++;
+    total++; if (test_image_cache()) passed++;
+    total++; if (test_prefetcher()) passed++;
+    total++; if (test_prefetch_changed_files()) passed++;
+    total++; if (test_mapped_file()) passed++;
+    total++; if (test_recursive_index()) passed++;
+    total++; if (test_manifest_source()) passed++;
+    total++; if (test_directory_stream()) passed++;
+    total++; if (test_watch_source()) passed++;
+    total++; if (test_generated_images()) passed++;
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    return (passed == total) ? 0 : 1;
+}
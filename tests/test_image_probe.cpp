@@ -0,0 +1,280 @@
+/**
+ * Unit Tests for Image Header Probing
+ *
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "image_probe.h"
+#include <iostream>
+#include <vector>
+
+using namespace imaging;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+void putU16(std::vector<uint8_t>& out, uint16_t value, bool big_endian) {
+    if (big_endian) {
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    } else {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+    }
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t value, bool big_endian) {
+    if (big_endian) {
+        putU16(out, static_cast<uint16_t>(value >> 16), true);
+        putU16(out, static_cast<uint16_t>(value), true);
+    } else {
+        putU16(out, static_cast<uint16_t>(value), false);
+        putU16(out, static_cast<uint16_t>(value >> 16), false);
+    }
+}
+
+void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& payload) {
+    putU32(out, static_cast<uint32_t>(payload.size()), true);
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), payload.begin(), payload.end());
+    putU32(out, 0, true);  // CRC is not checked
+}
+
+std::vector<uint8_t> makePng(uint32_t width, uint32_t height, uint8_t color_type, bool trns) {
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> ihdr;
+    putU32(ihdr, width, true);
+    putU32(ihdr, height, true);
+    ihdr.insert(ihdr.end(), {8, color_type, 0, 0, 0});
+    putChunk(png, "IHDR", ihdr);
+    putChunk(png, "gAMA", {0, 0, 0xB1, 0x8F});
+    if (color_type == 3) {
+        putChunk(png, "PLTE", {0, 0, 0, 255, 255, 255});
+    }
+    if (trns) {
+        putChunk(png, "tRNS", {0});
+    }
+    putChunk(png, "IDAT", {1, 2, 3});
+    return png;
+}
+
+std::vector<uint8_t> makeBmp(int32_t width, int32_t height, uint16_t bits, uint32_t compression,
+                             const std::vector<uint8_t>& palette) {
+    std::vector<uint8_t> bmp = {'B', 'M'};
+    putU32(bmp, 0, false);
+    putU32(bmp, 0, false);
+    putU32(bmp, 54 + static_cast<uint32_t>(palette.size()), false);
+    putU32(bmp, 40, false);
+    putU32(bmp, static_cast<uint32_t>(width), false);
+    putU32(bmp, static_cast<uint32_t>(height), false);
+    putU16(bmp, 1, false);
+    putU16(bmp, bits, false);
+    putU32(bmp, compression, false);
+    putU32(bmp, 0, false);
+    putU32(bmp, 2835, false);
+    putU32(bmp, 2835, false);
+    putU32(bmp, static_cast<uint32_t>(palette.size() / 4), false);
+    putU32(bmp, 0, false);
+    bmp.insert(bmp.end(), palette.begin(), palette.end());
+    return bmp;
+}
+
+std::vector<uint8_t> makeTiff(bool big_endian, uint32_t width, uint16_t height,
+                              uint16_t photometric, uint16_t samples) {
+    std::vector<uint8_t> tiff;
+    if (big_endian) {
+        tiff = {'M', 'M', 0, 42};
+    } else {
+        tiff = {'I', 'I', 42, 0};
+    }
+    putU32(tiff, 8, big_endian);
+    
+    struct Entry { uint16_t tag; uint16_t type; uint32_t value; };
+    std::vector<Entry> entries = {
+        {256, 4, width}, {257, 3, height}, {258, 3, 8},
+        {262, 3, photometric}, {277, 3, samples}
+    };
+    putU16(tiff, static_cast<uint16_t>(entries.size()), big_endian);
+    for (const Entry& entry : entries) {
+        putU16(tiff, entry.tag, big_endian);
+        putU16(tiff, entry.type, big_endian);
+        putU32(tiff, 1, big_endian);
+        if (entry.type == 3) {
+            putU16(tiff, static_cast<uint16_t>(entry.value), big_endian);
+            putU16(tiff, 0, big_endian);
+        } else {
+            putU32(tiff, entry.value, big_endian);
+        }
+    }
+    putU32(tiff, 0, big_endian);  // No next IFD
+    return tiff;
+}
+
+} // namespace
+
+bool test_png() {
+    std::cout << "Testing: PNG header probing..." << std::endl;
+    
+    ImageDimensions dims;
+    std::vector<uint8_t> rgb = makePng(4000, 3000, 2, false);
+    TEST_ASSERT(probeImageDimensions(rgb.data(), rgb.size(), dims), "RGB probe should succeed");
+    TEST_ASSERT(dims.width == 4000 && dims.height == 3000 && dims.channels == 3, "RGB dimensions");
+    
+    std::vector<uint8_t> rgb_trns = makePng(10, 20, 2, true);
+    TEST_ASSERT(probeImageDimensions(rgb_trns.data(), rgb_trns.size(), dims) && dims.channels == 4,
+                "tRNS should add an alpha channel");
+    
+    std::vector<uint8_t> grey = makePng(10, 20, 0, false);
+    TEST_ASSERT(probeImageDimensions(grey.data(), grey.size(), dims) && dims.channels == 1,
+                "Grey should have one channel");
+    
+    std::vector<uint8_t> palette = makePng(10, 20, 3, false);
+    TEST_ASSERT(probeImageDimensions(palette.data(), palette.size(), dims) && dims.channels == 3,
+                "Palette should expand to three channels");
+    
+    std::vector<uint8_t> rgba = makePng(10, 20, 6, false);
+    TEST_ASSERT(probeImageDimensions(rgba.data(), rgba.size(), dims) && dims.channels == 4,
+                "RGBA should have four channels");
+    
+    // The tRNS search needs to reach IDAT
+    TEST_ASSERT(!probeImageDimensions(rgb.data(), 40, dims), "Truncated chunk list should fail");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_jpeg() {
+    std::cout << "Testing: JPEG header probing..." << std::endl;
+    
+    // SOI, APP0 (JFIF), fill byte, SOF2 (progressive), then SOS
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8, 0xFF, 0xE0};
+    putU16(jpeg, 16, true);
+    jpeg.insert(jpeg.end(), {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0});
+    jpeg.insert(jpeg.end(), {0xFF, 0xFF, 0xC2});
+    putU16(jpeg, 17, true);
+    jpeg.push_back(8);
+    putU16(jpeg, 1080, true);
+    putU16(jpeg, 1920, true);
+    jpeg.push_back(3);
+    jpeg.insert(jpeg.end(), {1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1});
+    jpeg.insert(jpeg.end(), {0xFF, 0xDA, 0, 8});
+    
+    ImageDimensions dims;
+    TEST_ASSERT(probeImageDimensions(jpeg.data(), jpeg.size(), dims), "JPEG probe should succeed");
+    TEST_ASSERT(dims.width == 1920 && dims.height == 1080 && dims.channels == 3, "JPEG dimensions");
+    
+    // Grey image with a baseline frame header
+    jpeg[22] = 0xC0;
+    jpeg[30] = 1;
+    TEST_ASSERT(probeImageDimensions(jpeg.data(), jpeg.size(), dims) && dims.channels == 1,
+                "Single component JPEG should have one channel");
+    
+    TEST_ASSERT(!probeImageDimensions(jpeg.data(), 30, dims), "Truncated frame header should fail");
+    
+    // DHT is not a frame header
+    std::vector<uint8_t> no_frame = {0xFF, 0xD8, 0xFF, 0xC4, 0, 2, 0xFF, 0xDA, 0, 8, 0, 0};
+    TEST_ASSERT(!probeImageDimensions(no_frame.data(), no_frame.size(), dims),
+                "Scan before frame header should fail");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_bmp() {
+    std::cout << "Testing: BMP header probing..." << std::endl;
+    
+    ImageDimensions dims;
+    std::vector<uint8_t> bgr = makeBmp(640, -480, 24, 0, {});
+    TEST_ASSERT(probeImageDimensions(bgr.data(), bgr.size(), dims), "BMP probe should succeed");
+    TEST_ASSERT(dims.width == 640 && dims.height == 480 && dims.channels == 3,
+                "Top-down BMP dimensions");
+    
+    std::vector<uint8_t> bgra = makeBmp(8, 8, 32, 3, {});
+    TEST_ASSERT(probeImageDimensions(bgra.data(), bgra.size(), dims) && dims.channels == 4,
+                "Bit-field 32-bit BMP should keep alpha");
+    
+    std::vector<uint8_t> bgrx = makeBmp(8, 8, 32, 0, {});
+    TEST_ASSERT(probeImageDimensions(bgrx.data(), bgrx.size(), dims) && dims.channels == 3,
+                "Plain 32-bit BMP should drop the unused byte");
+    
+    std::vector<uint8_t> grey = makeBmp(8, 8, 8, 0, {0, 0, 0, 0, 128, 128, 128, 0});
+    TEST_ASSERT(probeImageDimensions(grey.data(), grey.size(), dims) && dims.channels == 1,
+                "Grey palette should load as one channel");
+    
+    std::vector<uint8_t> colour = makeBmp(8, 8, 8, 0, {0, 0, 0, 0, 255, 0, 0, 0});
+    TEST_ASSERT(probeImageDimensions(colour.data(), colour.size(), dims) && dims.channels == 3,
+                "Colour palette should load as three channels");
+    
+    TEST_ASSERT(!probeImageDimensions(colour.data(), colour.size() - 1, dims),
+                "Truncated palette should fail");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_tiff() {
+    std::cout << "Testing: TIFF header probing..." << std::endl;
+    
+    ImageDimensions dims;
+    std::vector<uint8_t> little = makeTiff(false, 70000, 2000, 2, 3);
+    TEST_ASSERT(probeImageDimensions(little.data(), little.size(), dims), "Intel TIFF should probe");
+    TEST_ASSERT(dims.width == 70000 && dims.height == 2000 && dims.channels == 3,
+                "Intel TIFF dimensions");
+    
+    std::vector<uint8_t> big = makeTiff(true, 300, 200, 1, 1);
+    TEST_ASSERT(probeImageDimensions(big.data(), big.size(), dims), "Motorola TIFF should probe");
+    TEST_ASSERT(dims.width == 300 && dims.height == 200 && dims.channels == 1,
+                "Motorola TIFF dimensions");
+    
+    std::vector<uint8_t> cmyk = makeTiff(false, 300, 200, 5, 4);
+    TEST_ASSERT(!probeImageDimensions(cmyk.data(), cmyk.size(), dims),
+                "CMYK TIFF should be left to the decoder");
+    
+    TEST_ASSERT(!probeImageDimensions(little.data(), 20, dims), "IFD beyond the data should fail");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_unknown_format() {
+    std::cout << "Testing: Unknown formats..." << std::endl;
+    
+    ImageDimensions dims;
+    std::vector<uint8_t> gif = {'G', 'I', 'F', '8', '9', 'a', 1, 0, 1, 0, 0, 0};
+    TEST_ASSERT(!probeImageDimensions(gif.data(), gif.size(), dims), "GIF is not probed");
+    TEST_ASSERT(!probeImageDimensions(nullptr, 0, dims), "Empty input should fail");
+    TEST_ASSERT(dims.width == 0 && dims.height == 0, "Output untouched on failure");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Image Probe Unit Tests" << std::endl;
+    std::cout << "Author: Haobo (Brian) Liu" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    int passed = 0;
+    int total = 0;
+    
+    total++; if (test_png()) passed++;
+    total++; if (test_jpeg()) passed++;
+    total++; if (test_bmp()) passed++;
+    total++; if (test_tiff()) passed++;
+    total++; if (test_unknown_format()) passed++;
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    return (passed == total) ? 0 : 1;
+}
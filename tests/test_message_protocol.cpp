@@ -7,9 +7,14 @@
  */
 
 #include "message_protocol.h"
+#include "chunk_assembler.h"
+#include "shm_transport.h"
+#include "content_hash.h"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
+#include <unistd.h>
 
 using namespace imaging;
 
@@ -123,6 +128,546 @@ bool test_serialize_deserialize_processed_data() {
     return true;
 }
 
+bool test_multipart_image_header() {
+    std::cout << "Testing: Multipart image header..." << std::endl;
+    
+    ImageMetadata metadata;
+    metadata.timestamp = 555555;
+    metadata.width = 4000;
+    metadata.height = 3000;
+    metadata.channels = 3;
+    metadata.data_size = 25 * 1024 * 1024;
+    metadata.filename = "survey_0001.tiff";
+    
+    std::vector<uint8_t> header = MessageProtocol::serializeImageHeader(metadata);
+    TEST_ASSERT(MessageProtocol::getMessageType(header) == MessageType::IMAGE_DATA,
+                "Header frame should be IMAGE_DATA");
+    TEST_ASSERT(header.size() == 29 + metadata.filename.size(),
+                "Header frame should not contain image bytes");
+    
+    ImageMetadata decoded;
+    bool result = MessageProtocol::deserializeImageHeader(header.data(), header.size(), decoded);
+    TEST_ASSERT(result, "Header deserialization should succeed");
+    TEST_ASSERT(decoded.data_size == metadata.data_size, "Data size mismatch");
+    TEST_ASSERT(decoded.width == metadata.width, "Width mismatch");
+    TEST_ASSERT(decoded.filename == metadata.filename, "Filename mismatch");
+    
+    // Truncated header must be rejected
+    TEST_ASSERT(!MessageProtocol::deserializeImageHeader(header.data(), header.size() - 1, decoded),
+                "Truncated header should fail");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_processed_data_view() {
+    std::cout << "Testing: Processed data view parsing..." << std::endl;
+    
+    ImageMetadata metadata;
+    metadata.timestamp = 42;
+    metadata.width = 8;
+    metadata.height = 8;
+    metadata.channels = 1;
+    metadata.filename = "view.png";
+    
+    std::vector<uint8_t> image_data(64, 7);
+    metadata.data_size = image_data.size();
+    
+    std::vector<KeyPoint> keypoints(3);
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        keypoints[i].x = 1.5f * i;
+        keypoints[i].y = 2.5f * i;
+        keypoints[i].octave = static_cast<int>(i) - 1;
+    }
+    std::vector<float> descriptors = {0.25f, 0.5f, 0.75f};
+    
+    std::vector<uint8_t> serialized = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors);
+    
+    ProcessedDataView view;
+    bool result = MessageProtocol::parseProcessedData(serialized.data(), serialized.size(), view);
+    TEST_ASSERT(result, "View parsing should succeed");
+    TEST_ASSERT(view.image_data >= serialized.data() &&
+                view.image_data + view.image_size <= serialized.data() + serialized.size(),
+                "Image view should point into the message");
+    TEST_ASSERT(view.num_keypoints == 3, "Keypoint count mismatch");
+    TEST_ASSERT(view.num_descriptors == 3, "Descriptor count mismatch");
+    
+    std::vector<KeyPoint> decoded_keypoints;
+    std::vector<float> decoded_descriptors;
+    MessageProtocol::decodeKeyPoints(view, decoded_keypoints);
+    MessageProtocol::decodeDescriptors(view, decoded_descriptors);
+    TEST_ASSERT(decoded_keypoints[2].y == keypoints[2].y, "Keypoint y mismatch");
+    TEST_ASSERT(decoded_keypoints[0].octave == -1, "Negative octave mismatch");
+    TEST_ASSERT(decoded_descriptors == descriptors, "Descriptor mismatch");
+    
+    // A message cut inside the descriptor section must be rejected
+    TEST_ASSERT(!MessageProtocol::parseProcessedData(serialized.data(), serialized.size() - 1, view),
+                "Truncated message should fail");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_foreign_byte_order() {
+    std::cout << "Testing: Foreign byte order arrays..." << std::endl;
+    
+    ImageMetadata metadata;
+    metadata.filename = "swap.png";
+    std::vector<uint8_t> image_data = {1, 2, 3};
+    metadata.data_size = image_data.size();
+    
+    // Odd counts exercise both the vector kernel and the scalar tail
+    std::vector<KeyPoint> keypoints(7);
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        keypoints[i].x = 10.25f * i;
+        keypoints[i].response = 0.125f * i;
+        keypoints[i].octave = static_cast<int>(i * 65536 + 3);
+    }
+    std::vector<float> descriptors(13);
+    for (size_t i = 0; i < descriptors.size(); ++i) {
+        descriptors[i] = 1.0f / (i + 1);
+    }
+    
+    ProcessedDataOptions options;
+    options.byte_order = nativeByteOrder() == ByteOrder::LITTLE_ENDIAN_ORDER ?
+                         ByteOrder::BIG_ENDIAN_ORDER : ByteOrder::LITTLE_ENDIAN_ORDER;
+    
+    std::vector<uint8_t> swapped = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors, options);
+    std::vector<uint8_t> native = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors);
+    TEST_ASSERT(swapped.size() == native.size(), "Encoded sizes should match");
+    TEST_ASSERT(swapped != native, "Foreign encoding should differ from native");
+    
+    ImageMetadata decoded_metadata;
+    std::vector<uint8_t> decoded_image;
+    std::vector<KeyPoint> decoded_keypoints;
+    std::vector<float> decoded_descriptors;
+    bool result = MessageProtocol::deserializeProcessedData(
+        swapped, decoded_metadata, decoded_image, decoded_keypoints, decoded_descriptors);
+    
+    TEST_ASSERT(result, "Deserialization should succeed");
+    TEST_ASSERT(decoded_keypoints.size() == keypoints.size(), "Keypoint count mismatch");
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        TEST_ASSERT(decoded_keypoints[i].x == keypoints[i].x, "Keypoint x mismatch");
+        TEST_ASSERT(decoded_keypoints[i].response == keypoints[i].response, "Response mismatch");
+        TEST_ASSERT(decoded_keypoints[i].octave == keypoints[i].octave, "Octave mismatch");
+    }
+    TEST_ASSERT(decoded_descriptors == descriptors, "Descriptor mismatch");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_serialize_into_reused_buffer() {
+    std::cout << "Testing: Exact-size serialization into reused buffer..." << std::endl;
+    
+    ImageMetadata metadata;
+    metadata.timestamp = 77;
+    metadata.filename = "reuse.png";
+    std::vector<uint8_t> image_data(1000, 3);
+    metadata.data_size = image_data.size();
+    
+    std::vector<KeyPoint> keypoints(50);
+    std::vector<float> descriptors(50 * 128, 1.0f);
+    
+    std::vector<uint8_t> expected = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors);
+    size_t predicted = MessageProtocol::processedDataSize(
+        metadata, image_data.size(), keypoints.size(), descriptors.size());
+    TEST_ASSERT(predicted == expected.size(), "Predicted size should be exact");
+    
+    std::vector<uint8_t> buffer;
+    size_t written = MessageProtocol::serializeProcessedDataInto(
+        buffer, metadata, image_data.data(), image_data.size(), keypoints, descriptors);
+    TEST_ASSERT(written == expected.size() && buffer == expected, "Output should match");
+    
+    // A smaller frame must reuse the existing storage
+    const uint8_t* storage = buffer.data();
+    keypoints.resize(10);
+    descriptors.resize(10 * 128);
+    written = MessageProtocol::serializeProcessedDataInto(
+        buffer, metadata, image_data.data(), image_data.size(), keypoints, descriptors);
+    TEST_ASSERT(buffer.data() == storage, "Buffer should not be reallocated");
+    TEST_ASSERT(written == buffer.size(), "Buffer should be trimmed to the message size");
+    
+    // Raw memory variant refuses to overrun
+    std::vector<uint8_t> raw(written - 1);
+    TEST_ASSERT(MessageProtocol::serializeProcessedDataInto(
+                    raw.data(), raw.size(), metadata, image_data.data(), image_data.size(),
+                    keypoints, descriptors) == 0,
+                "Undersized raw buffer should be rejected");
+    
+    std::vector<uint8_t> image_message;
+    written = MessageProtocol::serializeImageDataInto(image_message, metadata,
+                                                      image_data.data(), image_data.size());
+    TEST_ASSERT(image_message == MessageProtocol::serializeImageData(metadata, image_data),
+                "Image data output should match");
+    TEST_ASSERT(written == MessageProtocol::imageDataSize(metadata, image_data.size()),
+                "Image data size should be exact");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_quantized_descriptors() {
+    std::cout << "Testing: Quantized descriptor encodings..." << std::endl;
+    
+    ImageMetadata metadata;
+    metadata.filename = "quantized.png";
+    std::vector<uint8_t> image_data(16, 1);
+    metadata.data_size = image_data.size();
+    std::vector<KeyPoint> keypoints(2);
+    
+    // SIFT-like values: integers in 0..255 plus a few fractional ones
+    std::vector<float> descriptors(2 * 128);
+    for (size_t i = 0; i < descriptors.size(); ++i) {
+        descriptors[i] = static_cast<float>((i * 37) % 256);
+    }
+    descriptors[5] = 12.4f;
+    descriptors[6] = 300.0f;  // Out of range for uint8
+    
+    size_t float_size = MessageProtocol::processedDataSize(
+        metadata, image_data.size(), keypoints.size(), descriptors.size());
+    
+    DescriptorEncoding encodings[] = {DescriptorEncoding::UINT8, DescriptorEncoding::FLOAT16};
+    for (DescriptorEncoding encoding : encodings) {
+        ProcessedDataOptions options;
+        options.descriptor_encoding = encoding;
+        
+        std::vector<uint8_t> serialized = MessageProtocol::serializeProcessedData(
+            metadata, image_data, keypoints, descriptors, options);
+        TEST_ASSERT(float_size - serialized.size() ==
+                    descriptors.size() * (4 - descriptorElementSize(encoding)),
+                    "Quantized message should shrink by the descriptor savings");
+        
+        ProcessedDataView view;
+        TEST_ASSERT(MessageProtocol::parseProcessedData(serialized.data(), serialized.size(), view),
+                    "Parsing should succeed");
+        TEST_ASSERT(view.descriptor_encoding == encoding, "Encoding should round-trip");
+        
+        std::vector<float> decoded;
+        MessageProtocol::decodeDescriptors(view, decoded);
+        TEST_ASSERT(decoded.size() == descriptors.size(), "Descriptor count mismatch");
+        TEST_ASSERT(decoded[10] == descriptors[10], "Integer values should be exact");
+        
+        if (encoding == DescriptorEncoding::UINT8) {
+            TEST_ASSERT(decoded[5] == 12.0f, "uint8 should round to nearest");
+            TEST_ASSERT(decoded[6] == 255.0f, "uint8 should saturate");
+        } else {
+            TEST_ASSERT(decoded[5] > 12.39f && decoded[5] < 12.41f, "float16 precision");
+            TEST_ASSERT(decoded[6] == 300.0f, "float16 keeps out-of-range values");
+        }
+    }
+    
+    // Half precision edge cases
+    TEST_ASSERT(halfToFloat(floatToHalf(65504.0f)) == 65504.0f, "Largest half");
+    TEST_ASSERT(halfToFloat(floatToHalf(1.0e-7f)) > 0.0f, "Subnormal half");
+    TEST_ASSERT(halfToFloat(floatToHalf(-2.5f)) == -2.5f, "Negative half");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_compressed_features() {
+    std::cout << "Testing: Compressed feature section..." << std::endl;
+    
+    ImageMetadata metadata;
+    metadata.filename = "compressed.png";
+    std::vector<uint8_t> image_data(64, 7);
+    metadata.data_size = image_data.size();
+    
+    // Keypoints sorted by row, as SIFT tends to emit them
+    std::vector<KeyPoint> keypoints(200);
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        keypoints[i].x = 3.5f * (i % 40);
+        keypoints[i].y = 2.0f * (i / 40);
+        keypoints[i].size = 1.6f;
+        keypoints[i].angle = static_cast<float>(i % 360);
+        keypoints[i].response = 0.01f * (i % 7);
+        keypoints[i].octave = static_cast<int>(i % 4);
+    }
+    std::vector<float> descriptors(keypoints.size() * 128);
+    for (size_t i = 0; i < descriptors.size(); ++i) {
+        descriptors[i] = static_cast<float>((i * i) % 61);
+    }
+    
+    CompressionCodec codecs[] = {CompressionCodec::ZLIB, CompressionCodec::LZMA};
+    ByteOrder orders[] = {ByteOrder::LITTLE_ENDIAN_ORDER, ByteOrder::BIG_ENDIAN_ORDER};
+    for (CompressionCodec codec : codecs) {
+        if (!compressionAvailable(codec)) {
+            std::cout << "  (skipping " << compressionCodecName(codec) << ")" << std::endl;
+            continue;
+        }
+        for (ByteOrder order : orders) {
+            ProcessedDataOptions options;
+            options.byte_order = order;
+            options.compression = codec;
+            
+            std::vector<uint8_t> plain = MessageProtocol::serializeProcessedData(
+                metadata, image_data, keypoints, descriptors);
+            std::vector<uint8_t> compressed = MessageProtocol::serializeProcessedData(
+                metadata, image_data, keypoints, descriptors, options);
+            TEST_ASSERT(!compressed.empty(), "Compression should succeed");
+            TEST_ASSERT(compressed.size() < plain.size() / 2, "Features should compress");
+            
+            // The plain parser cannot expose compressed features in place
+            ProcessedDataView view;
+            TEST_ASSERT(!MessageProtocol::parseProcessedData(compressed.data(), compressed.size(),
+                                                             view),
+                        "Parsing without scratch should fail");
+            
+            std::vector<uint8_t> scratch;
+            TEST_ASSERT(MessageProtocol::parseProcessedData(compressed.data(), compressed.size(),
+                                                            view, scratch),
+                        "Parsing with scratch should succeed");
+            TEST_ASSERT(view.compression == codec, "Codec should round-trip");
+            TEST_ASSERT(view.image_data == compressed.data() + 3 + 28 + metadata.filename.size(),
+                        "Image should still be referenced in place");
+            
+            std::vector<KeyPoint> decoded_keypoints;
+            std::vector<float> decoded_descriptors;
+            MessageProtocol::decodeKeyPoints(view, decoded_keypoints);
+            MessageProtocol::decodeDescriptors(view, decoded_descriptors);
+            TEST_ASSERT(decoded_keypoints.size() == keypoints.size(), "Keypoint count mismatch");
+            for (size_t i = 0; i < keypoints.size(); ++i) {
+                TEST_ASSERT(decoded_keypoints[i].x == keypoints[i].x, "Keypoint x mismatch");
+                TEST_ASSERT(decoded_keypoints[i].y == keypoints[i].y, "Keypoint y mismatch");
+                TEST_ASSERT(decoded_keypoints[i].octave == keypoints[i].octave, "Octave mismatch");
+            }
+            TEST_ASSERT(decoded_descriptors == descriptors, "Descriptor mismatch");
+            
+            // Truncated payloads are rejected rather than misparsed
+            TEST_ASSERT(!MessageProtocol::parseProcessedData(compressed.data(),
+                                                             compressed.size() - 4,
+                                                             view, scratch),
+                        "Truncated payload should fail");
+            
+            // An inflated raw size is refused before anything is allocated
+            std::vector<uint8_t> inflated = compressed;
+            size_t raw_size_offset = 3 + 28 + metadata.filename.size() + image_data.size() + 1;
+            for (size_t i = 0; i < 4; ++i) {
+                inflated[raw_size_offset + i] = 0xff;
+            }
+            std::vector<uint8_t> fresh_scratch;
+            TEST_ASSERT(!MessageProtocol::parseProcessedData(inflated.data(), inflated.size(),
+                                                             view, fresh_scratch),
+                        "Oversized raw size should fail");
+            TEST_ASSERT(fresh_scratch.capacity() == 0, "Oversized raw size should not allocate");
+        }
+    }
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_chunked_image_transfer() {
+    std::cout << "Testing: Chunked image transfer..." << std::endl;
+    
+    std::vector<uint8_t> image(1000);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<uint8_t>(i * 31);
+    }
+    
+    ImageChunkHeader header;
+    header.metadata.filename = "large.tiff";
+    header.metadata.width = 4000;
+    header.metadata.data_size = static_cast<uint32_t>(image.size());
+    header.transfer_id = 7;
+    header.chunk_count = 3;
+    
+    // Header frames round-trip
+    header.chunk_index = 1;
+    header.chunk_offset = 400;
+    std::vector<uint8_t> frame = MessageProtocol::serializeImageChunkHeader(header);
+    ImageChunkHeader decoded;
+    TEST_ASSERT(MessageProtocol::getMessageType(frame) == MessageType::IMAGE_CHUNK,
+                "Type should be IMAGE_CHUNK");
+    TEST_ASSERT(MessageProtocol::deserializeImageChunkHeader(frame.data(), frame.size(), decoded),
+                "Chunk header should parse");
+    TEST_ASSERT(decoded.transfer_id == 7 && decoded.chunk_index == 1 &&
+                decoded.chunk_count == 3 && decoded.chunk_offset == 400,
+                "Chunk fields mismatch");
+    TEST_ASSERT(decoded.metadata.filename == "large.tiff", "Metadata mismatch");
+    
+    // Chunks of 400, 400 and 200 bytes reassemble in order
+    ChunkAssembler assembler;
+    const size_t chunk_size = 400;
+    ChunkAssembler::Result result = ChunkAssembler::Result::DROPPED;
+    for (uint32_t i = 0; i < header.chunk_count; ++i) {
+        header.chunk_index = i;
+        header.chunk_offset = i * chunk_size;
+        size_t length = std::min(chunk_size, image.size() - header.chunk_offset);
+        result = assembler.addChunk(header, image.data() + header.chunk_offset, length);
+        TEST_ASSERT(result == (i + 1 < header.chunk_count ? ChunkAssembler::Result::INCOMPLETE :
+                                                            ChunkAssembler::Result::COMPLETE),
+                    "Unexpected assembly result");
+    }
+    TEST_ASSERT(assembler.size() == image.size(), "Assembled size mismatch");
+    TEST_ASSERT(std::equal(image.begin(), image.end(), assembler.data()), "Assembled bytes mismatch");
+    TEST_ASSERT(assembler.metadata().width == 4000, "Assembled metadata mismatch");
+    
+    // A late joiner ignores chunks until the next transfer starts
+    header.transfer_id = 8;
+    header.chunk_index = 1;
+    header.chunk_offset = 400;
+    TEST_ASSERT(assembler.addChunk(header, image.data() + 400, 400) ==
+                ChunkAssembler::Result::DROPPED, "Mid-transfer chunk should be dropped");
+    
+    // A missing chunk abandons the transfer
+    header.transfer_id = 9;
+    header.chunk_index = 0;
+    header.chunk_offset = 0;
+    TEST_ASSERT(assembler.addChunk(header, image.data(), 400) ==
+                ChunkAssembler::Result::INCOMPLETE, "First chunk should be accepted");
+    header.chunk_index = 2;
+    header.chunk_offset = 800;
+    TEST_ASSERT(assembler.addChunk(header, image.data() + 800, 200) ==
+                ChunkAssembler::Result::DROPPED, "Gap should abandon the transfer");
+    TEST_ASSERT(assembler.droppedTransfers() == 1, "Abandoned transfer should be counted");
+    
+    // Images above the size limit are refused up front
+    ChunkAssembler small(512);
+    header.transfer_id = 10;
+    header.chunk_index = 0;
+    TEST_ASSERT(small.addChunk(header, image.data(), 400) == ChunkAssembler::Result::DROPPED,
+                "Oversized image should be refused");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_shm_ring() {
+    std::cout << "Testing: Shared memory ring..." << std::endl;
+    
+    TEST_ASSERT(isShmEndpoint("shm://imaging0") && !isShmEndpoint("tcp://*:5555"),
+                "Endpoint scheme detection");
+    TEST_ASSERT(transportEndpoint("shm://imaging0") == "ipc:///tmp/imaging-imaging0.ctl",
+                "shm endpoints use an ipc control socket");
+    TEST_ASSERT(transportEndpoint("tcp://*:5555") == "tcp://*:5555",
+                "Other endpoints are used as-is");
+    
+    // Descriptors round-trip
+    ShmDescriptor descriptor;
+    descriptor.generation = 0x1122334455667788ULL;
+    descriptor.sequence = 42;
+    descriptor.offset = 1ULL << 40;
+    descriptor.length = 12345;
+    std::vector<uint8_t> message = MessageProtocol::serializeShmDescriptor(descriptor);
+    ShmDescriptor decoded;
+    TEST_ASSERT(MessageProtocol::deserializeShmDescriptor(message.data(), message.size(), decoded),
+                "Descriptor should parse");
+    TEST_ASSERT(decoded.generation == descriptor.generation && decoded.sequence == 42 &&
+                decoded.offset == descriptor.offset && decoded.length == 12345,
+                "Descriptor fields mismatch");
+    
+    // Producer and read-only consumer mappings of the same segment
+    std::string name = "/imaging-test-" + std::to_string(getpid());
+    ShmRing producer;
+    ShmRing consumer;
+    TEST_ASSERT(producer.create(name, 4096), "Ring creation should succeed");
+    TEST_ASSERT(consumer.open(name), "Ring should open read-only");
+    TEST_ASSERT(consumer.generation() == producer.generation(), "Generation should match");
+    TEST_ASSERT(producer.maxRecordSize() == 1024, "Records are limited to a quarter ring");
+    
+    uint64_t offset = 0;
+    TEST_ASSERT(producer.reserve(2000, offset) == nullptr, "Oversized record should be refused");
+    
+    // An image message is serialized in place and parsed from the consumer mapping
+    ImageMetadata metadata;
+    metadata.filename = "ring.png";
+    std::vector<uint8_t> image(600, 9);
+    metadata.data_size = image.size();
+    size_t size = MessageProtocol::imageDataSize(metadata, image.size());
+    
+    uint8_t* slot = producer.reserve(size, offset);
+    TEST_ASSERT(slot != nullptr, "Reservation should fit");
+    TEST_ASSERT(consumer.record(offset, size) == nullptr, "Uncommitted record is not visible");
+    MessageProtocol::serializeImageDataInto(slot, size, metadata, image.data(), image.size());
+    producer.commit(offset, size);
+    
+    const uint8_t* record = consumer.record(offset, size);
+    ImageDataView view;
+    TEST_ASSERT(record != nullptr, "Committed record should be visible");
+    TEST_ASSERT(MessageProtocol::parseImageData(record, size, view), "Record should parse");
+    TEST_ASSERT(view.metadata.filename == "ring.png" && view.image_size == image.size(),
+                "Record contents mismatch");
+    
+    // Records never wrap and the first one is reported once the ring laps it
+    uint64_t first = offset;
+    std::vector<uint64_t> offsets;
+    for (int i = 0; i < 8; ++i) {
+        uint64_t next = 0;
+        TEST_ASSERT(producer.reserve(size, next) != nullptr, "Reservation should succeed");
+        TEST_ASSERT(next % 4096 + size <= 4096, "Records must not wrap");
+        producer.commit(next, size);
+        offsets.push_back(next);
+    }
+    TEST_ASSERT(!consumer.intact(first), "Overwritten record should be detected");
+    TEST_ASSERT(consumer.record(first, size) == nullptr, "Overwritten record is not returned");
+    
+    // A reservation given up without a commit stops marking the oldest
+    // record as overwritten
+    auto oldest = std::find_if(offsets.begin(), offsets.end(),
+                               [&consumer](uint64_t o) { return consumer.intact(o); });
+    TEST_ASSERT(oldest != offsets.end(), "Some records should still be intact");
+    uint64_t abandoned = 0;
+    TEST_ASSERT(producer.reserve(1024, abandoned) != nullptr && !consumer.intact(*oldest),
+                "Reservation should claim the oldest record's space");
+    producer.abort();
+    TEST_ASSERT(consumer.intact(*oldest) && consumer.record(*oldest, size) != nullptr,
+                "Aborted reservation should leave the record intact");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_image_by_reference() {
+    std::cout << "Testing: Image sent by reference..." << std::endl;
+    
+    // Reference XXH64 values
+    TEST_ASSERT(contentHash(nullptr, 0) == 0xEF46DB3751D8E999ULL, "Empty input hash");
+    const uint8_t abc[] = {'a', 'b', 'c'};
+    TEST_ASSERT(contentHash(abc, sizeof(abc)) == 0x44BC2CF5AD770999ULL, "Short input hash");
+    
+    ImageMetadata metadata;
+    metadata.filename = "reference.png";
+    std::vector<uint8_t> image_data(5000);
+    for (size_t i = 0; i < image_data.size(); ++i) {
+        image_data[i] = static_cast<uint8_t>(i * 13);
+    }
+    metadata.data_size = image_data.size();
+    std::vector<KeyPoint> keypoints(3);
+    keypoints[1].x = 7.5f;
+    std::vector<float> descriptors(3 * 128, 2.0f);
+    
+    ProcessedDataOptions options;
+    options.image_by_reference = true;
+    std::vector<uint8_t> full = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors);
+    std::vector<uint8_t> reference = MessageProtocol::serializeProcessedData(
+        metadata, image_data, keypoints, descriptors, options);
+    TEST_ASSERT(full.size() - reference.size() == image_data.size() - 8,
+                "Image bytes should be replaced by an 8-byte hash");
+    
+    ProcessedDataView view;
+    TEST_ASSERT(MessageProtocol::parseProcessedData(reference.data(), reference.size(), view),
+                "Parsing should succeed");
+    TEST_ASSERT(view.image_by_reference, "Reference flag should be set");
+    TEST_ASSERT(view.image_hash == contentHash(image_data.data(), image_data.size()),
+                "Hash should identify the image");
+    TEST_ASSERT(view.image_data == nullptr && view.image_size == 0, "No image bytes expected");
+    TEST_ASSERT(view.metadata.data_size == image_data.size(), "Original size is kept");
+    
+    std::vector<KeyPoint> decoded;
+    MessageProtocol::decodeKeyPoints(view, decoded);
+    TEST_ASSERT(decoded.size() == 3 && decoded[1].x == 7.5f, "Features should still decode");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
 bool test_message_type() {
     std::cout << "Testing: Message type detection..." << std::endl;
     
@@ -158,6 +703,45 @@ bool test_heartbeat() {
     return true;
 }
 
+bool test_credit_heartbeat() {
+    std::cout << "Testing: Heartbeat with credit grant..." << std::endl;
+    
+    CreditGrant grant;
+    grant.stage = "feature_extractor:4242";
+    grant.timestamp = 1234567890123ULL;
+    grant.consumed = 5000000000ULL;
+    grant.window = 8;
+    
+    std::vector<uint8_t> hb = MessageProtocol::serializeHeartbeat(grant);
+    TEST_ASSERT(MessageProtocol::getMessageType(hb) == MessageType::HEARTBEAT,
+                "Message type should be HEARTBEAT");
+    
+    CreditGrant decoded;
+    TEST_ASSERT(MessageProtocol::deserializeHeartbeat(hb.data(), hb.size(), decoded),
+                "Grant should parse");
+    TEST_ASSERT(decoded.stage == grant.stage && decoded.timestamp == grant.timestamp,
+                "Stage and timestamp mismatch");
+    TEST_ASSERT(decoded.consumed == grant.consumed && decoded.window == grant.window,
+                "Credit fields mismatch");
+    
+    // A plain heartbeat is a grant without credit
+    std::vector<uint8_t> plain = MessageProtocol::serializeHeartbeat("TestApp");
+    TEST_ASSERT(MessageProtocol::deserializeHeartbeat(plain.data(), plain.size(), decoded),
+                "Plain heartbeat should parse");
+    TEST_ASSERT(decoded.stage == "TestApp" && decoded.window == 0 && decoded.consumed == 0,
+                "Plain heartbeat should carry no credit");
+    
+    // Truncated or mistyped messages are rejected
+    TEST_ASSERT(!MessageProtocol::deserializeHeartbeat(hb.data(), 10, decoded),
+                "Truncated heartbeat should be rejected");
+    hb[0] = static_cast<uint8_t>(MessageType::IMAGE_DATA);
+    TEST_ASSERT(!MessageProtocol::deserializeHeartbeat(hb.data(), hb.size(), decoded),
+                "Wrong message type should be rejected");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
 int main() {
     std::cout << "\n======================================" << std::endl;
     std::cout << "Message Protocol Unit Tests" << std::endl;
@@ -169,8 +753,18 @@ int main() {
     
     total++; if (test_serialize_deserialize_image_data()) passed++;
     total++; if (test_serialize_deserialize_processed_data()) passed++;
+    total++; if (test_multipart_image_header()) passed++;
+    total++; if (test_processed_data_view()) passed++;
+    total++; if (test_foreign_byte_order()) passed++;
+    total++; if (test_serialize_into_reused_buffer()) passed++;
+    total++; if (test_quantized_descriptors()) passed++;
+    total++; if (test_compressed_features()) passed++;
+    total++; if (test_chunked_image_transfer()) passed++;
+    total++; if (test_shm_ring()) passed++;
+    total++; if (test_image_by_reference()) passed++;
     total++; if (test_message_type()) passed++;
     total++; if (test_heartbeat()) passed++;
+    total++; if (test_credit_heartbeat()) passed++;
     
     std::cout << "\n======================================" << std::endl;
     std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
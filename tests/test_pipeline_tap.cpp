@@ -0,0 +1,158 @@
+/**
+ * Unit Tests for Tap Recordings
+ * 
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "tap_recording.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace imaging;
+namespace fs = std::filesystem;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+const std::string kRecordingPath = "test_pipeline_tap.rec";
+
+bool frameEquals(const SharedBuffer& frame, const std::vector<uint8_t>& expected) {
+    return frame.size() == expected.size() &&
+           std::equal(expected.begin(), expected.end(), frame.data());
+}
+
+} // namespace
+
+bool test_record_and_read() {
+    std::cout << "Testing: Recording and reading messages..." << std::endl;
+    
+    std::remove(kRecordingPath.c_str());
+    std::vector<uint8_t> header(13, 0xAB);
+    std::vector<uint8_t> payload(1000);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<uint8_t>(i * 7);
+    }
+    
+    {
+        TapWriter writer;
+        TEST_ASSERT(writer.open(kRecordingPath), "Writer should open");
+        TapFrame multipart[] = {{header.data(), header.size()}, {payload.data(), payload.size()}};
+        TEST_ASSERT(writer.append(1000, multipart, 2), "Multipart message should be written");
+        TapFrame single[] = {{payload.data(), 8}};
+        TEST_ASSERT(writer.append(2500, single, 1), "Single frame should be written");
+        TapFrame empty[] = {{nullptr, 0}};
+        TEST_ASSERT(writer.append(4000, empty, 1), "Empty frame should be written");
+        TEST_ASSERT(writer.recordCount() == 3, "Record count");
+    }
+    
+    TapReader reader;
+    TEST_ASSERT(reader.open(kRecordingPath), "Reader should open");
+    TapRecord record;
+    TEST_ASSERT(reader.next(record) && record.timestamp == 1000 && record.frames.size() == 2,
+                "First record");
+    TEST_ASSERT(frameEquals(record.frames[0], header) && frameEquals(record.frames[1], payload),
+                "Frames should round-trip");
+    TEST_ASSERT(reinterpret_cast<uintptr_t>(record.frames[1].data()) % 8 == 0,
+                "Frames should stay 8-byte aligned in the mapping");
+    TEST_ASSERT(reader.next(record) && record.timestamp == 2500 && record.frames.size() == 1 &&
+                record.frames[0].size() == 8, "Second record");
+    TEST_ASSERT(reader.next(record) && record.frames.size() == 1 && record.frames[0].size() == 0,
+                "Empty frame");
+    TEST_ASSERT(!reader.next(record) && !reader.truncated(), "Clean end of recording");
+    
+    reader.rewind();
+    TEST_ASSERT(reader.next(record) && record.timestamp == 1000, "Rewind starts over");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_append_and_truncation() {
+    std::cout << "Testing: Appending and incomplete records..." << std::endl;
+    
+    // Cut the last record short, as a crash during a write would
+    fs::resize_file(kRecordingPath, fs::file_size(kRecordingPath) - 4);
+    
+    TapReader reader;
+    TapRecord record;
+    TEST_ASSERT(reader.open(kRecordingPath), "Reader should open");
+    TEST_ASSERT(reader.next(record) && reader.next(record), "Complete records are read");
+    TEST_ASSERT(!reader.next(record) && reader.truncated(), "Incomplete record is reported");
+    
+    // Appending drops the incomplete record instead of hiding new ones behind it
+    std::vector<uint8_t> more(5, 0x42);
+    {
+        TapWriter writer;
+        TEST_ASSERT(writer.open(kRecordingPath) && writer.recordCount() == 2,
+                    "Writer should find the complete records");
+        TapFrame frame[] = {{more.data(), more.size()}};
+        TEST_ASSERT(writer.append(9000, frame, 1), "Append should succeed");
+    }
+    
+    TEST_ASSERT(reader.open(kRecordingPath), "Reader should reopen");
+    size_t count = 0;
+    uint64_t last = 0;
+    while (reader.next(record)) {
+        count++;
+        last = record.timestamp;
+    }
+    TEST_ASSERT(count == 3 && last == 9000 && !reader.truncated(), "Appended record follows");
+    TEST_ASSERT(frameEquals(record.frames[0], more), "Appended frame contents");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_invalid_recordings() {
+    std::cout << "Testing: Files that are not recordings..." << std::endl;
+    
+    {
+        std::ofstream file(kRecordingPath, std::ios::binary | std::ios::trunc);
+        file << "definitely not a recording";
+    }
+    TapReader reader;
+    TEST_ASSERT(!reader.open(kRecordingPath), "Wrong magic should be rejected");
+    
+    TapWriter writer;
+    TEST_ASSERT(!writer.open(kRecordingPath), "Writer must not append to other files");
+    TEST_ASSERT(fs::file_size(kRecordingPath) == 26, "Other files are left alone");
+    
+    std::remove(kRecordingPath.c_str());
+    TEST_ASSERT(!reader.open(kRecordingPath), "Missing recording should fail");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Pipeline Tap Unit Tests" << std::endl;
+    std::cout << "Author: Haobo (Brian) Liu" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    int passed = 0;
+    int total = 0;
+    
+    total++; if (test_record_and_read()) passed++;
+    total++; if (test_append_and_truncation()) passed++;
+    total++; if (test_invalid_recordings()) passed++;
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    return (passed == total) ? 0 : 1;
+}
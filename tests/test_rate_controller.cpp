@@ -0,0 +1,149 @@
+/**
+ * Unit Tests for the Rate Controller
+ * 
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "rate_controller.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace imaging;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+double millisecondsSince(RateController::Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(RateController::Clock::now() - start).count();
+}
+
+} // namespace
+
+bool test_frame_rate() {
+    std::cout << "Testing: Frame rate pacing..." << std::endl;
+    
+    RateController rate;
+    rate.setFrameRate(200.0);
+    TEST_ASSERT(rate.mode() == RateController::Mode::FRAMES_PER_SECOND, "Mode should be FPS");
+    
+    // The first frame goes out immediately, then one every 5 ms
+    auto start = RateController::Clock::now();
+    RateController::Clock::time_point first_due = rate.due();
+    TEST_ASSERT(first_due <= RateController::Clock::now(), "First frame should be due at once");
+    for (int i = 0; i < 21; ++i) {
+        rate.pace(1000);
+    }
+    double elapsed = millisecondsSince(start);
+    TEST_ASSERT(elapsed >= 99.0 && elapsed < 150.0, "20 intervals of 5 ms should take ~100 ms");
+    double until_due = -millisecondsSince(rate.due());
+    TEST_ASSERT(until_due > 0.0 && until_due <= 5.0, "Next frame should be due within 5 ms");
+    
+    RateController::Stats stats = rate.stats();
+    TEST_ASSERT(stats.frames == 21 && stats.bytes == 21000, "Frames and bytes should be counted");
+    TEST_ASSERT(stats.frames_per_second > 150.0 && stats.frames_per_second < 230.0,
+                "Achieved rate should be close to the target");
+    TEST_ASSERT(stats.resyncs == 0, "No resyncs expected");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_no_drift() {
+    std::cout << "Testing: Oversleep does not accumulate..." << std::endl;
+    
+    RateController rate;
+    rate.setFrameRate(100.0);
+    
+    // Work between frames eats into the wait instead of adding to it
+    auto start = RateController::Clock::now();
+    for (int i = 0; i < 21; ++i) {
+        rate.pace(0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(4));
+    }
+    double elapsed = millisecondsSince(start);
+    TEST_ASSERT(elapsed >= 200.0 && elapsed < 260.0, "Schedule should stay at 10 ms per frame");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_byte_rate() {
+    std::cout << "Testing: Byte rate pacing..." << std::endl;
+    
+    RateController rate;
+    rate.setByteRate(1000000.0);
+    
+    // 10 KB frames at 1 MB/s are 10 ms apart, 40 KB frames 40 ms
+    auto start = RateController::Clock::now();
+    rate.pace(10000);
+    rate.pace(40000);
+    rate.pace(10000);
+    double elapsed = millisecondsSince(start);
+    TEST_ASSERT(elapsed >= 49.0 && elapsed < 90.0, "Waits should follow the frame sizes");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_resync_and_unthrottled() {
+    std::cout << "Testing: Resync after a stall and unthrottled mode..." << std::endl;
+    
+    RateController rate;
+    rate.setFrameRate(100.0);
+    rate.pace(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    
+    // A stall longer than the backlog limit restarts the schedule instead of
+    // sending a burst of catch-up frames
+    rate.pace(0);
+    auto start = RateController::Clock::now();
+    rate.pace(0);
+    TEST_ASSERT(millisecondsSince(start) >= 9.0, "Frame after a resync should be paced");
+    
+    RateController::Stats stats = rate.stats();
+    TEST_ASSERT(stats.resyncs == 1, "Stall should cause one resync");
+    TEST_ASSERT(stats.max_lateness_us > 1000000.0, "Lateness should be reported");
+    
+    rate.resetStats();
+    rate.setUnthrottled();
+    start = RateController::Clock::now();
+    for (int i = 0; i < 1000; ++i) {
+        rate.pace(100);
+    }
+    TEST_ASSERT(millisecondsSince(start) < 50.0, "Unthrottled mode should not wait");
+    TEST_ASSERT(rate.stats().frames == 1000 && rate.stats().mean_lateness_us == 0.0,
+                "Unthrottled frames are counted without lateness");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Rate Controller Unit Tests" << std::endl;
+    std::cout << "Author: Haobo (Brian) Liu" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    int passed = 0;
+    int total = 0;
+    
+    total++; if (test_frame_rate()) passed++;
+    total++; if (test_no_drift()) passed++;
+    total++; if (test_byte_rate()) passed++;
+    total++; if (test_resync_and_unthrottled()) passed++;
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    return (passed == total) ? 0 : 1;
+}
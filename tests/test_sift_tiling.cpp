@@ -0,0 +1,224 @@
+/**
+ * Unit Tests for Tiled SIFT Extraction
+ *
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "sift_processor.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+using namespace imaging;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+const size_t kDescriptorSize = 128;
+
+// Blurred random blobs and boxes: plenty of features at several scales
+cv::Mat makeImage(int width, int height) {
+    cv::Mat image(height, width, CV_8UC1, cv::Scalar(96));
+    cv::RNG rng(12345);
+    int shapes = width * height / 4000;
+    for (int i = 0; i < shapes; ++i) {
+        cv::Point center(rng.uniform(0, width), rng.uniform(0, height));
+        int radius = rng.uniform(3, 30);
+        cv::Scalar color(rng.uniform(0, 256));
+        if (i % 3 == 0) {
+            cv::rectangle(image, cv::Rect(center.x, center.y, radius, radius * 2), color, cv::FILLED);
+        } else {
+            cv::circle(image, center, radius, color, cv::FILLED);
+        }
+    }
+    cv::GaussianBlur(image, image, cv::Size(0, 0), 1.5);
+    return image;
+}
+
+bool sameFeature(const KeyPoint& a, const KeyPoint& b, float radius) {
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    if (dx * dx + dy * dy >= radius * radius ||
+        std::fabs(a.size - b.size) > 0.25f * std::max(a.size, b.size)) {
+        return false;
+    }
+    float angle = std::fabs(a.angle - b.angle);
+    return std::min(angle, 360.0f - angle) < 10.0f;
+}
+
+float similarity(const float* a, const float* b) {
+    float dot = 0.0f;
+    float norm_a = 0.0f;
+    float norm_b = 0.0f;
+    for (size_t i = 0; i < kDescriptorSize; ++i) {
+        dot += a[i] * b[i];
+        norm_a += a[i] * a[i];
+        norm_b += b[i] * b[i];
+    }
+    return (norm_a > 0.0f && norm_b > 0.0f) ? dot / std::sqrt(norm_a * norm_b) : 0.0f;
+}
+
+// Fraction of features in a that have a counterpart in b at the same
+// position, scale and orientation with a similar descriptor
+double matchedFraction(const std::vector<KeyPoint>& a, const std::vector<float>& a_desc,
+                       const std::vector<KeyPoint>& b, const std::vector<float>& b_desc) {
+    if (a.empty()) {
+        return 0.0;
+    }
+    
+    std::vector<size_t> by_x(b.size());
+    std::iota(by_x.begin(), by_x.end(), 0);
+    std::sort(by_x.begin(), by_x.end(), [&](size_t i, size_t j) { return b[i].x < b[j].x; });
+    
+    size_t matched = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        auto it = std::lower_bound(by_x.begin(), by_x.end(), a[i].x - 1.0f,
+                                   [&](size_t j, float x) { return b[j].x < x; });
+        for (; it != by_x.end() && b[*it].x < a[i].x + 1.0f; ++it) {
+            if (sameFeature(a[i], b[*it], 1.0f) &&
+                similarity(&a_desc[i * kDescriptorSize], &b_desc[*it * kDescriptorSize]) > 0.9f) {
+                matched++;
+                break;
+            }
+        }
+    }
+    return static_cast<double>(matched) / a.size();
+}
+
+SiftTiling makeTiling(unsigned threads) {
+    SiftTiling tiling;
+    tiling.min_pixels = 1;
+    tiling.tile_size = 1024;
+    tiling.overlap = 128;
+    tiling.threads = threads;
+    return tiling;
+}
+
+} // namespace
+
+bool test_small_images_untiled() {
+    std::cout << "Testing: Images below the threshold are not tiled..." << std::endl;
+    
+    cv::Mat image = makeImage(640, 480);
+    SiftTiling tiling = makeTiling(4);
+    tiling.min_pixels = 640 * 480 + 1;
+    SIFTProcessor plain;
+    SIFTProcessor tiled(tiling);
+    
+    std::vector<KeyPoint> expected, keypoints;
+    std::vector<float> expected_desc, descriptors;
+    TEST_ASSERT(plain.extractFeatures(image, expected, expected_desc), "Extraction failed");
+    TEST_ASSERT(tiled.extractFeatures(image, keypoints, descriptors), "Extraction failed");
+    TEST_ASSERT(!expected.empty(), "Test image should have features");
+    TEST_ASSERT(keypoints.size() == expected.size() && descriptors == expected_desc,
+                "Untiled output should be identical");
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        TEST_ASSERT(keypoints[i].x == expected[i].x && keypoints[i].y == expected[i].y,
+                    "Keypoint mismatch");
+    }
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_tiled_matches_whole_image() {
+    std::cout << "Testing: Tiled features match the whole-image features..." << std::endl;
+    
+    cv::Mat image = makeImage(3000, 2000);
+    SIFTProcessor plain;
+    SIFTProcessor tiled(makeTiling(4));
+    
+    std::vector<KeyPoint> expected, keypoints;
+    std::vector<float> expected_desc, descriptors;
+    TEST_ASSERT(plain.extractFeatures(image, expected, expected_desc), "Extraction failed");
+    TEST_ASSERT(tiled.extractFeatures(image, keypoints, descriptors), "Tiled extraction failed");
+    TEST_ASSERT(descriptors.size() == keypoints.size() * kDescriptorSize,
+                "One descriptor per keypoint expected");
+    
+    // Tiles see less of the largest scales, so allow a small difference
+    double recall = matchedFraction(expected, expected_desc, keypoints, descriptors);
+    double precision = matchedFraction(keypoints, descriptors, expected, expected_desc);
+    std::cout << "  " << keypoints.size() << " tiled vs " << expected.size()
+              << " whole-image features, recall " << recall << ", precision " << precision
+              << std::endl;
+    TEST_ASSERT(recall > 0.85, "Most whole-image features should be found when tiled");
+    TEST_ASSERT(precision > 0.85, "Tiling should not invent features");
+    
+    for (const auto& keypoint : keypoints) {
+        TEST_ASSERT(keypoint.x >= 0 && keypoint.x < image.cols &&
+                    keypoint.y >= 0 && keypoint.y < image.rows,
+                    "Keypoints should be in global coordinates");
+    }
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_seams_and_threads() {
+    std::cout << "Testing: No seam duplicates, same result on any thread count..." << std::endl;
+    
+    cv::Mat image = makeImage(2500, 1500);
+    SIFTProcessor single(makeTiling(1));
+    SIFTProcessor parallel(makeTiling(8));
+    
+    std::vector<KeyPoint> serial_kps, keypoints;
+    std::vector<float> serial_desc, descriptors;
+    TEST_ASSERT(single.extractFeatures(image, serial_kps, serial_desc), "Extraction failed");
+    TEST_ASSERT(parallel.extractFeatures(image, keypoints, descriptors), "Extraction failed");
+    TEST_ASSERT(keypoints.size() == serial_kps.size() && descriptors == serial_desc,
+                "Thread count should not change the result");
+    
+    // A feature on a seam must be kept by one tile only, and the bands
+    // along the seams must not be left empty
+    size_t near_seams = 0;
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        float seam_x = std::round(keypoints[i].x / 1024.0f) * 1024.0f;
+        float seam_y = std::round(keypoints[i].y / 1024.0f) * 1024.0f;
+        bool near_x = seam_x > 0 && std::fabs(keypoints[i].x - seam_x) < 16.0f;
+        bool near_y = seam_y > 0 && std::fabs(keypoints[i].y - seam_y) < 16.0f;
+        if (!near_x && !near_y) {
+            continue;
+        }
+        near_seams++;
+        
+        for (size_t j = i + 1; j < keypoints.size(); ++j) {
+            bool crosses_x = near_x && ((keypoints[i].x < seam_x) != (keypoints[j].x < seam_x));
+            bool crosses_y = near_y && ((keypoints[i].y < seam_y) != (keypoints[j].y < seam_y));
+            TEST_ASSERT(!((crosses_x || crosses_y) && sameFeature(keypoints[i], keypoints[j], 2.0f)),
+                        "Feature kept on both sides of a seam");
+        }
+    }
+    TEST_ASSERT(near_seams > 0, "Features should be found along the seams");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Tiled SIFT Unit Tests" << std::endl;
+    std::cout << "Author: Haobo (Brian) Liu" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    int passed = 0;
+    int total = 0;
+    
+    total++; if (test_small_images_untiled()) passed++;
+    total++; if (test_tiled_matches_whole_image()) passed++;
+    total++; if (test_seams_and_threads()) passed++;
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    return (passed == total) ? 0 : 1;
+}
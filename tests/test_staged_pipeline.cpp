@@ -0,0 +1,279 @@
+/**
+ * Unit Tests for the Staged Pipeline and SPSC Queue
+ *
+ * Author: Haobo (Brian) Liu
+ * Email: h349liu@gmail.com
+ * Project: Distributed Imaging Services for Voyis Interview
+ */
+
+#include "staged_pipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace imaging;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+struct TestFrame {
+    int id;
+    int delay_ms;
+    std::string delay_stage;         // Only stage that sleeps; empty for all
+    bool ok;
+    std::vector<std::string> trace;  // Stages the frame went through
+    
+    TestFrame() : id(-1), delay_ms(0), ok(false) {}
+};
+
+using TestPipeline = StagedPipeline<TestFrame>;
+
+// Sleeps for the frame's delay (in its delay stage, or every stage) and
+// records the stage; frame 5 fails in the first stage and later stages
+// skip it
+TestPipeline::Stage makeStage(const std::string& name, unsigned threads) {
+    return {name, threads, [name]() {
+        return TestPipeline::Step([name](TestFrame& frame) {
+            if (name == "first" && frame.id == 5) {
+                frame.ok = false;
+            }
+            if (!frame.ok) {
+                return;
+            }
+            if (frame.delay_stage.empty() || frame.delay_stage == name) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(frame.delay_ms));
+            }
+            frame.trace.push_back(name);
+        });
+    }};
+}
+
+void resetFrame(TestFrame& frame, int id, int delay_ms) {
+    frame.id = id;
+    frame.delay_ms = delay_ms;
+    frame.delay_stage.clear();
+    frame.ok = true;
+    frame.trace.clear();
+}
+
+} // namespace
+
+bool test_spsc_queue() {
+    std::cout << "Testing: SPSC queue order, bounds and recycling..." << std::endl;
+    
+    SpscQueue<std::vector<int>> queue(3);
+    TEST_ASSERT(queue.capacity() == 4, "Capacity should round up to a power of two");
+    
+    std::vector<int> item;
+    for (int i = 0; i < 4; ++i) {
+        item.assign(1, i);
+        TEST_ASSERT(queue.tryPush(item), "Push should succeed while there is room");
+    }
+    item.assign(1, 99);
+    TEST_ASSERT(!queue.tryPush(item) && item[0] == 99, "Full queue should refuse and keep the item");
+    TEST_ASSERT(queue.size() == 4, "Size mismatch");
+    
+    // Popping hands the consumer's buffer back to a later push
+    std::vector<int> consumer(1000, 7);
+    const int* buffer = consumer.data();
+    TEST_ASSERT(queue.tryPop(consumer) && consumer == std::vector<int>{0}, "FIFO order expected");
+    item.clear();
+    TEST_ASSERT(queue.tryPush(item), "Push into freed slot should succeed");
+    std::vector<int> drained;
+    for (int expected = 1; expected < 4; ++expected) {
+        TEST_ASSERT(queue.tryPop(drained) && drained[0] == expected, "FIFO order expected");
+    }
+    TEST_ASSERT(item.data() == buffer, "Consumer buffer should come back to the producer");
+    TEST_ASSERT(queue.tryPop(drained) && !queue.tryPop(drained), "Queue should now be empty");
+    
+    // Concurrent producer and consumer keep every item in order
+    const int count = 200000;
+    SpscQueue<int> numbers(64);
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i) {
+            int value = i;
+            while (!numbers.tryPush(value)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    bool in_order = true;
+    for (int i = 0; i < count; ++i) {
+        int value = -1;
+        while (!numbers.tryPop(value)) {
+            std::this_thread::yield();
+        }
+        in_order = in_order && value == i;
+    }
+    producer.join();
+    TEST_ASSERT(in_order, "Items should arrive once each, in order");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_ordered_output() {
+    std::cout << "Testing: Frames leave in input order across stages..." << std::endl;
+    
+    TestPipeline pipeline({makeStage("first", 1), makeStage("second", 3), makeStage("third", 2)},
+                          2, true);
+    TEST_ASSERT(pipeline.threadCount() == 6, "Thread count mismatch");
+    
+    // Early frames take longest, so they would finish last
+    const int frames = 12;
+    std::thread producer([&]() {
+        TestFrame frame;
+        for (int i = 0; i < frames; ++i) {
+            resetFrame(frame, i, (frames - i) % 4 * 5);
+            while (!pipeline.submit(frame, std::chrono::milliseconds(100))) {
+            }
+        }
+    });
+    
+    bool ok = true;
+    TestFrame frame;
+    for (int i = 0; i < frames && ok; ++i) {
+        ok = pipeline.next(frame, std::chrono::milliseconds(1000)) && frame.id == i &&
+             frame.ok == (i != 5) &&
+             frame.trace == (i == 5 ? std::vector<std::string>{} :
+                             std::vector<std::string>{"first", "second", "third"});
+    }
+    producer.join();
+    TEST_ASSERT(ok, "Frames should be in order, pass every stage and carry failures");
+    TEST_ASSERT(!pipeline.next(frame, std::chrono::milliseconds(10)), "No more frames expected");
+    uint64_t expected = frames;
+    TEST_ASSERT(pipeline.processed(0) == expected && pipeline.processed(1) == expected &&
+                pipeline.processed(2) == expected, "Every stage should count every frame");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_unordered_output() {
+    std::cout << "Testing: Unordered frames overtake a slow one across stages..." << std::endl;
+    
+    // Frame 0 is slow in the middle stage only; unordered, the other middle
+    // threads keep the later frames moving past it
+    TestPipeline pipeline({makeStage("first", 1), makeStage("second", 3), makeStage("third", 1)},
+                          2, false);
+    const int frames = 12;
+    std::thread producer([&]() {
+        TestFrame frame;
+        for (int i = 0; i < frames; ++i) {
+            resetFrame(frame, i, i == 0 ? 300 : 1);
+            if (i == 0) {
+                frame.delay_stage = "second";
+            }
+            while (!pipeline.submit(frame, std::chrono::milliseconds(100))) {
+            }
+        }
+    });
+    
+    std::vector<int> order;
+    TestFrame frame;
+    while (static_cast<int>(order.size()) < frames &&
+           pipeline.next(frame, std::chrono::milliseconds(2000))) {
+        order.push_back(frame.id);
+    }
+    producer.join();
+    TEST_ASSERT(static_cast<int>(order.size()) == frames, "Every frame should come out");
+    
+    // While one middle thread holds the slow frame, the others take the rest
+    size_t slow_position = std::find(order.begin(), order.end(), 0) - order.begin();
+    TEST_ASSERT(slow_position >= 4, "Faster frames should overtake the slow one");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+bool test_overlap_and_backpressure() {
+    std::cout << "Testing: Stages overlap, full queues hold back submission..." << std::endl;
+    
+    // Three 20 ms stages: count the steps running at once, so overlap is
+    // seen directly rather than inferred from wall-clock time
+    {
+        std::atomic<int> active(0);
+        std::atomic<int> most_active(0);
+        auto overlapStage = [&](const std::string& name) {
+            return TestPipeline::Stage{name, 1, [&]() {
+                return TestPipeline::Step([&](TestFrame& frame) {
+                    int now = ++active;
+                    int seen = most_active.load();
+                    while (now > seen && !most_active.compare_exchange_weak(seen, now)) {
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(frame.delay_ms));
+                    --active;
+                });
+            }};
+        };
+        TestPipeline pipeline({overlapStage("a"), overlapStage("b"), overlapStage("c")}, 1, true);
+        std::thread producer([&]() {
+            TestFrame frame;
+            for (int i = 0; i < 10; ++i) {
+                resetFrame(frame, i, 20);
+                while (!pipeline.submit(frame, std::chrono::milliseconds(100))) {
+                }
+            }
+        });
+        TestFrame frame;
+        int received = 0;
+        while (received < 10 && pipeline.next(frame, std::chrono::milliseconds(5000))) {
+            received++;
+        }
+        producer.join();
+        TEST_ASSERT(received == 10, "Every frame should come out");
+        TEST_ASSERT(most_active.load() >= 2, "Stages should work on different frames at once");
+    }
+    
+    // One queue slot on each side of a single thread: three frames fit
+    TestPipeline pipeline({makeStage("a", 1)}, 1, true);
+    TestFrame frame;
+    for (int i = 0; i < 3; ++i) {
+        resetFrame(frame, i, 0);
+        TEST_ASSERT(pipeline.submit(frame, std::chrono::milliseconds(100)), "Submit should succeed");
+    }
+    resetFrame(frame, 3, 0);
+    TEST_ASSERT(!pipeline.submit(frame, std::chrono::milliseconds(50)), "Full pipeline should time out");
+    TEST_ASSERT(frame.id == 3, "Refused frame should be left intact");
+    
+    TestFrame out;
+    TEST_ASSERT(pipeline.next(out, std::chrono::milliseconds(100)) && out.id == 0, "Frame expected");
+    TEST_ASSERT(pipeline.submit(frame, std::chrono::milliseconds(100)), "Room after collecting");
+    
+    // Stopping refuses further work
+    pipeline.stop();
+    resetFrame(frame, 4, 0);
+    TEST_ASSERT(!pipeline.submit(frame, std::chrono::milliseconds(10)), "Stopped pipeline refuses work");
+    
+    std::cout << "  ✓ PASSED" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Staged Pipeline Unit Tests" << std::endl;
+    std::cout << "Author: Haobo (Brian) Liu" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    int passed = 0;
+    int total = 0;
+    
+    total++; if (test_spsc_queue()) passed++;
+    total++; if (test_ordered_output()) passed++;
+    total++; if (test_unordered_output()) passed++;
+    total++; if (test_overlap_and_backpressure()) passed++;
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "Results: " << passed << "/" << total << " tests passed" << std::endl;
+    std::cout << "======================================\n" << std::endl;
+    
+    return (passed == total) ? 0 : 1;
+}